@@ -1,5 +1,6 @@
 #version 460
 #extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_EXT_buffer_reference : enable
 
 layout(location = 0) in vec3 inWorldPos;
 layout(location = 1) in vec3 inNormal;
@@ -35,7 +36,7 @@ struct SceneData {
   vec4 cameraPos;
   vec2 jitter;
   int lightCount;
-  int irradianceIndex;
+  int iblEnabled;
   int prefilteredIndex;
   int brdfLutIndex;
   int shadowMapIndex;
@@ -53,6 +54,17 @@ struct SceneData {
   float nearClip, farClip;
   float screenWidth, screenHeight;
   float iblIntensity;
+  vec4 irradianceSH[9];
+  int probeBufferIndex;
+  int probeCount;
+  int probeAtlasIndex;
+  int probeCapture;
+};
+
+struct ReflectionProbe {
+  vec4 position; // w = cube index in the atlas
+  vec4 boxMin;   // w = blend distance
+  vec4 boxMax;
 };
 
 struct ClusterGrid {
@@ -79,10 +91,6 @@ struct Material {
 // Bindless Set #0
 layout(set = 0, binding = 0) uniform sampler2D textures[];
 layout(set = 0, binding = 12) uniform samplerCube skyboxes[];
-layout(set = 0, binding = 1) readonly buffer SceneDataBuffer {
-  SceneData scene;
-}
-allSceneBuffers[];
 layout(set = 0, binding = 9) readonly buffer ClusterGridBuffer {
   ClusterGrid grids[];
 }
@@ -91,19 +99,33 @@ layout(set = 0, binding = 10) readonly buffer LightIndexBuffer {
   uint indices[];
 }
 allLightIndexBuffers[];
-layout(set = 0, binding = 2) readonly buffer MaterialBuffer {
-  Material materials[];
-}
-allMaterialBuffers[];
-layout(set = 0, binding = 3) readonly buffer LightBuffer { Light lights[]; }
-allLightBuffers[];
 layout(set = 0, binding = 4) uniform sampler2DArray arrayTextures[];
+layout(set = 0, binding = 1) readonly buffer ProbeBuffer {
+  ReflectionProbe probes[];
+}
+allProbeBuffers[];
+layout(set = 0, binding = 14) uniform samplerCubeArray cubeArrays[];
 
+// Scene, material and light data are reached through pointers in the push
+// constants rather than bindless descriptor indices
+layout(buffer_reference, std430,
+       buffer_reference_align = 16) readonly buffer SceneBuffer {
+  SceneData scene;
+};
+layout(buffer_reference, std430,
+       buffer_reference_align = 16) readonly buffer MaterialBuffer {
+  Material materials[];
+};
+layout(buffer_reference, std430,
+       buffer_reference_align = 16) readonly buffer LightBuffer {
+  Light lights[];
+};
+
+// DrawPushConstants in renderer_system.cpp; instances are read by pbr.vert
 layout(push_constant) uniform PushConstants {
-  uint sceneDataIndex;
-  uint instanceBufferIndex;
-  uint materialBufferIndex;
-  uint padding;
+  SceneBuffer sceneBuffer;
+  layout(offset = 16) MaterialBuffer materialBuffer;
+  LightBuffer lightBuffer;
 }
 pc;
 
@@ -149,9 +171,67 @@ vec3 fresnelSchlickRoughness(float cosTheta, vec3 F0, float roughness) {
                   pow(clamp(1.0 - cosTheta, 0.0, 1.0), 5.0);
 }
 
+// Diffuse irradiance / PI from the environment's L2 SH coefficients; the
+// cosine convolution is already folded into them
+vec3 evaluateIrradianceSH(vec4 sh[9], vec3 n) {
+  vec3 e = sh[0].rgb * 0.282095 +
+           sh[1].rgb * 0.488603 * n.y +
+           sh[2].rgb * 0.488603 * n.z +
+           sh[3].rgb * 0.488603 * n.x +
+           sh[4].rgb * 1.092548 * n.x * n.y +
+           sh[5].rgb * 1.092548 * n.y * n.z +
+           sh[6].rgb * 0.315392 * (3.0 * n.z * n.z - 1.0) +
+           sh[7].rgb * 1.092548 * n.x * n.z +
+           sh[8].rgb * 0.546274 * (n.x * n.x - n.y * n.y);
+  return max(e, vec3(0.0));
+}
+
+// Specular environment along R: the innermost local probe box containing the
+// point, parallax corrected against the box, faded into the global map near
+// the box faces
+vec3 sampleReflection(SceneData scene, vec3 R, float lod) {
+  vec3 color =
+      textureLod(skyboxes[nonuniformEXT(scene.prefilteredIndex)], R, lod).rgb;
+  if (scene.probeCount == 0) {
+    return color;
+  }
+
+  int best = -1;
+  float bestWeight = 0.0;
+  for (int i = 0; i < scene.probeCount; ++i) {
+    ReflectionProbe probe =
+        allProbeBuffers[nonuniformEXT(scene.probeBufferIndex)].probes[i];
+    vec3 inside = min(inWorldPos - probe.boxMin.xyz,
+                      probe.boxMax.xyz - inWorldPos);
+    float edge = min(inside.x, min(inside.y, inside.z));
+    float weight = clamp(edge / max(probe.boxMin.w, 0.0001), 0.0, 1.0);
+    if (weight > bestWeight) {
+      best = i;
+      bestWeight = weight;
+    }
+  }
+  if (best < 0) {
+    return color;
+  }
+
+  ReflectionProbe probe =
+      allProbeBuffers[nonuniformEXT(scene.probeBufferIndex)].probes[best];
+  // Intersect R with the box and look up the hit point from the capture
+  // origin
+  vec3 toMax = (probe.boxMax.xyz - inWorldPos) / R;
+  vec3 toMin = (probe.boxMin.xyz - inWorldPos) / R;
+  vec3 furthest = max(toMax, toMin);
+  float distance = min(furthest.x, min(furthest.y, furthest.z));
+  vec3 dir = inWorldPos + R * distance - probe.position.xyz;
+
+  vec3 local = textureLod(cubeArrays[nonuniformEXT(scene.probeAtlasIndex)],
+                          vec4(dir, probe.position.w), lod)
+                   .rgb;
+  return mix(color, local, bestWeight);
+}
+
 vec3 getNormalFromMap() {
-  Material mat =
-      allMaterialBuffers[pc.materialBufferIndex].materials[inMaterialIndex];
+  Material mat = pc.materialBuffer.materials[inMaterialIndex];
   if (mat.normalTextureIndex == -1) {
     return normalize(inNormal);
   }
@@ -171,7 +251,7 @@ vec3 getNormalFromMap() {
 }
 
 float calculateShadow(vec3 worldPos, vec3 normal, vec3 lightPos) {
-  SceneData scene = allSceneBuffers[pc.sceneDataIndex].scene;
+  SceneData scene = pc.sceneBuffer.scene;
   if (scene.shadowMapIndex == -1)
     return 0.0;
 
@@ -235,9 +315,8 @@ float calculateShadow(vec3 worldPos, vec3 normal, vec3 lightPos) {
 void main() {
   // DEBUG CHECK REMOVED - RESTORING PBR LOGIC
 
-  Material mat =
-      allMaterialBuffers[pc.materialBufferIndex].materials[inMaterialIndex];
-  SceneData scene = allSceneBuffers[pc.sceneDataIndex].scene;
+  Material mat = pc.materialBuffer.materials[inMaterialIndex];
+  SceneData scene = pc.sceneBuffer.scene;
 
   vec3 baseColor = mat.baseColorFactor.rgb;
   if (mat.baseColorTextureIndex != -1) {
@@ -264,40 +343,48 @@ void main() {
 
   vec3 lo = vec3(0.0);
 
-  // Clustered Lighting
-  vec4 viewPos = scene.view * vec4(inWorldPos, 1.0);
-  float zDepth = abs(viewPos.z);
+  // Clustered Lighting. The clusters are built for the main camera, so probe
+  // faces walk every light instead.
+  bool clustered = scene.probeCapture == 0;
+  ClusterGrid grid = ClusterGrid(0u, uint(scene.lightCount));
+  if (clustered) {
+    vec4 viewPos = scene.view * vec4(inWorldPos, 1.0);
+    float zDepth = abs(viewPos.z);
 
-  // Logarithmic slicing with safety check
-  uint zSlice = 0;
-  if (zDepth > scene.nearClip) {
-    zSlice = uint(log(zDepth / scene.nearClip) * float(scene.gridZ) /
-                  log(scene.farClip / scene.nearClip));
-  }
-  zSlice = min(zSlice, uint(scene.gridZ - 1));
+    // Logarithmic slicing with safety check
+    uint zSlice = 0;
+    if (zDepth > scene.nearClip) {
+      zSlice = uint(log(zDepth / scene.nearClip) * float(scene.gridZ) /
+                    log(scene.farClip / scene.nearClip));
+    }
+    zSlice = min(zSlice, uint(scene.gridZ - 1));
 
-  // Proper screen to cluster grid mapping
-  uint xSlice = uint(gl_FragCoord.x / (scene.screenWidth / float(scene.gridX)));
-  uint ySlice =
-      uint(gl_FragCoord.y / (scene.screenHeight / float(scene.gridY)));
+    // Proper screen to cluster grid mapping
+    uint xSlice =
+        uint(gl_FragCoord.x / (scene.screenWidth / float(scene.gridX)));
+    uint ySlice =
+        uint(gl_FragCoord.y / (scene.screenHeight / float(scene.gridY)));
 
-  xSlice = min(xSlice, uint(scene.gridX - 1));
-  ySlice = min(ySlice, uint(scene.gridY - 1));
+    xSlice = min(xSlice, uint(scene.gridX - 1));
+    ySlice = min(ySlice, uint(scene.gridY - 1));
 
-  uint clusterIdx =
-      xSlice + (ySlice * scene.gridX) + (zSlice * scene.gridX * scene.gridY);
-  clusterIdx =
-      min(clusterIdx, uint(scene.gridX * scene.gridY * scene.gridZ - 1));
+    uint clusterIdx =
+        xSlice + (ySlice * scene.gridX) + (zSlice * scene.gridX * scene.gridY);
+    clusterIdx =
+        min(clusterIdx, uint(scene.gridX * scene.gridY * scene.gridZ - 1));
 
-  ClusterGrid grid =
-      allClusterGridBuffers[nonuniformEXT(scene.clusterGridBufferIndex)]
-          .grids[clusterIdx];
+    grid = allClusterGridBuffers[nonuniformEXT(scene.clusterGridBufferIndex)]
+               .grids[clusterIdx];
+  }
 
   for (uint i = 0; i < grid.count; i++) {
-    uint lightIdx =
-        allLightIndexBuffers[nonuniformEXT(scene.clusterLightIndexBufferIndex)]
-            .indices[grid.offset + i];
-    Light light = allLightBuffers[scene.lightBufferIndex].lights[lightIdx];
+    uint lightIdx = i;
+    if (clustered) {
+      lightIdx = allLightIndexBuffers[nonuniformEXT(
+                                          scene.clusterLightIndexBufferIndex)]
+                     .indices[grid.offset + i];
+    }
+    Light light = pc.lightBuffer.lights[lightIdx];
 
     vec3 L;
     float attenuation = 1.0;
@@ -367,20 +454,17 @@ void main() {
 
   // Ambient / IBL
   vec3 ambient = vec3(0.03) * baseColor;
-  if (scene.irradianceIndex != -1) {
+  if (scene.iblEnabled != 0) {
     vec3 F_ibl = fresnelSchlickRoughness(max(dot(N, V), 0.0), F0, roughness);
     vec3 kS_ibl = F_ibl;
     vec3 kD_ibl = (vec3(1.0) - kS_ibl) * (1.0 - metallic);
 
-    vec3 irradiance =
-        texture(skyboxes[nonuniformEXT(scene.irradianceIndex)], N).rgb;
+    vec3 irradiance = evaluateIrradianceSH(scene.irradianceSH, N);
     vec3 diffuse = irradiance * baseColor;
 
     const float MAX_REFLECTION_LOD = 4.0;
     vec3 prefilteredColor =
-        textureLod(skyboxes[nonuniformEXT(scene.prefilteredIndex)], R,
-                   roughness * MAX_REFLECTION_LOD)
-            .rgb;
+        sampleReflection(scene, R, roughness * MAX_REFLECTION_LOD);
     vec2 brdf = texture(textures[nonuniformEXT(scene.brdfLutIndex)],
                         vec2(max(dot(N, V), 0.0), roughness))
                     .rg;
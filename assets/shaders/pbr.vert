@@ -2,11 +2,13 @@
 #extension GL_EXT_nonuniform_qualifier : enable
 #extension GL_EXT_buffer_reference : enable
 
-layout(location = 0) in vec3 inPos;
-layout(location = 1) in vec3 inNormal;
+// Standard vertices feed float attributes (w defaults to 1.0). Packed
+// vertices feed unorm16 position (w = tangent sign), octahedral snorm16
+// normal/tangent and half float UVs; see PackedVertex in model.hpp.
+layout(location = 0) in vec4 inPos;
+layout(location = 1) in vec4 inNormal;
 layout(location = 2) in vec2 inUV;
 layout(location = 3) in vec4 inTangent;
-layout(location = 4) in vec4 inColor;
 
 layout(location = 0) out vec3 outWorldPos;
 layout(location = 1) out vec3 outNormal;
@@ -32,7 +34,7 @@ struct SceneData {
   vec4 cameraPos;
   vec2 jitter;
   int lightCount;
-  int irradianceIndex;
+  int iblEnabled;
   int prefilteredIndex;
   int brdfLutIndex;
   int shadowMapIndex;
@@ -56,6 +58,15 @@ struct MeshInstance {
   vec3 sphereCenter;
   float sphereRadius;
   uint materialIndex;
+  uint vertexFormat;
+  uint lodCount;
+  uint meshletCount;
+  vec4 positionOffset;
+  vec4 positionScale;
+  uvec4 lodFirstIndex;
+  uvec4 lodIndexCount;
+  vec4 lodError;
+  uint firstMeshlet;
   uint padding[3];
 };
 
@@ -73,47 +84,61 @@ struct Material {
   float padding[3];
 };
 
-layout(std430, set = 0, binding = 1) readonly buffer SceneBuffer {
+// Reached through pointers in the push constants rather than bindless
+// descriptor indices
+layout(buffer_reference, std430,
+       buffer_reference_align = 16) readonly buffer SceneBuffer {
   SceneData scene;
-}
-allSceneBuffers[];
-
-layout(std430, set = 0, binding = 6) readonly buffer InstanceBuffer {
+};
+layout(buffer_reference, std430,
+       buffer_reference_align = 16) readonly buffer InstanceBuffer {
   MeshInstance instances[];
-}
-allInstanceBuffers[];
-
-layout(std430, set = 0, binding = 2) readonly buffer MaterialBuffer {
-  Material materials[];
-}
-allMaterialBuffers[];
+};
 
+// Leading members of DrawPushConstants in renderer_system.cpp
 layout(push_constant) uniform PushConstants {
-  uint sceneDataIndex;
-  uint instanceBufferIndex;
-  uint materialBufferIndex;
+  SceneBuffer sceneBuffer;
+  InstanceBuffer instanceBuffer;
 }
 pc;
 
+const uint VERTEX_FORMAT_PACKED = 1;
+
+vec3 octDecode(vec2 e) {
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-n.z, 0.0);
+  n.x += n.x >= 0.0 ? -t : t;
+  n.y += n.y >= 0.0 ? -t : t;
+  return normalize(n);
+}
+
 // ... (buffer definitions)
 void main() {
-  SceneData scene = allSceneBuffers[pc.sceneDataIndex].scene;
+  SceneData scene = pc.sceneBuffer.scene;
 
   // STEP 2 RESTORATION: Use Instance Buffer
-  MeshInstance instance =
-      allInstanceBuffers[pc.instanceBufferIndex].instances[gl_InstanceIndex];
+  MeshInstance instance = pc.instanceBuffer.instances[gl_InstanceIndex];
   mat4 modelMatrix = instance.transform;
   uint matIdx = instance.materialIndex;
 
-  vec4 worldPos = modelMatrix * vec4(inPos, 1.0);
+  vec3 position = inPos.xyz;
+  vec3 normal = inNormal.xyz;
+  vec4 tangent = inTangent;
+  if (instance.vertexFormat == VERTEX_FORMAT_PACKED) {
+    position = instance.positionOffset.xyz + inPos.xyz * instance.positionScale.xyz;
+    normal = octDecode(inNormal.xy);
+    tangent = vec4(octDecode(inTangent.xy), inPos.w > 0.5 ? 1.0 : -1.0);
+  }
+
+  vec4 worldPos = modelMatrix * vec4(position, 1.0);
   outWorldPos = worldPos.xyz;
 
   mat3 normalMatrix = mat3(modelMatrix);
-  outNormal = normalize(normalMatrix * inNormal);
-  outTangent = vec4(normalize(normalMatrix * inTangent.xyz), inTangent.w);
+  outNormal = normalize(normalMatrix * normal);
+  outTangent = vec4(normalize(normalMatrix * tangent.xyz), tangent.w);
 
   outUV = inUV;
-  outColor = inColor;
+  outColor = vec4(1.0);
   outMaterialIndex = matIdx; // instance.materialIndex;
 
   gl_Position = scene.viewProj * worldPos;
@@ -1,11 +1,11 @@
 #version 460
 #extension GL_EXT_nonuniform_qualifier : enable
+#extension GL_EXT_buffer_reference : enable
 
-layout(location = 0) in vec3 inPos;
+layout(location = 0) in vec4 inPos; // Packed vertices: unorm16 relative to bounds
 // layout(location = 1) in vec3 inNormal;
 // layout(location = 2) in vec2 inUV;
 // layout(location = 3) in vec4 inTangent;
-// layout(location = 4) in vec4 inColor;
 
 struct SceneData {
     mat4 view;
@@ -21,7 +21,7 @@ struct SceneData {
     vec4 cameraPos;
     vec2 jitter;
     int lightCount;
-    int irradianceIndex;
+    int iblEnabled;
     int prefilteredIndex;
     int brdfLutIndex;
     int shadowMapIndex;
@@ -45,34 +45,47 @@ struct MeshInstance {
     vec3 sphereCenter;
     float sphereRadius;
     uint materialIndex;
+    uint vertexFormat;
+    uint lodCount;
+    uint meshletCount;
+    vec4 positionOffset;
+    vec4 positionScale;
+    uvec4 lodFirstIndex;
+    uvec4 lodIndexCount;
+    vec4 lodError;
+    uint firstMeshlet;
     uint padding[3];
 };
 
-// Bindless Set #0
-layout(std430, set = 0, binding = 1) readonly buffer SceneDataBuffer {
+// Reached through pointers in the push constants
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer SceneBuffer {
     SceneData scene;
-} allSceneBuffers[];
+};
 
-layout(std430, set = 0, binding = 6) readonly buffer InstanceBuffer {
+layout(buffer_reference, std430, buffer_reference_align = 16) readonly buffer InstanceBuffer {
     MeshInstance instances[];
-} allInstanceBuffers[];
+};
 
-// Push Constants
+// DrawPushConstants in renderer_system.cpp; materials and lights are unused
 layout(push_constant) uniform PushConstants {
-    uint sceneDataIndex;
-    uint instanceBufferIndex;
-    uint materialBufferIndex;
-    uint cascadeIndex; 
+    SceneBuffer sceneBuffer;
+    InstanceBuffer instanceBuffer;
+    layout(offset = 32) uint cascadeIndex;
 } pc;
 
 void main() {
-    SceneData scene = allSceneBuffers[pc.sceneDataIndex].scene;
-    MeshInstance instance = allInstanceBuffers[pc.instanceBufferIndex].instances[gl_InstanceIndex];
+    SceneData scene = pc.sceneBuffer.scene;
+    MeshInstance instance = pc.instanceBuffer.instances[gl_InstanceIndex];
     
     mat4 shadowMatrix = scene.lightSpaceMatrix;
     if (pc.cascadeIndex < 4) {
         shadowMatrix = scene.cascadeViewProj[pc.cascadeIndex];
     }
     
-    gl_Position = shadowMatrix * instance.transform * vec4(inPos, 1.0);
+    vec3 position = inPos.xyz;
+    if (instance.vertexFormat == 1) { // VertexFormat::Packed
+        position = instance.positionOffset.xyz + inPos.xyz * instance.positionScale.xyz;
+    }
+
+    gl_Position = shadowMatrix * instance.transform * vec4(position, 1.0);
 }
@@ -17,7 +17,7 @@ struct SceneData {
     vec4 cameraPos;
     vec2 jitter;
     int lightCount;
-    int irradianceIndex;
+    int iblEnabled;
     int prefilteredIndex;
     int brdfLutIndex;
     int shadowMapIndex;
@@ -25,7 +25,7 @@ struct SceneData {
   vec4 cascadeSplits;
   vec4 cameraPos;
   int lightCount;
-  int irradianceIndex;
+  int iblEnabled;
   int prefilteredIndex;
   int brdfLutIndex;
   int shadowMapIndex;
@@ -14,6 +14,7 @@
 #include "astral/renderer/ui_manager.hpp"
 
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace astral {
@@ -54,8 +55,12 @@ private:
 
   // Scene
   Camera m_camera;
-  std::shared_ptr<Model> m_model;
+  std::shared_ptr<ModelLoadHandle> m_modelLoad;
   RendererSystem::UIParams m_uiParams;
+  std::vector<std::string> m_environmentPaths; // HDRs offered in the UI
+  int m_selectedEnvironment = 0;
+  float m_probeHalfExtent = 2.0f; // Box of probes added from the UI
+  uint32_t m_lastSkyboxIndex = (uint32_t)-1; // Probes re-capture on change
 
   // State
   uint32_t m_currentFrame = 0;
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "astral/core/mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace astral {
+
+class ThreadPool;
+
+// Per-entry compression. Value 2 is reserved for zstd.
+enum class ArchiveCompression : uint32_t {
+    None = 0,
+    LZ4 = 1
+};
+
+// Table of contents record, stored as-is in the archive
+struct ArchiveEntry {
+    uint64_t pathHash;    // hashString of the normalized path, TOC is sorted by it
+    uint64_t offset;      // Start of the stored bytes, a multiple of the archive alignment
+    uint64_t storedSize;  // Bytes in the archive
+    uint64_t size;        // Bytes after decompression
+    uint64_t contentHash; // hashBytes of the decompressed bytes
+    uint32_t nameOffset;  // Into the name table that follows the TOC
+    uint32_t nameLength;
+    ArchiveCompression compression;
+    uint32_t padding;
+};
+
+// Read-only packed asset archive: one file with a sorted table of contents
+// at the end and each entry stored uncompressed or LZ4 compressed.
+//
+// The file is memory mapped, so lookups and reads never open files and all
+// const members can be called from any number of threads at once.
+// Uncompressed entries can be used in place through getStoredData(); every
+// entry can be decompressed straight into caller memory such as a mapped
+// staging buffer with readInto().
+class AssetArchive {
+public:
+    // Throws std::runtime_error if the file cannot be mapped or is malformed
+    explicit AssetArchive(const std::filesystem::path& path);
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    // Paths use '/' separators and are relative to the packed directory
+    const ArchiveEntry* find(std::string_view path) const;
+    std::string_view getName(const ArchiveEntry& entry) const;
+
+    const ArchiveEntry* begin() const { return m_entries; }
+    const ArchiveEntry* end() const { return m_entries + m_entryCount; }
+    size_t size() const { return m_entryCount; }
+
+    // Bytes as stored in the archive (compressed for LZ4 entries)
+    const std::byte* getStoredData(const ArchiveEntry& entry) const;
+
+    // Decompresses the entry into destination, which must hold entry.size
+    // bytes. Throws std::runtime_error on corrupt data.
+    void readInto(const ArchiveEntry& entry, void* destination) const;
+    std::vector<std::byte> read(const ArchiveEntry& entry) const;
+
+    // Reads several entries concurrently on the pool (serially without one)
+    std::vector<std::vector<std::byte>> readAll(const std::vector<const ArchiveEntry*>& entries,
+                                                ThreadPool* pool) const;
+
+    const std::filesystem::path& getPath() const { return m_file.getPath(); }
+
+private:
+    MappedFile m_file;
+    const ArchiveEntry* m_entries = nullptr;
+    size_t m_entryCount = 0;
+    const char* m_names = nullptr;
+    size_t m_namesSize = 0;
+};
+
+// Builds an archive in memory and writes it in one go. Used by the
+// astral_pack tool.
+class AssetArchiveWriter {
+public:
+    // alignment: power of two that every entry offset is rounded up to
+    explicit AssetArchiveWriter(uint32_t alignment = 16);
+
+    // LZ4 entries that do not shrink by at least 1/16 are stored uncompressed
+    void add(std::string path, std::vector<std::byte> data, ArchiveCompression compression);
+
+    // Compresses the entries (in parallel on the pool, if given) and writes
+    // the archive. Throws std::runtime_error on I/O errors.
+    void write(const std::filesystem::path& path, ThreadPool* pool = nullptr);
+
+    size_t size() const { return m_pending.size(); }
+
+private:
+    struct PendingEntry {
+        std::string path;
+        std::vector<std::byte> data;
+        ArchiveCompression compression;
+    };
+
+    uint32_t m_alignment;
+    std::vector<PendingEntry> m_pending;
+};
+
+// "a\\b/./c" -> "a/b/c"; the form archive paths are stored and looked up in
+std::string normalizeArchivePath(std::string_view path);
+
+} // namespace astral
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "astral/core/asset_archive.hpp"
+#include "astral/core/mapped_file.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace astral {
+
+// Makes asset loads under root (e.g. "assets" for an archive packed from
+// assets/) read from archive before falling back to loose files. Call once
+// at startup, before any asset is loaded; mounting is not synchronized
+// with loads on other threads.
+void mountAssetArchive(std::shared_ptr<const AssetArchive> archive, const std::filesystem::path& root);
+
+// Read-only bytes of one asset: the entry of the mounted archive with the
+// same path, or else a mapping of the loose file. Uncompressed entries are
+// used in place in the archive mapping, compressed ones are decompressed
+// into the heap once.
+class AssetFile {
+public:
+    // Throws std::runtime_error if neither the archive nor the file system
+    // has the path
+    explicit AssetFile(const std::filesystem::path& path);
+
+    AssetFile(const AssetFile&) = delete;
+    AssetFile& operator=(const AssetFile&) = delete;
+
+    static bool exists(const std::filesystem::path& path);
+
+    // Forwarded to the loose file mapping; a no-op for archive entries
+    void advise(MappedFile::Access access, size_t offset = 0, size_t size = SIZE_MAX) const;
+
+    const std::byte* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::filesystem::path& getPath() const { return m_path; }
+    bool isArchived() const { return m_archive != nullptr; }
+
+private:
+    std::filesystem::path m_path;
+    std::shared_ptr<const AssetArchive> m_archive; // Keeps in place entries mapped
+    std::vector<std::byte> m_decompressed;
+    std::unique_ptr<MappedFile> m_file;
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+// Whole asset as a string, e.g. shader source or SPIR-V. Throws
+// std::runtime_error if it cannot be read.
+std::string readAssetFile(const std::filesystem::path& path);
+
+} // namespace astral
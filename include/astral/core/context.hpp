@@ -8,8 +8,15 @@
 
 namespace astral {
 
+// Frames the CPU may record ahead of the GPU. Per-frame resources are sized
+// by it, and resources a frame may still use are destroyed or recycled only
+// after this many frames.
+constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
+
 class Window; // Forward declaration
 class DescriptorManager;
+class UploadManager;
+class SamplerCache;
 
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
@@ -36,10 +43,21 @@ public:
     QueueFamilyIndices getQueueFamilyIndices() const { return m_indices; }
     VkQueue getGraphicsQueue() const { return m_graphicsQueue; }
     VkQueue getPresentQueue() const { return m_presentQueue; }
+    VkQueue getComputeQueue() const { return m_computeQueue; }
+    VkQueue getTransferQueue() const { return m_transferQueue; }
+    // A second queue of the graphics family, so long running compute work
+    // overlaps the frame without ownership transfers. The graphics queue when
+    // the family has only one.
+    VkQueue getAsyncComputeQueue() const { return m_asyncComputeQueue; }
 
     DescriptorManager& getDescriptorManager() { return *m_descriptorManager; }
+    UploadManager& getUploadManager() { return *m_uploadManager; }
+    SamplerCache& getSamplerCache() { return *m_samplerCache; }
     Window& getWindow() { return *m_window; }
 
+    // VK_EXT_descriptor_buffer, enabled when the device supports it
+    bool hasDescriptorBuffer() const { return m_descriptorBuffer; }
+
 private:
     void createInstance(const std::vector<const char*>& requiredExtensions);
     void setupDebugMessenger();
@@ -49,6 +67,7 @@ private:
     void createAllocator();
 
     bool isDeviceSuitable(VkPhysicalDevice device);
+    bool supportsExtension(VkPhysicalDevice device, const char* name);
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
 
     Window* m_window;
@@ -63,10 +82,14 @@ private:
     VkQueue m_presentQueue;
     VkQueue m_computeQueue;
     VkQueue m_transferQueue;
+    VkQueue m_asyncComputeQueue;
 
     QueueFamilyIndices m_indices;
+    bool m_descriptorBuffer = false;
 
     std::unique_ptr<DescriptorManager> m_descriptorManager;
+    std::unique_ptr<UploadManager> m_uploadManager;
+    std::unique_ptr<SamplerCache> m_samplerCache;
 
     const std::vector<const char*> m_validationLayers = {
         "VK_LAYER_KHRONOS_validation"
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace astral {
+
+// FNV-1a (64-bit) over 8-byte words. Not cryptographic; used for content keys
+// (asset caches, deduplication), so it only needs to be fast and well mixed.
+constexpr uint64_t HASH_SEED = 14695981039346656037ull;
+constexpr uint64_t HASH_PRIME = 1099511628211ull;
+
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t seed = HASH_SEED) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * HASH_PRIME;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * HASH_PRIME;
+    }
+
+    // Final avalanche so that short keys still spread over all bits
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+inline uint64_t hashString(std::string_view str, uint64_t seed = HASH_SEED) {
+    return hashBytes(str.data(), str.size(), seed);
+}
+
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
+
+} // namespace astral
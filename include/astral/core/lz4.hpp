@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+
+namespace astral {
+
+// LZ4 block format codec (no frame header, no checksums). Streams written
+// by lz4Compress decode with the reference liblz4 LZ4_decompress_safe and
+// vice versa. Used for asset archive entries, where decode speed matters far
+// more than ratio.
+
+// Worst case compressed size for size input bytes
+size_t lz4CompressBound(size_t size);
+
+// Compresses source into destination. Returns the compressed size, or 0 if
+// it does not fit into capacity.
+size_t lz4Compress(const void* source, size_t sourceSize, void* destination, size_t capacity);
+
+// Decodes a complete block that must expand to exactly destinationSize
+// bytes. Returns false for malformed input; never reads or writes out of
+// bounds.
+bool lz4Decompress(const void* source, size_t sourceSize, void* destination, size_t destinationSize);
+
+} // namespace astral
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+namespace astral {
+
+// Read-only memory mapping of a whole file. Pages are faulted in from the
+// page cache on access, so large assets are never copied into the heap.
+class MappedFile {
+public:
+    enum class Access {
+        Normal,
+        Sequential, // Aggressive read-ahead, pages may be dropped soon after use
+        WillNeed,   // Start reading the range in now
+        DontNeed    // Range will not be touched again
+    };
+
+    // Throws std::runtime_error if the file cannot be opened or mapped
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Access pattern hint for a byte range (madvise); a no-op where unsupported
+    void advise(Access access, size_t offset = 0, size_t size = SIZE_MAX) const;
+
+    const std::byte* data() const { return m_data; }
+    size_t size() const { return m_size; }
+    const std::filesystem::path& getPath() const { return m_path; }
+
+private:
+    std::filesystem::path m_path;
+    const std::byte* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_file = nullptr;
+    void* m_mapping = nullptr;
+#endif
+};
+
+} // namespace astral
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "astral/core/context.hpp"
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+namespace astral {
+
+// Context-wide VkSampler deduplication. Samplers are looked up by the
+// contents of their create info and live until the cache is destroyed, so
+// callers never destroy the returned handles. Every model, pass and
+// environment bake that asks for the same filtering state shares one sampler,
+// which keeps the device well below maxSamplerAllocationCount.
+//
+// pNext chains are not part of the key and must be null. Thread-safe.
+class SamplerCache {
+public:
+    explicit SamplerCache(Context* context);
+    ~SamplerCache();
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+    // Returns the sampler for info, creating it on first use. maxAnisotropy
+    // is clamped to the device limit (and anisotropy disabled when the
+    // device does not support it) before the lookup.
+    VkSampler getSampler(const VkSamplerCreateInfo& info);
+
+    size_t size() const;
+
+private:
+    // Every VkSamplerCreateInfo field after pNext; all members are 32-bit,
+    // so the struct has no padding and can be hashed and compared bytewise
+    struct Key {
+        VkSamplerCreateFlags flags;
+        VkFilter magFilter;
+        VkFilter minFilter;
+        VkSamplerMipmapMode mipmapMode;
+        VkSamplerAddressMode addressModeU;
+        VkSamplerAddressMode addressModeV;
+        VkSamplerAddressMode addressModeW;
+        float mipLodBias;
+        VkBool32 anisotropyEnable;
+        float maxAnisotropy;
+        VkBool32 compareEnable;
+        VkCompareOp compareOp;
+        float minLod;
+        float maxLod;
+        VkBorderColor borderColor;
+        VkBool32 unnormalizedCoordinates;
+
+        bool operator==(const Key& other) const;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& key) const;
+    };
+
+    Context* m_context;
+    float m_maxAnisotropy = 1.0f; // 0 when samplerAnisotropy is unsupported
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<Key, VkSampler, KeyHash> m_samplers;
+};
+
+} // namespace astral
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "astral/core/context.hpp"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace astral {
+
+class Buffer;
+class Image;
+
+// Non-blocking staging uploads. Copies are recorded into a command buffer
+// and submitted as one batch with a fence; staging memory is kept alive until
+// the fence signals and completion callbacks then run from poll().
+//
+// Not thread-safe: record, submit and poll from the main thread only, at a
+// frame boundary. Worker threads hand their CPU data over to the main thread.
+class UploadManager {
+public:
+    explicit UploadManager(Context* context);
+    ~UploadManager();
+
+    UploadManager(const UploadManager&) = delete;
+    UploadManager& operator=(const UploadManager&) = delete;
+
+    void uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size);
+
+    // Uploads mip 0 of every layer and leaves the image in SHADER_READ_ONLY_OPTIMAL
+    void uploadImage(Image& image, const void* data, VkDeviceSize size);
+
+    // Uploads levelCount mips starting at firstLevel, packed finest first with
+    // every layer of a level together, and leaves just those levels in
+    // SHADER_READ_ONLY_OPTIMAL. Other levels may be sampled meanwhile.
+    // Uncompressed formats only.
+    void uploadImageLevels(Image& image, uint32_t firstLevel, uint32_t levelCount, const void* data,
+                           VkDeviceSize size);
+
+    // Submits everything recorded since the last submit. onComplete runs from
+    // poll() once the GPU has finished the batch.
+    void submit(std::function<void()> onComplete = {});
+
+    // Retires finished batches. Returns the number of batches retired.
+    uint32_t poll();
+
+    // Submits pending work and blocks until every batch has retired
+    void waitIdle();
+
+    bool isIdle() const { return !m_recording && m_inFlight.empty(); }
+    VkDeviceSize getBytesInFlight() const { return m_bytesInFlight; }
+
+private:
+    struct Batch {
+        VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;
+        std::vector<std::unique_ptr<Buffer>> stagingBuffers;
+        std::vector<std::function<void()>> callbacks;
+        VkDeviceSize bytes = 0;
+    };
+
+    Batch& beginRecording();
+    Buffer& createStaging(const void* data, VkDeviceSize size);
+    void retire(Batch& batch);
+
+    Context* m_context;
+    VkQueue m_queue;
+    VkCommandPool m_pool;
+
+    std::unique_ptr<Batch> m_recording;
+    std::deque<std::unique_ptr<Batch>> m_inFlight;
+    std::vector<std::unique_ptr<Batch>> m_freeBatches;
+    VkDeviceSize m_bytesInFlight = 0;
+};
+
+} // namespace astral
@@ -2,40 +2,169 @@
 
 #include "astral/core/context.hpp"
 #include <vulkan/vulkan.h>
+#include <array>
+#include <cstdint>
+#include <memory>
 #include <vector>
 
 namespace astral {
 
+class Buffer;
+
+// Owns the bindless descriptor set. Each binding hands out slots from its
+// own table; unregistered slots are reused only after MAX_FRAMES_IN_FLIGHT
+// calls to beginFrame, so frames still in flight never see them rewritten.
+// There is no way to rewrite a live slot: a descriptor that a pending
+// command buffer may use must not change, so replacing a resource means
+// registering it in a new slot and unregistering the old one. A slot is
+// written only by the flush that follows its allocation, which is what
+// makes writing the descriptor buffer in place safe: no frame in flight
+// references a slot between its release and its reuse.
+//
+// register* only queue their descriptor writes; flush()
+// applies them in one vkUpdateDescriptorSets call. The bindings are update
+// after bind, so command buffers may be recorded against queued slots, but
+// flush() must run before they are submitted.
+//
+// With VK_EXT_descriptor_buffer the set lives in a host-visible buffer
+// instead of a pool, and flush() writes the queued descriptors into it with
+// vkGetDescriptorEXT. Devices (or builds) without the extension use the
+// pool. Bind the set with bind() and create pipelines that use the layout
+// with getPipelineCreateFlags(), which work for both.
 class DescriptorManager {
 public:
+    // One registration of a slot. Unregistering advances the slot's
+    // generation, so a handle kept past that no longer validates.
+    struct BindlessHandle {
+        uint32_t binding = 0;
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+    };
+
     DescriptorManager(Context* context);
     ~DescriptorManager();
 
     VkDescriptorSetLayout getLayout() const { return m_layout; }
-    VkDescriptorSet getDescriptorSet() const { return m_set; }
+    VkDescriptorSet getDescriptorSet() const { return m_set; } // Null with a descriptor buffer
+    bool usesDescriptorBuffer() const { return m_descriptorBuffer != nullptr; }
+    VkPipelineCreateFlags getPipelineCreateFlags() const;
+
+    // Binds the bindless set as set 0 of layout
+    void bind(VkCommandBuffer cb, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const;
 
     uint32_t registerImage(VkImageView view, VkSampler sampler);
     uint32_t registerImageArray(VkImageView view, VkSampler sampler);
     uint32_t registerImageCube(VkImageView view, VkSampler sampler);
     uint32_t registerStorageImage(VkImageView view);
+    // Binding 14. Images that are also written as storage images stay in
+    // VK_IMAGE_LAYOUT_GENERAL, so the layout is the caller's.
+    uint32_t registerImageCubeArray(VkImageView view, VkSampler sampler,
+                                    VkImageLayout layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    // range must be explicit: descriptor buffers have no VK_WHOLE_SIZE
     uint32_t registerBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding = 1);
 
+    // Return a slot to its binding. The descriptor is left as is until the
+    // slot is handed out again, so the resource must stay alive while frames
+    // in flight may use it. Throws for slots that are not registered.
+    void unregisterImage(uint32_t index);
+    void unregisterImageArray(uint32_t index);
+    void unregisterImageCube(uint32_t index);
+    void unregisterStorageImage(uint32_t index);
+    void unregisterImageCubeArray(uint32_t index);
+    void unregisterBuffer(uint32_t index, uint32_t binding = 1);
+
+    // Holds resource for MAX_FRAMES_IN_FLIGHT calls to beginFrame, as long
+    // as the slots unregistered alongside it, so frames in flight can still
+    // read it through them
+    void retire(std::shared_ptr<void> resource);
+
+    BindlessHandle getHandle(uint32_t binding, uint32_t index) const;
+    bool isValid(const BindlessHandle& handle) const;
+
+    // Call once per frame after the frame fence wait
+    void beginFrame();
+
+    // Writes queued since the last flush; call before any submission that
+    // uses the set (the frame, environment bakes)
+    void flush();
+
 private:
-    void createLayout();
+    struct SlotTable {
+        uint32_t capacity = 0;
+        std::vector<bool> live;            // Indexed by slot, grows to capacity
+        std::vector<uint32_t> generations; // Advanced on unregister
+        std::vector<bool> written;         // Flushed since the slot was handed out
+        std::vector<uint32_t> freeList;    // Retired slots, ready for reuse
+    };
+
+    struct PendingFree {
+        uint32_t binding;
+        uint32_t index;
+        uint32_t framesLeft;
+    };
+
+    struct RetiredResource {
+        std::shared_ptr<void> resource;
+        uint32_t framesLeft;
+    };
+
+    struct PendingWrite {
+        uint32_t binding;
+        uint32_t index;
+        VkDescriptorType type;
+        uint32_t infoIndex; // Into m_pendingBufferInfos for storage buffers, else m_pendingImageInfos
+    };
+
+    void createLayout(bool descriptorBuffer);
     void createPoolAndSet();
+    // Returns false when the layout does not fit the device's descriptor
+    // buffer limits
+    bool createDescriptorBuffer();
+    void writeDescriptorBuffer();
+
+    static bool isBufferBinding(uint32_t binding);
+    bool isRegistered(uint32_t binding, uint32_t index) const;
+    uint32_t allocateSlot(uint32_t binding, const char* kind);
+    void releaseSlot(uint32_t binding, uint32_t index);
+    void queueWrite(const PendingWrite& write);
+    void queueImageWrite(uint32_t binding, uint32_t index, VkDescriptorType type, VkImageView view,
+                         VkSampler sampler, VkImageLayout layout);
 
     Context* m_context;
-    VkDescriptorSetLayout m_layout;
-    VkDescriptorPool m_pool;
-    VkDescriptorSet m_set;
-
-    uint32_t m_nextImageIndex = 0;
-    uint32_t m_nextArrayImageIndex = 0;
-    uint32_t m_nextCubeImageIndex = 0;
-    uint32_t m_nextStorageImageIndex = 0;
-    uint32_t m_nextBufferIndices[16]{0}; // Track indices per binding (extended for more buffer types)
+    VkDescriptorSetLayout m_layout = VK_NULL_HANDLE;
+    VkDescriptorPool m_pool = VK_NULL_HANDLE;
+    VkDescriptorSet m_set = VK_NULL_HANDLE;
+
+    static constexpr uint32_t BINDING_COUNT = 15;
+    static constexpr uint32_t BUFFER_BINDINGS[] = {1, 2, 3, 6, 7, 8, 9, 10, 11, 13};
     static constexpr uint32_t MAX_BINDLESS_IMAGES = 10000;
     static constexpr uint32_t MAX_BINDLESS_BUFFERS = 2000;
+    static constexpr uint32_t MAX_BINDLESS_CUBE_ARRAYS = 64;
+
+    std::array<SlotTable, BINDING_COUNT> m_slots;
+    std::vector<PendingFree> m_pendingFrees;
+    std::vector<RetiredResource> m_retiredResources;
+
+    // In registration order, so a later write to a slot wins
+    std::vector<PendingWrite> m_pendingWrites;
+    std::vector<VkDescriptorImageInfo> m_pendingImageInfos;
+    std::vector<VkDescriptorBufferInfo> m_pendingBufferInfos;
+
+    // Descriptor buffer backend; m_descriptorBuffer is null without it
+    std::unique_ptr<Buffer> m_descriptorBuffer;
+    uint8_t* m_descriptorData = nullptr;
+    VkDeviceAddress m_descriptorAddress = 0;
+    std::array<VkDeviceSize, BINDING_COUNT> m_bindingOffsets{};
+    size_t m_combinedImageSamplerSize = 0;
+    size_t m_storageImageSize = 0;
+    size_t m_storageBufferSize = 0;
+
+    PFN_vkGetDescriptorSetLayoutSizeEXT m_getLayoutSize = nullptr;
+    PFN_vkGetDescriptorSetLayoutBindingOffsetEXT m_getBindingOffset = nullptr;
+    PFN_vkGetDescriptorEXT m_getDescriptor = nullptr;
+    PFN_vkCmdBindDescriptorBuffersEXT m_cmdBindDescriptorBuffers = nullptr;
+    PFN_vkCmdSetDescriptorBufferOffsetsEXT m_cmdSetDescriptorBufferOffsets = nullptr;
 };
 
 } // namespace astral
@@ -3,40 +3,173 @@
 #include "astral/core/context.hpp"
 #include "astral/resources/image.hpp"
 #include "astral/renderer/compute_pipeline.hpp"
+#include "astral/renderer/ibl_cache.hpp"
+#include "astral/resources/buffer.hpp"
+#include <glm/glm.hpp>
+#include <array>
+#include <deque>
+#include <filesystem>
+#include <future>
 #include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 namespace astral {
 
+class CommandBuffer;
+class CommandPool;
+class ThreadPool;
+
 class EnvironmentManager {
 public:
     EnvironmentManager(Context* context);
     ~EnvironmentManager();
 
+    // Loads an environment and blocks until it is in use. Meant for startup;
+    // use requestEnvironment to switch while rendering.
     void loadHDR(const std::string& path);
-    
-    uint32_t getSkyboxIndex() const { return m_skyboxIndex; }
-    uint32_t getIrradianceIndex() const { return m_irradianceIndex; }
-    uint32_t getPrefilteredIndex() const { return m_prefilteredIndex; }
+
+    // Switches environments without blocking. The HDR file is decoded (or
+    // its baked maps read from the IBL cache) on a worker, the maps are
+    // baked on the async compute queue and update() swaps them in once the bake's
+    // timeline value is reached. The current maps stay bound until then. A
+    // newer request supersedes any that has not been swapped in yet.
+    void requestEnvironment(const std::string& path);
+
+    // Call once per frame after the frame fence wait. Submits decoded
+    // environments, swaps in finished bakes and destroys maps that no frame
+    // in flight can still sample.
+    void update();
+
+    bool isLoading() const { return !m_decodes.empty() || m_bake != nullptr; }
+
+    // Bakes run on the async compute queue and the host only polls their
+    // timeline value, which makes nothing visible to the graphics queue. The
+    // first submission sampling swapped in maps must wait on getTimeline()
+    // at the value returned here; 0 when nothing new was swapped in since the
+    // last call.
+    VkSemaphore getTimeline() const { return m_timeline; }
+    uint64_t takeSwapWaitValue() { return std::exchange(m_swapWaitValue, 0); }
+
+    // Baked maps are cached here, keyed by HDR content (empty = disabled)
+    void setCacheDirectory(std::filesystem::path directory) { m_cacheDirectory = std::move(directory); }
+
+    uint32_t getSkyboxIndex() const { return m_current.skyboxIndex; }
+    uint32_t getPrefilteredIndex() const { return m_current.prefilteredIndex; }
     uint32_t getBrdfLutIndex() const { return m_brdfLutIndex; }
 
+    // Diffuse irradiance as 9 L2 spherical harmonics coefficients (rgb in
+    // xyz), pre-convolved with the cosine lobe and divided by pi: evaluating
+    // the basis at N gives the value the irradiance cubemap used to hold
+    const std::array<glm::vec4, 9>& getIrradianceSH() const { return m_current.irradianceSH; }
+    bool hasEnvironment() const { return m_current.prefilteredIndex != (uint32_t)-1; }
+
 private:
+    // The per-environment maps, swapped in as a whole
+    struct EnvironmentMaps {
+        std::unique_ptr<Image> skybox;
+        std::unique_ptr<Image> prefiltered;
+        uint32_t skyboxIndex = (uint32_t)-1;
+        uint32_t prefilteredIndex = (uint32_t)-1;
+        std::array<glm::vec4, 9> irradianceSH{};
+    };
+
+    // Worker output: either the baked maps from the IBL cache or the
+    // equirect texels, both already in a staging buffer
+    struct DecodedEnvironment {
+        uint64_t cacheKey = 0;
+        std::unique_ptr<Buffer> staging;
+        bool fromCache = false;
+        IblCacheData cached; // Image descriptions and SH only, no texels
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct PendingDecode {
+        uint64_t request;
+        std::string path;
+        std::future<std::unique_ptr<DecodedEnvironment>> result;
+    };
+
+    // A bake submitted to the GPU. Its resources live until the timeline
+    // semaphore reaches timelineValue.
+    struct BakeJob {
+        uint64_t request = 0;
+        std::string path;
+        uint64_t timelineValue = 0;
+        std::unique_ptr<DecodedEnvironment> source;
+        EnvironmentMaps maps;
+        std::unique_ptr<Image> brdfLut; // Set when this job creates the LUT
+        uint32_t brdfLutIndex = (uint32_t)-1;
+        std::unique_ptr<Image> equirect;
+        uint32_t equirectIndex = (uint32_t)-1;
+        uint32_t skyboxStorageIndex = (uint32_t)-1;
+        uint32_t brdfLutStorageIndex = (uint32_t)-1;
+        std::vector<VkImageView> prefilteredMipViews; // Bake storage views
+        std::vector<uint32_t> prefilteredMipIndices;
+        std::unique_ptr<CommandPool> commandPool;
+        std::unique_ptr<CommandBuffer> commandBuffer;
+        std::unique_ptr<Buffer> readback; // Null when the bake is not cached
+    };
+
+    struct RetiredMaps {
+        EnvironmentMaps maps;
+        uint64_t frame;
+    };
+
     Context* m_context;
-    
-    std::unique_ptr<Image> m_skybox;
-    std::unique_ptr<Image> m_irradiance;
-    std::unique_ptr<Image> m_prefiltered;
-    std::unique_ptr<Image> m_brdfLut;
+    std::filesystem::path m_cacheDirectory;
+    std::unique_ptr<ThreadPool> m_threadPool; // HDR decode and cache writes
 
-    uint32_t m_skyboxIndex = (uint32_t)-1;
-    uint32_t m_irradianceIndex = (uint32_t)-1;
-    uint32_t m_prefilteredIndex = (uint32_t)-1;
+    EnvironmentMaps m_current;
+    std::deque<RetiredMaps> m_retired;
+    uint64_t m_frame = 0;
+
+    // Shared by every environment, baked or loaded once
+    std::unique_ptr<Image> m_brdfLut;
     uint32_t m_brdfLutIndex = (uint32_t)-1;
+    IblCacheImage m_brdfLutCache; // Texels for later cache entries
+
+    std::deque<PendingDecode> m_decodes;
+    std::unique_ptr<BakeJob> m_bake; // At most one on the GPU at a time
+    uint64_t m_latestRequest = 0;
+
+    // Bakes are submitted here, signaling m_timeline
+    VkQueue m_bakeQueue = VK_NULL_HANDLE;
+    uint32_t m_bakeQueueFamily = 0;
+    VkSemaphore m_timeline = VK_NULL_HANDLE;
+    uint64_t m_timelineValue = 0;
+    uint64_t m_swapWaitValue = 0; // Timeline value of the last swapped in bake
+
+    // Bake pipelines share one layout; created on the first bake and reused
+    // for every environment after that
+    VkPipelineLayout m_bakeLayout = VK_NULL_HANDLE;
+    std::unique_ptr<ComputePipeline> m_equirectPipeline;
+    std::unique_ptr<ComputePipeline> m_shProjectPipeline;
+    std::unique_ptr<ComputePipeline> m_prefilterPipeline;
+    std::unique_ptr<ComputePipeline> m_brdfLutPipeline;
+
+    // Per-workgroup SH partial sums, summed on the host after the bake
+    std::unique_ptr<Buffer> m_shPartials;
+    uint32_t m_shPartialsIndex = (uint32_t)-1;
+
+    VkFormat getEquirectFormat() const;
+    std::unique_ptr<DecodedEnvironment> decode(const std::string& path, const std::filesystem::path& cacheDirectory,
+                                               VkFormat format) const;
+    bool isComplete(const BakeJob& job) const;
+    void waitForBake() const;
+    void poll();
 
-    void convertEquirectToCube(const std::unique_ptr<Image>& equirect);
-    void generateIrradiance();
-    void generatePrefiltered();
-    void generateBrdfLut();
+    void createBakePipelines();
+    void submitBake(uint64_t request, const std::string& path, std::unique_ptr<DecodedEnvironment> source);
+    void createBakeTargets(BakeJob& job, VkSampler sampler);
+    void recordBake(BakeJob& job, VkCommandBuffer cb, uint32_t equirectIndex);
+    void recordCachedUpload(BakeJob& job, VkCommandBuffer cb);
+    void completeBake();
+    // Returns the maps' bindless slots; the images may still be in flight
+    void releaseMaps(EnvironmentMaps& maps);
 };
 
 } // namespace astral
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "astral/core/context.hpp"
+#include "astral/renderer/model.hpp"
+#include "astral/resources/buffer.hpp"
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace astral {
+
+// First-fit free list over [0, capacity) elements. Adjacent free ranges are
+// merged on release.
+class RangeAllocator {
+public:
+    static constexpr uint32_t INVALID_OFFSET = UINT32_MAX;
+
+    explicit RangeAllocator(uint32_t capacity = 0);
+
+    uint32_t allocate(uint32_t size);
+    void release(uint32_t offset, uint32_t size);
+    void grow(uint32_t newCapacity);
+
+    uint32_t getCapacity() const { return m_capacity; }
+    uint32_t getUsed() const { return m_used; }
+
+private:
+    std::map<uint32_t, uint32_t> m_freeRanges; // offset -> size
+    uint32_t m_capacity = 0;
+    uint32_t m_used = 0;
+};
+
+// Device-local megabuffers shared by all models: one vertex buffer per
+// VertexFormat, one 32-bit index buffer and one meshlet buffer (bindless
+// storage buffer, binding 13). Every model is a suballocation, so all
+// instances of one vertex format can be drawn with a single vertex/index
+// bind and one indirect call.
+class GeometryPool {
+public:
+    GeometryPool(Context* context, uint32_t initialVertexCapacity = 1u << 18,
+                 uint32_t initialIndexCapacity = 1u << 20, uint32_t initialMeshletCapacity = 1u << 14);
+    ~GeometryPool();
+
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    // Records uploads of vertices (laid out as the given format),
+    // model-relative indices and meshlets into the context's UploadManager;
+    // the data is usable once that batch is submitted and retired. Buffers
+    // grow on demand; growing flushes pending uploads and waits for the device.
+    GeometryAllocation allocate(VertexFormat format, const void* vertexData, uint32_t vertexCount,
+                                const uint32_t* indexData, uint32_t indexCount,
+                                const Meshlet* meshletData = nullptr, uint32_t meshletCount = 0);
+
+    // Ranges are recycled only after MAX_FRAMES_IN_FLIGHT calls to beginFrame,
+    // so frames still in flight never see them overwritten.
+    void free(const GeometryAllocation& allocation);
+    void beginFrame();
+
+    VkBuffer getVertexBuffer(VertexFormat format) const;
+    VkBuffer getIndexBuffer() const;
+    // Bindless index of the meshlet buffer; changes when the buffer grows
+    uint32_t getMeshletBufferIndex() const { return m_meshletBufferIndex; }
+
+    static uint32_t getVertexStride(VertexFormat format);
+
+private:
+    struct Pool {
+        std::unique_ptr<Buffer> buffer;
+        RangeAllocator allocator;
+        uint32_t elementSize = 0;
+        VkBufferUsageFlags usage = 0;
+    };
+
+    struct PendingFree {
+        GeometryAllocation allocation;
+        uint32_t framesLeft;
+    };
+
+    uint32_t allocateFrom(Pool& pool, uint32_t count);
+    void growPool(Pool& pool, uint32_t requiredCapacity);
+    void createPoolBuffer(Pool& pool, uint32_t capacity);
+
+    Context* m_context;
+    std::vector<Pool> m_vertexPools; // Indexed by VertexFormat
+    Pool m_indexPool;
+    Pool m_meshletPool;
+    VkBuffer m_registeredMeshletBuffer = VK_NULL_HANDLE;
+    uint32_t m_meshletBufferIndex = 0;
+    std::vector<PendingFree> m_pendingFrees;
+};
+
+} // namespace astral
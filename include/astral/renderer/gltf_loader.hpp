@@ -2,24 +2,131 @@
 
 #include "astral/renderer/model.hpp"
 #include <filesystem>
+#include <future>
+#include <memory>
 
 namespace astral {
 
 class Context;
 class SceneManager;
+class ThreadPool;
+class TextureCache;
+class TextureStreamer;
+struct ImportedModel;
+
+struct GltfLoadOptions {
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    // Vertex cache / overdraw / vertex fetch optimization per primitive
+    bool optimizeMeshes = true;
+    // Index LODs generated per triangle primitive, including the full mesh
+    // (1 = no simplification, at most MAX_PRIMITIVE_LODS)
+    uint32_t lodCount = MAX_PRIMITIVE_LODS;
+    // Largest simplification error per LOD step, relative to the primitive
+    // bounding radius
+    float lodTargetError = 0.1f;
+    // Meshlets with culling bounds for the cluster cull stage
+    bool buildMeshlets = true;
+    // Processed geometry is cached here, keyed by asset content (empty = disabled)
+    std::filesystem::path meshCacheDirectory;
+};
+
+// Where the CPU side of one import spent its time. Primitive stages
+// (attributes ... lod) run in parallel and are summed over all threads, so
+// they can add up to more than geometryMs.
+struct GltfImportStats {
+    double parseMs = 0.0;       // Mapping the files and parsing the JSON
+    double imageDecodeMs = 0.0; // Decoding and CPU mip generation
+    double geometryMs = 0.0;    // Wall time of the whole geometry import (0 on a cache hit)
+    double attributesMs = 0.0;  // Accessor reads, normal and tangent generation
+    double optimizeMs = 0.0;    // Vertex cache, overdraw and vertex fetch optimization
+    double meshletMs = 0.0;
+    double lodMs = 0.0;
+    double cacheMs = 0.0;       // Mesh cache lookup and write
+    double packMs = 0.0;        // Vertex packing and node hierarchy
+    double totalMs = 0.0;
+
+    bool cacheHit = false;
+    uint64_t sourceBytes = 0;   // glTF/GLB file, external buffers and external images
+    uint32_t imageCount = 0;    // Images decoded
+    uint32_t primitiveCount = 0;
+    uint32_t vertexCount = 0;
+    uint32_t indexCount = 0;    // All LODs
+    uint32_t meshletCount = 0;
+};
+
+// Runs the complete CPU side of a load (parse, image decode, attribute
+// generation, optimization, LODs, meshlets, mesh cache read/write) without a
+// Context or device, and discards the result. For measuring import
+// throughput, e.g. with astral_import_bench. Returns false on failure.
+bool importGltfHeadless(const std::filesystem::path& path, const GltfLoadOptions& options, ThreadPool* pool,
+                        GltfImportStats* stats = nullptr);
+
+enum class ModelLoadState {
+    Loading,   // Parsing and decoding on a worker thread
+    Uploading, // Geometry and textures are being transferred to the GPU
+    Ready,     // Fully resident
+    Failed
+};
+
+// Progress of a loadAsync request. Written by GltfLoader::update() on the
+// main thread only.
+struct ModelLoadHandle {
+    std::filesystem::path path;
+    ModelLoadState state = ModelLoadState::Loading;
+    // Set once the geometry is resident and the model has been published to
+    // the SceneManager; textures keep streaming in after that
+    std::shared_ptr<Model> model;
+    uint32_t texturesPending = 0;
+
+    bool isDone() const { return state == ModelLoadState::Ready || state == ModelLoadState::Failed; }
+};
 
 class GltfLoader {
 public:
     explicit GltfLoader(Context* context);
     ~GltfLoader();
 
-    std::unique_ptr<Model> loadFromFile(const std::filesystem::path& path, SceneManager* sceneManager);
+    // Blocks until the model and the mip tails of all of its textures are
+    // resident; finer mips stream in through getTextureStreamer()
+    std::shared_ptr<Model> loadFromFile(const std::filesystem::path& path, SceneManager* sceneManager,
+                                        const GltfLoadOptions& options = {});
+
+    // Parses and decodes on a worker thread, then uploads from update(). The
+    // model is published with SceneManager::addModel as soon as its geometry
+    // is resident and drawn with untextured materials until textures arrive.
+    std::shared_ptr<ModelLoadHandle> loadAsync(const std::filesystem::path& path, SceneManager* sceneManager,
+                                               const GltfLoadOptions& options = {});
+
+    // Advances async loads. Call once per frame on the main thread after the
+    // frame fence wait.
+    void update();
+    bool hasPendingLoads() const { return !m_jobs.empty(); }
+
+    // Texture bytes staged per update() call; at least one image is always staged
+    void setUploadBudget(VkDeviceSize bytesPerFrame) { m_uploadBudget = bytesPerFrame; }
+
+    // Streams the finer mips of every texture loaded through this loader
+    TextureStreamer& getTextureStreamer() { return *m_textureStreamer; }
 
 private:
+    struct LoadJob;
+
+    void beginUpload(LoadJob& job);
+    VkDeviceSize uploadImages(LoadJob& job, VkDeviceSize budget);
+    VkSampler getTextureSampler(const LoadJob& job, size_t texture) const;
+    void resolveTextureIndices(LoadJob& job);
+    void refreshMaterials(LoadJob& job);
+    void finishJob(LoadJob& job);
+
     Context* m_context;
-    VkSampler m_defaultSampler;
-    std::vector<VkSampler> m_samplers;
+    VkSampler m_defaultSampler; // Owned by the context's SamplerCache
     void createDefaultSampler();
+
+    std::unique_ptr<TextureCache> m_textureCache; // Shared by all models loaded through this loader
+    std::unique_ptr<TextureStreamer> m_textureStreamer;
+    std::unique_ptr<ThreadPool> m_threadPool;
+    std::vector<std::unique_ptr<LoadJob>> m_jobs;
+    VkDeviceSize m_uploadBudget = 16ull * 1024 * 1024;
 };
 
 } // namespace astral
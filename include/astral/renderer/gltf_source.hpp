@@ -0,0 +1,72 @@
+#pragma once
+
+#include "astral/core/asset_file.hpp"
+#include <fastgltf/core.hpp>
+#include <fastgltf/types.hpp>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+namespace astral {
+
+// Memory-mapped input for a .gltf (+ external .bin) or .glb file, read
+// through AssetFile so a mounted asset archive is used when it has them.
+// Only the JSON is copied; buffers stay in the mappings and accessors,
+// embedded images and content hashing read them in place. EXT_meshopt_compression
+// buffer views are decoded once during parse() and served from the heap.
+//
+// Pass the source as the BufferDataAdapter of fastgltf::iterateAccessor*:
+//     fastgltf::iterateAccessor<T>(asset, accessor, func, source);
+class GltfSource {
+public:
+    // Throws std::runtime_error if the file cannot be mapped
+    explicit GltfSource(const std::filesystem::path& path);
+    ~GltfSource();
+
+    GltfSource(const GltfSource&) = delete;
+    GltfSource& operator=(const GltfSource&) = delete;
+
+    // Parses the asset, maps its external buffers and decodes compressed
+    // buffer views. Do not pass LoadExternalBuffers: mapping them is the point.
+    fastgltf::Error parse(fastgltf::Parser& parser, fastgltf::Options options);
+
+    fastgltf::Asset& getAsset() { return m_asset; }
+    const fastgltf::Asset& getAsset() const { return m_asset; }
+    const AssetFile& getFile() const { return *m_file; }
+
+    fastgltf::span<const std::byte> getBufferBytes(size_t bufferIndex) const;
+    fastgltf::span<const std::byte> getBufferViewBytes(size_t bufferViewIndex) const;
+
+    // fastgltf BufferDataAdapter
+    fastgltf::span<const std::byte> operator()(const fastgltf::Asset& asset, std::size_t bufferViewIndex) const {
+        return getBufferViewBytes(bufferViewIndex);
+    }
+
+private:
+    class DataGetter;
+    static fastgltf::BufferInfo mapBuffer(std::uint64_t bufferSize, void* userPointer);
+    bool decodeCompressedViews();
+
+    std::filesystem::path m_path;
+    std::unique_ptr<AssetFile> m_file;
+    fastgltf::Asset m_asset;
+
+    // GLB binary chunk, handed to fastgltf as CustomBuffer GLB_BUFFER_ID
+    size_t m_glbBinaryOffset = 0;
+    size_t m_glbBinaryLength = 0;
+    bool m_glbBinaryClaimed = false;
+    static constexpr fastgltf::CustomBufferId GLB_BUFFER_ID = 0;
+
+    // Decoded data URIs; CustomBuffer id N refers to m_heapBuffers[N - 1]
+    std::vector<std::unique_ptr<std::byte[]>> m_heapBuffers;
+    std::vector<size_t> m_heapBufferSizes;
+
+    // External buffer files, indexed like asset.buffers (null if not a file)
+    std::vector<std::unique_ptr<AssetFile>> m_bufferFiles;
+
+    // Decoded EXT_meshopt_compression views, indexed like asset.bufferViews
+    // (empty if the view is not compressed)
+    std::vector<std::vector<std::byte>> m_decodedViews;
+};
+
+} // namespace astral
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace astral {
+
+// One baked image: every mip level, finest first, with all layers of a
+// level stored together (the layout of a single-region buffer copy)
+struct IblCacheImage {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t layers = 1;
+    uint32_t mipLevels = 1;
+    std::vector<uint8_t> data;
+};
+
+// Everything EnvironmentManager bakes from one HDR environment
+struct IblCacheData {
+    IblCacheImage skybox;
+    std::array<glm::vec4, 9> irradianceSH{}; // L2 SH of irradiance / pi, rgb in xyz
+    IblCacheImage prefiltered;
+    IblCacheImage brdfLut;
+};
+
+// On-disk cache of baked IBL maps, keyed by a content hash of the HDR file
+// and the bake parameters. Entries are single binary files named after the
+// key; stale or foreign files are rejected by the header.
+class IblCache {
+public:
+    explicit IblCache(std::filesystem::path directory);
+
+    bool load(uint64_t key, IblCacheData& data) const;
+    bool store(uint64_t key, const IblCacheData& data) const;
+
+private:
+    std::filesystem::path entryPath(uint64_t key) const;
+
+    std::filesystem::path m_directory;
+};
+
+} // namespace astral
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "astral/renderer/model.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace astral {
+
+// Import-time generation of missing vertex attributes and bounds. All
+// functions work on a single triangle list primitive with primitive-local
+// (0-based) indices.
+
+// Flat normals as required by glTF for primitives without NORMAL. Every
+// triangle gets its own three vertices, so the vertex buffer is rewritten
+// in triangle order.
+void generateFlatNormals(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// Per-vertex tangent frames following the MikkTSpace conventions: face
+// tangents from the UV gradients are projected into each vertex's normal
+// plane, weighted by the corner angle and orthonormalized, with the
+// bitangent sign in tangent.w. Vertices shared by triangles of opposite
+// UV handedness (mirrored UVs) are split so that each side keeps its sign.
+// Vertices without usable UVs get an arbitrary frame around the normal.
+void generateTangents(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// Tight bounding sphere of all vertices: the smaller of Ritter's
+// sphere (seeded with the most distant pair of axis extremes) and the
+// bounding box centered sphere.
+void computeBoundingSphere(const std::vector<Vertex>& vertices, glm::vec3& center, float& radius);
+
+} // namespace astral
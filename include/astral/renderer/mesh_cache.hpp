@@ -0,0 +1,35 @@
+#pragma once
+
+#include "astral/renderer/model.hpp"
+#include <filesystem>
+#include <vector>
+
+namespace astral {
+
+// Processed (optimized) geometry of one model, as produced by the import
+// stage. Primitive::materialIndex holds the source glTF material index
+// (-1 = none) until the loader maps it to a SceneManager material.
+struct MeshCacheData {
+    std::vector<Mesh> meshes;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets;
+};
+
+// On-disk cache of processed geometry, keyed by a content hash of the
+// source asset and the import options. Entries are single binary files
+// named after the key; stale or foreign files are rejected by the header.
+class MeshCache {
+public:
+    explicit MeshCache(std::filesystem::path directory);
+
+    bool load(uint64_t key, MeshCacheData& data) const;
+    bool store(uint64_t key, const MeshCacheData& data) const;
+
+private:
+    std::filesystem::path entryPath(uint64_t key) const;
+
+    std::filesystem::path m_directory;
+};
+
+} // namespace astral
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "astral/renderer/model.hpp"
+#include <cstdint>
+#include <vector>
+
+namespace astral {
+
+// Import-time index/vertex reordering for triangle lists. All functions work
+// on a single primitive with primitive-local (0-based) indices.
+//
+// Recommended order: optimizeVertexCache -> optimizeOverdraw -> optimizeVertexFetch.
+
+// Reorders triangles for post-transform vertex cache locality (Forsyth).
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);
+
+// Reorders cache-friendly triangle clusters so that outward facing clusters
+// are drawn first, reducing overdraw. threshold bounds how much vertex cache
+// efficiency (ACMR) may be traded for smaller clusters (1.05 = 5% worse).
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                      float threshold = 1.05f);
+
+// Reorders vertices in first-use order and rewrites indices accordingly.
+// Unreferenced vertices are dropped. Returns the new vertex count.
+size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// Average cache miss ratio (transformed vertices per triangle) for a FIFO
+// cache of cacheSize entries. Useful for logging optimization results.
+float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Simplifies a triangle list by collapsing edges onto existing vertices in
+// order of quadric error, so the result still indexes the input vertices.
+// Vertices on open borders and attribute seams are never moved. Stops when the
+// index count reaches targetIndexCount or the next collapse would exceed
+// targetError (mesh units). resultError receives the largest error introduced.
+std::vector<uint32_t> simplifyMesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                   size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+// Splits a triangle list into meshlets of consecutive triangles with at most
+// maxVertices unique vertices and maxTriangles triangles each, and computes
+// their bounding spheres and normal cones. Run after optimizeVertexCache so
+// that consecutive triangles are spatially close. Meshlet::firstIndex is
+// relative to the start of indices.
+std::vector<Meshlet> buildMeshlets(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                   size_t maxVertices = MESHLET_MAX_VERTICES,
+                                   size_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+} // namespace astral
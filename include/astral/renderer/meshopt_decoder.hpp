@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace astral {
+
+// Decoders for EXT_meshopt_compression buffer views. The bitstreams are the
+// meshoptimizer codecs the extension specifies: vertex codec v0, index codec
+// v0/v1 and index sequence codec v0/v1. All functions return false on
+// malformed input.
+
+// mode ATTRIBUTES: vertexCount elements of vertexSize bytes (multiple of 4, <= 256)
+bool decodeMeshoptVertexBuffer(void* destination, size_t vertexCount, size_t vertexSize,
+                               const uint8_t* buffer, size_t bufferSize);
+
+// mode TRIANGLES: indexCount (multiple of 3) indices of indexSize bytes (2 or 4)
+bool decodeMeshoptIndexBuffer(void* destination, size_t indexCount, size_t indexSize,
+                              const uint8_t* buffer, size_t bufferSize);
+
+// mode INDICES: indexCount indices of indexSize bytes (2 or 4), any topology
+bool decodeMeshoptIndexSequence(void* destination, size_t indexCount, size_t indexSize,
+                                const uint8_t* buffer, size_t bufferSize);
+
+// In-place filters applied after decodeMeshoptVertexBuffer. count is the
+// element count, stride the element size in bytes.
+void decodeMeshoptFilterOctahedral(void* data, size_t count, size_t stride); // stride 4 or 8
+void decodeMeshoptFilterQuaternion(void* data, size_t count, size_t stride); // stride 8
+void decodeMeshoptFilterExponential(void* data, size_t count, size_t stride); // stride multiple of 4
+
+} // namespace astral
@@ -10,6 +10,12 @@
 
 namespace astral {
 
+// Vertex buffer layout of a model. Selected per model at load time.
+enum class VertexFormat : uint32_t {
+    Standard = 0, // Vertex: full precision float attributes (64 bytes)
+    Packed = 1    // PackedVertex: quantized attributes (20 bytes)
+};
+
 struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
@@ -21,38 +27,120 @@ struct Vertex {
     static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 };
 
+// Quantized vertex. Positions are unorm16 relative to the primitive bounds
+// (Primitive::quantOffset/quantScale), normal and tangent are octahedral
+// snorm16, UVs are half floats. position[3] stores the tangent handedness.
+struct PackedVertex {
+    uint16_t position[4];
+    int16_t normal[2];
+    int16_t tangent[2];
+    uint16_t uv[2];
+
+    static PackedVertex pack(const Vertex& vertex, const glm::vec3& quantOffset, const glm::vec3& quantScale);
+
+    static VkVertexInputBindingDescription getBindingDescription();
+    static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+};
+
+// Index range of one level of detail. All levels of a primitive index the
+// same vertices; error is the simplification error in mesh units.
+struct PrimitiveLod {
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    float error = 0.0f;
+};
+
+constexpr uint32_t MAX_PRIMITIVE_LODS = 4;
+
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+
+// Run of consecutive LOD 0 triangles with culling bounds, drawn as its own
+// index range when the cluster cull stage keeps it. Bounds are in mesh space.
+// Mirrored in meshlet_cull.comp.
+struct Meshlet {
+    glm::vec3 center;
+    float radius;
+    glm::vec3 coneAxis;  // Average facing of the triangles
+    float coneCutoff;    // sin of the cone half angle; 1 = no backface test
+    uint32_t firstIndex; // Relative to the primitive's LOD 0 firstIndex
+    uint32_t indexCount;
+    uint32_t padding[2];
+};
+
 struct Primitive {
-    uint32_t firstIndex;
+    uint32_t firstIndex; // LOD 0, same as lods[0]
     uint32_t indexCount;
+    uint32_t firstVertex = 0;
+    uint32_t vertexCount = 0;
     int32_t materialIndex; // SceneManager'daki material metadata buffer indeksi
     glm::vec3 boundingCenter;
     float boundingRadius;
+
+    // Packed vertex dequantization: position = quantOffset + unorm * quantScale
+    glm::vec3 quantOffset{0.0f};
+    glm::vec3 quantScale{1.0f};
+
+    // Progressively simplified index ranges, finest first
+    PrimitiveLod lods[MAX_PRIMITIVE_LODS] = {};
+    uint32_t lodCount = 0;
+
+    // Range in the model's meshlet stream, covering LOD 0
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
 };
 
+// Suballocation of a model's geometry inside the GeometryPool megabuffers.
+// Primitive ranges are relative to it: draws use firstIndex + primitive.firstIndex
+// and vertexOffset as the indirect command vertex offset; meshlets live at
+// firstMeshlet + primitive.firstMeshlet.
+struct GeometryAllocation {
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    uint32_t vertexOffset = 0;
+    uint32_t vertexCount = 0;
+    uint32_t firstIndex = 0;
+    uint32_t indexCount = 0;
+    uint32_t firstMeshlet = 0;
+    uint32_t meshletCount = 0;
+
+    bool isValid() const { return vertexCount > 0 || indexCount > 0 || meshletCount > 0; }
+};
+
+class GeometryPool;
+struct CachedImage;
+
 struct Mesh {
     std::vector<Primitive> primitives;
     std::string name;
 };
 
 struct Model {
+    ~Model(); // Returns the geometry range to the pool
+
     std::vector<Mesh> meshes;
-    std::unique_ptr<Buffer> vertexBuffer;
-    std::unique_ptr<Buffer> indexBuffer;
+    VertexFormat vertexFormat = VertexFormat::Standard;
+    GeometryAllocation geometry;
+    GeometryPool* geometryPool = nullptr;
     
-    // Model içindeki tüm dokular (bindless sisteme kayıtlı)
-    std::vector<std::unique_ptr<Image>> images;
+    // Model içindeki tüm dokular (bindless sisteme kayıtlı). Aynı içerikli
+    // dokular modeller arasında TextureCache üzerinden paylaşılır.
+    std::vector<std::shared_ptr<CachedImage>> images;
     std::vector<uint32_t> textureIndices; 
 
     struct Node {
-        Node* parent;
+        Node* parent = nullptr;
         std::vector<std::unique_ptr<Node>> children;
-        int32_t meshIndex = -1;
-        glm::mat4 matrix;
+        int32_t meshIndex = -1;     // Index into meshes, shared by all nodes using it
+        glm::mat4 matrix{1.0f};     // Local transform
+        glm::mat4 worldMatrix{1.0f}; // Model space transform, see updateWorldMatrices
         std::string name;
     };
 
-    std::vector<std::unique_ptr<Node>> nodes;
-    std::vector<Node*> linearNodes;
+    std::vector<std::unique_ptr<Node>> nodes; // Scene roots
+    std::vector<Node*> linearNodes;           // All nodes, parents before children
+
+    // Recomputes Node::worldMatrix from the local matrices
+    void updateWorldMatrices();
 };
 
 } // namespace astral
@@ -22,6 +22,9 @@ struct PipelineSpecs {
     bool depthWrite = true;
     VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS;
     VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+    // Views rendered without the projection's Y flip (e.g. cube map faces)
+    // see their triangles with the opposite winding
+    VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
     VkPolygonMode polygonMode = VK_POLYGON_MODE_FILL;
 };
 
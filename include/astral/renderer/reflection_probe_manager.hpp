@@ -0,0 +1,129 @@
+#pragma once
+
+#include "astral/core/context.hpp"
+#include "astral/renderer/compute_pipeline.hpp"
+#include "astral/renderer/render_graph.hpp"
+#include "astral/renderer/scene_data.hpp"
+#include "astral/resources/buffer.hpp"
+#include "astral/resources/image.hpp"
+
+#include <array>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace astral {
+
+// Local reflection probes, captured from the scene through the main PBR path
+// and prefiltered into one cube map array. Captures are time-sliced: each
+// frame renders a few faces of one probe, and the frame after its sixth face
+// prefilters the probe into the atlas. Probes are sampled only once they
+// have been filtered; a re-capture keeps the previous result until then.
+class ReflectionProbeManager {
+public:
+  static constexpr uint32_t MAX_PROBES = 16;
+  static constexpr uint32_t PROBE_SIZE = 128;
+  static constexpr uint32_t PROBE_MIPS = 5; // Matches pbr.frag's lod range
+  static constexpr uint32_t MAX_STEPS_PER_FRAME = 6;
+
+  ReflectionProbeManager(Context *context);
+  ~ReflectionProbeManager();
+
+  // Returns the probe index, or -1 once MAX_PROBES exist
+  int addProbe(const glm::vec3 &position, const glm::vec3 &boxMin,
+               const glm::vec3 &boxMax, float blendDistance = 0.5f);
+  // Re-captures every probe, e.g. after the scene or environment changed
+  void invalidateAll();
+  uint32_t getProbeCount() const {
+    return static_cast<uint32_t>(m_probes.size());
+  }
+
+  struct FaceCapture {
+    uint32_t face;
+    uint32_t sceneBufferIndex; // SceneData of the face's view
+    VkDeviceAddress sceneBufferAddress;
+  };
+
+  // Schedules up to stepBudget capture steps (a face render or a probe's
+  // prefilter) and writes this frame's capture views and probe list. The
+  // capture views copy sceneData's lights, shadows and environment.
+  void beginFrame(uint32_t frameIndex, const SceneData &sceneData,
+                  uint32_t stepBudget);
+
+  const std::vector<FaceCapture> &getFaceCaptures() const {
+    return m_faceCaptures;
+  }
+  // Registers the face's color, normal, velocity and depth targets with the
+  // graph and returns their names in the PBR pipeline's attachment order
+  std::vector<std::string> addCaptureTargets(RenderGraph &graph,
+                                             uint32_t face) const;
+
+  bool isFilterPending() const { return m_filterPending; }
+  // Prefilters the captured probe into its atlas cube. Runs after the
+  // frame's face captures.
+  void recordFilter(VkCommandBuffer cb);
+
+  uint32_t getProbeBufferIndex(uint32_t frameIndex) const {
+    return m_probeBufferIndices[frameIndex];
+  }
+  // Probes in this frame's list, i.e. filtered at least once
+  uint32_t getActiveProbeCount() const { return m_activeProbeCount; }
+  uint32_t getAtlasIndex() const { return m_atlasIndex; }
+
+private:
+  struct Probe {
+    ReflectionProbe gpu;
+    bool filtered = false; // Safe to sample
+    bool dirty = true;     // Needs a (re-)capture
+    std::array<VkImageView, PROBE_MIPS> mipViews{};
+    std::array<uint32_t, PROBE_MIPS> mipIndices{};
+  };
+
+  Context *m_context;
+  std::vector<Probe> m_probes;
+
+  // Capture state: the probe being captured and its next face (6 = filter)
+  int m_captureProbe = -1;
+  uint32_t m_nextFace = 0;
+  uint32_t m_nextProbe = 0; // Round robin over dirty probes
+  std::vector<FaceCapture> m_faceCaptures;
+  bool m_filterPending = false;
+  int m_filterProbe = -1;
+  // Targets are in attachment layouts once a frame has rendered to them;
+  // the graph only learns their layout when this frame starts
+  bool m_targetsWritten = false;
+  bool m_targetLayoutsValid = false;
+  bool m_atlasInitialized = false;
+
+  // Cube array holding every probe, kept in VK_IMAGE_LAYOUT_GENERAL since
+  // probes are filtered into it while others are sampled
+  std::unique_ptr<Image> m_atlas;
+  uint32_t m_atlasIndex;
+
+  // Capture targets; one layer per face so the face passes of a frame do
+  // not depend on each other
+  std::unique_ptr<Image> m_captureColor;
+  std::unique_ptr<Image> m_captureNormal;
+  std::unique_ptr<Image> m_captureVelocity;
+  std::unique_ptr<Image> m_captureDepth;
+  std::array<std::array<VkImageView, 4>, 6> m_faceViews{};
+  uint32_t m_captureColorIndex; // Prefilter input
+
+  // Per frame in flight: a SceneData per capture step and the probe list
+  std::vector<std::unique_ptr<Buffer>> m_captureSceneBuffers;
+  std::vector<uint32_t> m_captureSceneIndices;
+  std::vector<std::unique_ptr<Buffer>> m_probeBuffers;
+  std::vector<uint32_t> m_probeBufferIndices;
+  uint32_t m_activeProbeCount = 0;
+
+  VkPipelineLayout m_filterLayout = VK_NULL_HANDLE;
+  std::unique_ptr<ComputePipeline> m_filterPipeline;
+
+  void createTargets();
+  VkImageView createView(const Image &image, VkImageViewType type,
+                         uint32_t baseLayer, uint32_t layerCount,
+                         uint32_t mipLevel);
+};
+
+} // namespace astral
@@ -5,6 +5,7 @@
 #include "astral/renderer/environment_manager.hpp"
 #include "astral/renderer/model.hpp"
 #include "astral/renderer/pipeline.hpp"
+#include "astral/renderer/reflection_probe_manager.hpp"
 #include "astral/renderer/render_graph.hpp"
 #include "astral/renderer/scene_data.hpp"
 #include "astral/renderer/scene_manager.hpp"
@@ -36,10 +37,12 @@ public:
     float shadowNormalBias = 0.005f;
     int pcfRange = 1;
     float csmLambda = 0.95f;
+    float lodErrorThreshold = 1.0f; // Pixels of simplification error
     float ssaoRadius = 0.5f;
     float ssaoBias = 0.025f;
     float gamma = 2.2f;
     float iblIntensity = 1.0f;
+    int probeFacesPerFrame = 2; // Reflection probe capture steps per frame
     int selectedMaterial = 0;
     int selectedLight = 0;
   };
@@ -51,7 +54,7 @@ public:
               SceneManager &sceneManager, uint32_t currentFrame,
               uint32_t imageIndex, const SceneData &sceneData,
               Swapchain *swapchain, FrameSync *sync, const UIParams &uiParams,
-              const Model *model, uint32_t skyboxIndex);
+              uint32_t skyboxIndex);
 
   // Getters for resources that might be needed by App (or maybe App shouldn't
   // know) For now, let's keep it simple.
@@ -103,6 +106,7 @@ public:
   };
 
   RenderResources &getResources() { return m_resources; }
+  ReflectionProbeManager &getReflectionProbes() { return *m_probes; }
 
   // Method to setup the render graph for a frame
   void setupRenderGraph(RenderGraph &graph, Swapchain &swapchain,
@@ -130,6 +134,7 @@ private:
   std::shared_ptr<Shader> m_shadowVertShader;
   std::shared_ptr<Shader> m_shadowFragShader;
   std::shared_ptr<Shader> m_cullShader;
+  std::shared_ptr<Shader> m_meshletCullShader;
   std::shared_ptr<Shader> m_clusterBuildShader;
   std::shared_ptr<Shader> m_clusterCullShader;
   std::shared_ptr<Shader> m_skyboxVertShader;
@@ -137,6 +142,7 @@ private:
 
   // Pipelines
   std::unique_ptr<GraphicsPipeline> m_pbrPipeline;
+  std::unique_ptr<GraphicsPipeline> m_pbrPackedPipeline;
   std::unique_ptr<GraphicsPipeline> m_taaPipeline;
   std::unique_ptr<GraphicsPipeline> m_ssaoPipeline;
   std::unique_ptr<GraphicsPipeline> m_ssaoBlurPipeline;
@@ -144,10 +150,15 @@ private:
   std::unique_ptr<GraphicsPipeline> m_bloomPipeline;
   std::unique_ptr<GraphicsPipeline> m_fxaaPipeline;
   std::unique_ptr<GraphicsPipeline> m_shadowPipeline;
+  std::unique_ptr<GraphicsPipeline> m_shadowPackedPipeline;
   std::unique_ptr<ComputePipeline> m_cullPipeline;
+  std::unique_ptr<ComputePipeline> m_meshletCullPipeline;
   std::unique_ptr<ComputePipeline> m_clusterBuildPipeline;
   std::unique_ptr<ComputePipeline> m_clusterCullPipeline;
   std::unique_ptr<GraphicsPipeline> m_skyboxPipeline;
+  // PBR pipelines for probe faces, which are rendered without the Y flip
+  std::unique_ptr<GraphicsPipeline> m_probePipeline;
+  std::unique_ptr<GraphicsPipeline> m_probePackedPipeline;
 
   // Layouts
   VkPipelineLayout m_pipelineLayout;
@@ -160,13 +171,15 @@ private:
   // m_shadowLayout reuses pipelineLayout (basic one) or we might need specific
   // if push constants differ
   VkPipelineLayout m_cullLayout;
+  VkPipelineLayout m_meshletCullLayout;
   VkPipelineLayout m_clusterBuildLayout;
   VkPipelineLayout m_clusterCullLayout;
   VkPipelineLayout m_skyboxLayout;
 
   RenderResources m_resources;
+  std::unique_ptr<ReflectionProbeManager> m_probes;
 
-  // Samplers
+  // Samplers (owned by the context's SamplerCache)
   VkSampler m_hdrSampler;
   VkSampler m_noiseSampler;
   VkSampler m_shadowSampler;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/glm.hpp>
+#include <cstddef>
 #include <vector>
 #include <vulkan/vulkan.h>
 
@@ -13,6 +14,15 @@ struct Light {
     glm::vec4 params;    // x = innerCutoff, y = outerCutoff, z = shadowIndex, w = padding
 };
 
+// Local box-projected reflection probe. Reflections inside the box are
+// parallax corrected against it and fade to the global map over the last
+// blendDistance units.
+struct ReflectionProbe {
+    glm::vec4 position; // xyz = capture origin, w = cube index in the atlas
+    glm::vec4 boxMin;   // w = blend distance
+    glm::vec4 boxMax;
+};
+
 struct SceneData {
     glm::mat4 view;
     glm::mat4 proj;
@@ -27,7 +37,7 @@ struct SceneData {
     glm::vec4 cameraPos;
     glm::vec2 jitter; // TAA jitter offset
     int lightCount;
-    int irradianceIndex;
+    int iblEnabled; // Environment maps and irradianceSH are valid
     int prefilteredIndex;
     int brdfLutIndex;
     int shadowMapIndex;
@@ -45,8 +55,16 @@ struct SceneData {
     float nearClip, farClip;     // Camera clips for cluster calculation
     float screenWidth, screenHeight;
     float iblIntensity;
+    float shPadding[3];
+    glm::vec4 irradianceSH[9]; // L2 SH of irradiance / pi, rgb in xyz
+    int probeBufferIndex; // Index to the SSBO containing ReflectionProbe array
+    int probeCount;       // Filtered probes in it; 0 = global prefiltered map only
+    int probeAtlasIndex;  // samplerCubeArray slot, one cube per probe
+    int probeCapture;     // Rendering a probe face: every light, no probes
 };
 
+static_assert(offsetof(SceneData, irradianceSH) % 16 == 0, "std430 vec4 array alignment");
+
 struct MaterialMetadata {
     glm::vec4 baseColorFactor;
     float metallicFactor;
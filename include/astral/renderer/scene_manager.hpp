@@ -1,6 +1,8 @@
 #pragma once
 
 #include "astral/core/context.hpp"
+#include "astral/renderer/geometry_pool.hpp"
+#include "astral/renderer/model.hpp"
 #include "astral/renderer/scene_data.hpp"
 #include "astral/resources/buffer.hpp"
 #include <memory>
@@ -13,9 +15,29 @@ struct MeshInstance {
   glm::vec3 sphereCenter;
   float sphereRadius;
   uint32_t materialIndex;
+  uint32_t vertexFormat; // VertexFormat, selects attribute decode in shaders
+  uint32_t lodCount;     // Valid entries in the lod* vectors, at least 1
+  uint32_t meshletCount; // LOD 0 meshlets, 0 = drawn per instance only
+  glm::vec4 positionOffset; // Packed vertices: dequantization offset (xyz)
+  glm::vec4 positionScale;  // Packed vertices: dequantization scale (xyz)
+  // Index ranges per LOD (absolute in the index pool), selected by cull.comp
+  glm::uvec4 lodFirstIndex;
+  glm::uvec4 lodIndexCount;
+  glm::vec4 lodError; // Simplification error in model units
+  uint32_t firstMeshlet; // Absolute index in the GeometryPool meshlet buffer
   uint32_t padding[3];
 };
 
+static_assert(MAX_PRIMITIVE_LODS == 4, "MeshInstance stores LOD ranges in 4-wide vectors");
+
+// Contiguous range of indirect commands sharing one vertex format, drawn
+// with a single GeometryPool vertex/index bind.
+struct DrawBatch {
+  VertexFormat vertexFormat;
+  uint32_t firstCommand;
+  uint32_t commandCount;
+};
+
 struct Cluster {
   glm::vec4 minPoint;
   glm::vec4 maxPoint;
@@ -47,6 +69,8 @@ public:
   // Material management
   uint32_t addMaterial(const MaterialMetadata &material);
   void updateMaterial(uint32_t index, const MaterialMetadata &material);
+  // Points every material and model using bindless texture slot from at to
+  void remapTexture(uint32_t from, uint32_t to);
 
   const std::vector<MaterialMetadata> &getMaterials() const {
     return m_materials;
@@ -71,19 +95,63 @@ public:
   uint32_t getIndirectBufferIndex(uint32_t frameIndex) const {
     return m_indirectBufferIndices[frameIndex];
   }
+
+  // Device addresses of the buffers the draw and cull shaders read through
+  // buffer_reference pointers
+  VkDeviceAddress getSceneBufferAddress(uint32_t frameIndex) const {
+    return m_sceneBuffers[frameIndex]->getDeviceAddress();
+  }
+  VkDeviceAddress getMeshInstanceBufferAddress(uint32_t frameIndex) const {
+    return m_meshInstanceBuffers[frameIndex]->getDeviceAddress();
+  }
+  VkDeviceAddress getMaterialBufferAddress() const {
+    return m_materialBuffer->getDeviceAddress();
+  }
+  VkDeviceAddress getLightBufferAddress(uint32_t frameIndex) const {
+    return m_lightBuffers[frameIndex]->getDeviceAddress();
+  }
   uint32_t getClusterBufferIndex() const { return m_clusterBufferIndex; }
   uint32_t getLightIndexBufferIndex() const { return m_lightIndexBufferIndex; }
 
   void addMeshInstance(uint32_t frameIndex, const glm::mat4 &transform,
                        uint32_t materialIndex, uint32_t indexCount,
                        uint32_t firstIndex, int vertexOffset,
-                       const glm::vec3 &center, float radius);
-  void prepareIndirectCommands();
+                       const glm::vec3 &center, float radius,
+                       VertexFormat vertexFormat = VertexFormat::Standard,
+                       const glm::vec3 &positionOffset = glm::vec3(0.0f),
+                       const glm::vec3 &positionScale = glm::vec3(1.0f));
+  // Adds one primitive of a pool-resident model
+  void addMeshInstance(uint32_t frameIndex, const Model &model,
+                       const Primitive &primitive, const glm::mat4 &transform);
+  // Adds one instance per primitive of every mesh node in the model. All
+  // instances reference the model's shared pool geometry.
+  void addModelInstances(uint32_t frameIndex, const Model &model,
+                         const glm::mat4 &transform = glm::mat4(1.0f));
+  // Groups the frame's instances by vertex format and uploads instances and
+  // indirect commands in one pass. Call once after all instances are added.
+  void prepareIndirectCommands(uint32_t frameIndex);
   void clearMeshInstances(uint32_t frameIndex);
 
+  const std::vector<DrawBatch> &getDrawBatches(uint32_t frameIndex) const {
+    return m_drawBatchesPerFrame[frameIndex];
+  }
+
+  GeometryPool &getGeometryPool() { return *m_geometryPool; }
+
+  // Models drawn every frame. Async loads publish here once their geometry
+  // is resident.
+  void addModel(std::shared_ptr<Model> model);
+  void removeModel(const Model *model);
+  const std::vector<std::shared_ptr<Model>> &getModels() const {
+    return m_models;
+  }
+
   size_t getMeshInstanceCount(uint32_t frameIndex) const {
     return m_meshInstancesPerFrame[frameIndex].size();
   }
+  const std::vector<MeshInstance> &getMeshInstances(uint32_t frameIndex) const {
+    return m_meshInstancesPerFrame[frameIndex];
+  }
 
   VkBuffer getMeshInstanceBuffer(uint32_t frameIndex) const {
     return m_meshInstanceBuffers[frameIndex]->getHandle();
@@ -91,6 +159,24 @@ public:
   VkBuffer getIndirectBuffer(uint32_t frameIndex) const {
     return m_indirectBuffers[frameIndex]->getHandle();
   }
+
+  // Compacted cluster draws written by meshlet_cull.comp. Each VertexFormat
+  // owns MAX_MESHLET_DRAWS commands starting at format * MAX_MESHLET_DRAWS,
+  // and its draw count is the uint at index format of the count buffer.
+  VkBuffer getMeshletDrawBuffer(uint32_t frameIndex) const {
+    return m_meshletDrawBuffers[frameIndex]->getHandle();
+  }
+  VkBuffer getMeshletCountBuffer(uint32_t frameIndex) const {
+    return m_meshletCountBuffers[frameIndex]->getHandle();
+  }
+  uint32_t getMeshletDrawBufferIndex(uint32_t frameIndex) const {
+    return m_meshletDrawBufferIndices[frameIndex];
+  }
+  uint32_t getMeshletCountBufferIndex(uint32_t frameIndex) const {
+    return m_meshletCountBufferIndices[frameIndex];
+  }
+
+  static constexpr uint32_t MAX_MESHLET_DRAWS = 1u << 17;
   VkBuffer getClusterBuffer() const { return m_clusterBuffer->getHandle(); }
   VkBuffer getLightIndexBuffer() const {
     return m_lightIndexBuffer->getHandle();
@@ -98,12 +184,13 @@ public:
 
 private:
   Context *m_context;
-  static const int MAX_FRAMES_IN_FLIGHT = 2;
 
   std::vector<std::unique_ptr<Buffer>> m_sceneBuffers;
   std::vector<std::unique_ptr<Buffer>> m_meshInstanceBuffers;
   std::vector<std::unique_ptr<Buffer>> m_indirectBuffers;
   std::vector<std::unique_ptr<Buffer>> m_lightBuffers;
+  std::vector<std::unique_ptr<Buffer>> m_meshletDrawBuffers;
+  std::vector<std::unique_ptr<Buffer>> m_meshletCountBuffers;
 
   // Static buffers (update rarely or handled differently)
   std::unique_ptr<Buffer> m_materialBuffer;
@@ -114,6 +201,8 @@ private:
   std::vector<uint32_t> m_meshInstanceBufferIndices;
   std::vector<uint32_t> m_indirectBufferIndices;
   std::vector<uint32_t> m_lightBufferIndices;
+  std::vector<uint32_t> m_meshletDrawBufferIndices;
+  std::vector<uint32_t> m_meshletCountBufferIndices;
 
   uint32_t m_materialBufferIndex;
   uint32_t m_clusterBufferIndex;
@@ -125,10 +214,17 @@ private:
   // Per frame instance data
   std::vector<std::vector<MeshInstance>>
       m_meshInstancesPerFrame; // [frame][instance]
+  std::vector<std::vector<VkDrawIndexedIndirectCommand>>
+      m_indirectCommandsPerFrame; // [frame][instance]
+  std::vector<std::vector<DrawBatch>> m_drawBatchesPerFrame;
+
+  std::unique_ptr<GeometryPool> m_geometryPool;
+  // Declared after the pool: models release their pool ranges on destruction
+  std::vector<std::shared_ptr<Model>> m_models;
 
   static constexpr uint32_t MAX_MATERIALS = 1000;
   static constexpr uint32_t MAX_LIGHTS = 256;
-  static constexpr uint32_t MAX_MESH_INSTANCES = 10000;
+  static constexpr uint32_t MAX_MESH_INSTANCES = 65536;
 };
 
 } // namespace astral
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "astral/core/context.hpp"
+#include "astral/resources/image.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace astral {
+
+// An uploaded image shared by every model whose source bytes hash to the
+// same key. Models hold it through shared_ptr, so the image is released
+// with the last model that uses it.
+struct CachedImage {
+    ~CachedImage(); // Unregisters bindlessIndices and retires the image with them
+
+    uint64_t key = 0;
+    std::unique_ptr<Image> image;
+    // Bindless combined image sampler indices, one per sampler used with it
+    std::vector<std::pair<VkSampler, uint32_t>> bindlessIndices;
+    Context* context = nullptr; // Set with the first bindless index
+};
+
+// Content addressed image cache. Keys are a hash of the encoded source
+// bytes (file or buffer view contents) and the upload format, so identical
+// textures referenced by different models, or by different glTF images of
+// one model, share one Image and one bindless index per sampler.
+//
+// The cache only holds weak references. find() is thread-safe so import
+// workers can skip decoding images that are already resident; insert() and
+// getBindlessIndex() are main thread only.
+class TextureCache {
+public:
+    explicit TextureCache(Context* context);
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    static uint64_t computeKey(const void* data, size_t size, VkFormat format);
+
+    // Live entry for key, or null
+    std::shared_ptr<CachedImage> find(uint64_t key) const;
+
+    // Takes ownership of a freshly created image. The caller records its
+    // upload; the image must not be sampled before that upload completes.
+    std::shared_ptr<CachedImage> insert(uint64_t key, std::unique_ptr<Image> image);
+
+    // Registers the image with sampler in the bindless table on first use
+    uint32_t getBindlessIndex(CachedImage& entry, VkSampler sampler);
+
+    // Number of live images
+    size_t size() const;
+
+private:
+    Context* m_context;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<uint64_t, std::weak_ptr<CachedImage>> m_images;
+};
+
+} // namespace astral
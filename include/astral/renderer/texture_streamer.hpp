@@ -0,0 +1,112 @@
+#pragma once
+
+#include "astral/core/context.hpp"
+#include <glm/glm.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace astral {
+
+class SceneManager;
+struct CachedImage;
+
+// CPU copy of a full RGBA8 mip chain, finest level first, tightly packed
+struct MipChain {
+    struct Level {
+        uint32_t width;
+        uint32_t height;
+        size_t offset; // Bytes from the start of data
+        size_t size;
+    };
+    std::vector<Level> levels;
+    std::vector<uint8_t> data;
+
+    bool empty() const { return levels.empty(); }
+};
+
+// Builds every level down to 1x1 with a 2x2 box filter. With srgb set the
+// color channels are averaged in linear space; alpha is always linear.
+MipChain generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb);
+
+// Progressive residency for glTF textures. add() uploads only the mip tail
+// of a texture, so it is drawable as soon as that small upload completes;
+// update() then streams finer levels in, most needed first, within a per
+// frame byte budget. Each time more detail is resident the image view is
+// rebuilt to cover it and registered in fresh bindless slots; the next
+// update() repoints the scene's materials to them and retires the old slots
+// and view once no frame in flight can sample them.
+//
+// The full mip chain is allocated up front and the finer levels are only
+// left unwritten; the streamer bounds upload bandwidth, not VRAM.
+//
+// Main thread only, like UploadManager.
+class TextureStreamer {
+public:
+    // Levels no larger than this in either dimension form the mip tail
+    static constexpr uint32_t TAIL_SIZE = 64;
+
+    explicit TextureStreamer(Context* context);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Records the mip tail upload into the current UploadManager batch and
+    // points the image view at it. The image must have been created with all
+    // levels of mips. Finer levels are kept for streaming. Returns the bytes
+    // staged.
+    VkDeviceSize add(const std::shared_ptr<CachedImage>& entry, MipChain mips);
+
+    // Call once per frame after the frame fence wait and the upload poll.
+    // Instances of frameIndex (the previous frame) give each texture a wanted
+    // level from their projected size; textures furthest from theirs are
+    // streamed first, the rest progress one level at a time in the
+    // background.
+    void update(SceneManager& scene, uint32_t frameIndex, const glm::vec3& cameraPosition,
+                const glm::mat4& projection, float viewportHeight);
+
+    // Mip bytes staged per update() call; at least one level is always staged
+    void setUploadBudget(VkDeviceSize bytesPerFrame) { m_uploadBudget = bytesPerFrame; }
+
+    // Textures with levels still to upload
+    size_t getPendingCount() const { return m_textures.size(); }
+
+private:
+    struct StreamedTexture {
+        std::weak_ptr<CachedImage> entry;
+        MipChain mips;
+        uint32_t residentMip = 0; // Finest level covered by the image view
+        uint32_t wantedMip = 0;   // From the last update, valid when visible
+        float screenSize = 0.0f;  // Largest projected diameter in pixels, 0 = not drawn
+        bool uploading = false;
+    };
+
+    struct RetiredView {
+        VkImageView view;
+        std::shared_ptr<CachedImage> owner; // The view must not outlive its image
+        uint64_t frame;
+    };
+
+    // A view replacement whose old slots the scene still refers to
+    struct Promotion {
+        std::shared_ptr<CachedImage> entry;
+        VkImageView oldView;
+        std::vector<std::pair<uint32_t, uint32_t>> slots; // Old, new bindless index
+    };
+
+    void assignPriorities(const SceneManager& scene, uint32_t frameIndex, const glm::vec3& cameraPosition,
+                          const glm::mat4& projection, float viewportHeight);
+    void makeResident(StreamedTexture& texture, const std::shared_ptr<CachedImage>& entry, uint32_t mip);
+
+    Context* m_context;
+    std::vector<std::unique_ptr<StreamedTexture>> m_textures; // Stable addresses for upload callbacks
+    std::vector<RetiredView> m_retiredViews;
+    std::vector<Promotion> m_promotions;
+    uint64_t m_frame = 0;
+    VkDeviceSize m_uploadBudget = 8ull * 1024 * 1024;
+};
+
+} // namespace astral
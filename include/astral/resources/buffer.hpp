@@ -21,12 +21,16 @@ public:
     VkBuffer getHandle() const { return m_buffer; }
     VmaAllocation getAllocation() const { return m_allocation; }
     VkDeviceSize getSize() const { return m_size; }
+    // 0 unless the buffer has VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT, which
+    // storage buffers always get
+    VkDeviceAddress getDeviceAddress() const { return m_deviceAddress; }
 
 private:
     Context* m_context;
     VkBuffer m_buffer;
     VmaAllocation m_allocation;
     VkDeviceSize m_size;
+    VkDeviceAddress m_deviceAddress = 0;
     void* m_mappedData = nullptr;
 };
 
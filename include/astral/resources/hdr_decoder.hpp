@@ -0,0 +1,42 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace astral {
+
+class ThreadPool;
+
+// Radiance RGBE (.hdr) decoding straight into GPU texel formats, without a
+// 32-bit float intermediate. Supported outputs are
+// VK_FORMAT_E5B9G9R9_UFLOAT_PACK32 (4 bytes per texel, the RGBE mantissas
+// lose no precision) and VK_FORMAT_R16G16B16A16_SFLOAT (8 bytes, alpha 1).
+
+struct HdrInfo {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t dataOffset = 0; // Start of the first scanline
+};
+
+// Parses the header. Returns false for anything that is not a top-down,
+// left-to-right RGBE picture.
+bool readHdrInfo(const void* data, size_t size, HdrInfo& info);
+
+// Bytes per texel of a supported output format, 0 otherwise
+size_t getHdrTexelSize(VkFormat format);
+
+// Decodes every scanline into output (width * height * texel size bytes),
+// bottom row first when flipVertically is set. Scanlines are RLE decoded in
+// chunks of rows while a pool worker converts the previous chunk, so only
+// two chunks of RGBE are held besides the output. pool may be null; calling
+// from a pool task is safe. Returns false for malformed or truncated data.
+bool decodeHdr(const void* data, size_t size, const HdrInfo& info, VkFormat format, bool flipVertically,
+               void* output, ThreadPool* pool);
+
+// Converts linear float RGBA rows (e.g. from stb_image) to format, in
+// parallel row chunks when pool is set
+void convertFloatRgba(const float* rgba, uint32_t width, uint32_t height, VkFormat format, bool flipVertically,
+                      void* output, ThreadPool* pool);
+
+} // namespace astral
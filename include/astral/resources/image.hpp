@@ -33,6 +33,10 @@ public:
     VkImageView getView() const { return m_view; }
     const ImageSpecs& getSpecs() const { return m_specs; }
 
+    // Points the view at mips [baseMipLevel, mipLevels) and returns the
+    // previous view; the caller destroys it once no frame uses it anymore
+    VkImageView replaceView(uint32_t baseMipLevel);
+
     void upload(const void* data, VkDeviceSize size);
 
 private:
@@ -42,7 +46,7 @@ private:
     VmaAllocation m_allocation;
     VkImageView m_view;
 
-    void createView();
+    void createView(uint32_t baseMipLevel = 0);
 };
 
 } // namespace astral
@@ -1,8 +1,12 @@
 #include "astral/application.hpp"
+#include "astral/core/asset_file.hpp"
+#include "astral/renderer/texture_streamer.hpp"
 #include <GLFW/glfw3.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <imgui.h>
+#include <algorithm>
 #include <cstdio>
+#include <filesystem>
 #include <spdlog/spdlog.h>
 
 namespace astral {
@@ -16,6 +20,18 @@ void Application::init() {
   spdlog::set_level(spdlog::level::debug);
   spdlog::info("Starting Astral Renderer Sandbox (Refactored)...");
 
+  // Built by the astral_assets target next to the executable; loose files
+  // under assets/ are used for anything it does not contain
+  if (std::filesystem::exists("assets.pak")) {
+    try {
+      auto archive = std::make_shared<const AssetArchive>("assets.pak");
+      spdlog::info("Mounted assets.pak ({} entries)", archive->size());
+      mountAssetArchive(std::move(archive), "assets");
+    } catch (const std::exception &e) {
+      spdlog::warn("Ignoring assets.pak: {}", e.what());
+    }
+  }
+
   WindowSpecs specs;
   specs.title = "Astral Renderer - glTF PBR Sandbox";
   specs.width = 1600;
@@ -24,14 +40,14 @@ void Application::init() {
   m_window = std::make_unique<Window>(specs);
   m_context = std::make_unique<Context>(m_window.get());
   m_swapchain = std::make_unique<Swapchain>(m_context.get(), m_window.get());
-  m_sync = std::make_unique<FrameSync>(m_context.get(), 2);
+  m_sync = std::make_unique<FrameSync>(m_context.get(), MAX_FRAMES_IN_FLIGHT);
 
   // Command Pool
   m_commandPool = std::make_unique<CommandPool>(
       m_context.get(),
       m_context->getQueueFamilyIndices().graphicsFamily.value());
 
-  for (int i = 0; i < 2; i++) { // Max frames in flight
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
     m_commandBuffers.push_back(m_commandPool->allocateBuffer());
   }
 
@@ -107,12 +123,29 @@ void Application::init() {
 void Application::initScene() {
   // Load Skybox
   std::string hdrPath = "assets/textures/skybox.hdr";
-  if (std::filesystem::exists(hdrPath)) {
+  if (AssetFile::exists(hdrPath)) {
+    m_envManager->setCacheDirectory("cache/ibl");
     m_envManager->loadHDR(hdrPath);
   } else {
     spdlog::warn("Skybox HDR not found at: {}. IBL will be disabled.", hdrPath);
   }
 
+  // Every HDR next to the default skybox can be switched to at runtime
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator("assets/textures", ec)) {
+    if (entry.path().extension() == ".hdr") {
+      m_environmentPaths.push_back(entry.path().generic_string());
+    }
+  }
+  std::sort(m_environmentPaths.begin(), m_environmentPaths.end());
+  auto current = std::find(m_environmentPaths.begin(),
+                           m_environmentPaths.end(), hdrPath);
+  m_selectedEnvironment =
+      current != m_environmentPaths.end()
+          ? (int)(current - m_environmentPaths.begin())
+          : 0;
+
   MaterialMetadata defaultMat;
   defaultMat.baseColorFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
   defaultMat.metallicFactor = 0.5f;
@@ -132,11 +165,12 @@ void Application::initScene() {
   m_camera.setPosition(glm::vec3(0.0f, 0.0f, 5.0f));
 
   // Load Model
-  m_model = m_loader->loadFromFile("assets/models/damaged_helmet/scene.gltf",
-                                   m_sceneManager.get());
-  if (!m_model) {
-    spdlog::warn("Model not found, creating fallback (empty)...");
-  }
+  GltfLoadOptions loadOptions;
+  loadOptions.vertexFormat = VertexFormat::Packed;
+  loadOptions.meshCacheDirectory = "cache/meshes";
+  // Streams in while the first frames render; published by GltfLoader::update
+  m_modelLoad = m_loader->loadAsync("assets/models/damaged_helmet/scene.gltf",
+                                    m_sceneManager.get(), loadOptions);
 
   // Default Lights
   {
@@ -348,9 +382,6 @@ void Application::run() {
     sd.shadowNormalBias = m_uiParams.shadowNormalBias;
     sd.pcfRange = m_uiParams.pcfRange;
     sd.csmLambda = m_uiParams.csmLambda;
-    sd.irradianceIndex = m_envManager->getIrradianceIndex();
-    sd.prefilteredIndex = m_envManager->getPrefilteredIndex();
-    sd.brdfLutIndex = m_envManager->getBrdfLutIndex();
     // map index and others are filled by RendererSystem when setting up
     // resources? Actually sceneData expects binding indices. RendererSystem
     // should expose the indices it registered. We'll update the remaining
@@ -370,6 +401,32 @@ void Application::run() {
     sd.screenHeight = (float)m_window->getHeight();
 
     m_sync->waitForFrame(m_currentFrame);
+    m_sceneManager->getGeometryPool().beginFrame();
+    m_context->getDescriptorManager().beginFrame();
+    m_loader->update();
+    // Prioritize texture detail by what the previous frame drew
+    m_loader->getTextureStreamer().update(
+        *m_sceneManager, (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT, m_camera.getPosition(),
+        m_camera.getProjectionMatrix(), sd.screenHeight);
+    // May swap in a finished environment bake, so read the IBL state after
+    m_envManager->update();
+    sd.iblEnabled = m_envManager->hasEnvironment() ? 1 : 0;
+    const auto &irradianceSH = m_envManager->getIrradianceSH();
+    std::copy(irradianceSH.begin(), irradianceSH.end(), sd.irradianceSH);
+    sd.prefilteredIndex = m_envManager->getPrefilteredIndex();
+    sd.brdfLutIndex = m_envManager->getBrdfLutIndex();
+    if (m_modelLoad && m_modelLoad->isDone()) {
+      if (m_modelLoad->state == ModelLoadState::Failed) {
+        spdlog::warn("Model not found, continuing with an empty scene...");
+      }
+      m_modelLoad.reset();
+      m_renderer->getReflectionProbes().invalidateAll();
+    }
+    if (m_envManager->getSkyboxIndex() != m_lastSkyboxIndex) {
+      // The probes captured the previous sky
+      m_lastSkyboxIndex = m_envManager->getSkyboxIndex();
+      m_renderer->getReflectionProbes().invalidateAll();
+    }
 
     // Update Buffers
     m_sceneManager->updateLightsBuffer(m_currentFrame);
@@ -399,16 +456,10 @@ void Application::run() {
     // Clear instances
     m_sceneManager->clearMeshInstances(m_currentFrame);
     // Re-add instances
-    if (m_model) {
-      for (const auto &mesh : m_model->meshes) {
-        for (const auto &primitive : mesh.primitives) {
-          m_sceneManager->addMeshInstance(
-              m_currentFrame, glm::mat4(1.0f), primitive.materialIndex,
-              primitive.indexCount, primitive.firstIndex, 0,
-              primitive.boundingCenter, primitive.boundingRadius);
-        }
-      }
+    for (const auto &model : m_sceneManager->getModels()) {
+      m_sceneManager->addModelInstances(m_currentFrame, *model);
     }
+    m_sceneManager->prepareIndirectCommands(m_currentFrame);
 
     // DEBUG: Log mesh instance count
     spdlog::debug("Frame {}: Mesh instances: {}", m_currentFrame, 
@@ -416,7 +467,7 @@ void Application::run() {
 
     m_renderer->render(*cmd.get(), graph, *m_sceneManager.get(), m_currentFrame,
                        imageIndex, sd, m_swapchain.get(), m_sync.get(),
-                       m_uiParams, m_model.get(), m_envManager->getSkyboxIndex());
+                       m_uiParams, m_envManager->getSkyboxIndex());
     
     // Inject UI Pass (Overlay)
     // Depends on whatever the last pass wrote to "Swapchain".
@@ -434,14 +485,30 @@ void Application::run() {
 
     cmd->end();
 
-    // Submit
+    // Descriptors registered while the frame was built
+    m_context->getDescriptorManager().flush();
+
+    // Submit. Maps the environment manager swapped in this frame were baked
+    // on another queue; waiting on its timeline makes them visible here.
+    VkSemaphore waitSemaphores[] = {
+        m_sync->getImageAvailableSemaphore(m_currentFrame),
+        m_envManager->getTimeline()};
     VkPipelineStageFlags waitStages[] = {
-        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+    const uint64_t waitValues[] = {0, m_envManager->takeSwapWaitValue()};
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo = {
+        VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+    timelineInfo.waitSemaphoreValueCount = 2;
+    timelineInfo.pWaitSemaphoreValues = waitValues;
+
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores =
-        &m_sync->getImageAvailableSemaphore(m_currentFrame);
+    submitInfo.pNext = waitValues[1] != 0 ? &timelineInfo : nullptr;
+    submitInfo.waitSemaphoreCount = waitValues[1] != 0 ? 2 : 1;
+    submitInfo.pWaitSemaphores = waitSemaphores;
     submitInfo.pWaitDstStageMask = waitStages;
     submitInfo.commandBufferCount = 1;
     VkCommandBuffer buffer = cmd->getHandle();
@@ -465,7 +532,7 @@ void Application::run() {
 
     vkQueuePresentKHR(m_context->getPresentQueue(), &presentInfo);
 
-    m_currentFrame = (m_currentFrame + 1) % 2;
+    m_currentFrame = (m_currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
   }
 
   vkDeviceWaitIdle(m_context->getDevice());
@@ -516,6 +583,25 @@ void Application::updateUI(float deltaTime) {
       ImGui::DragFloat("Exposure", &m_uiParams.exposure, 0.01f, 0.0f, 10.0f);
       ImGui::DragFloat("Gamma", &m_uiParams.gamma, 0.01f, 0.5f, 5.0f);
       ImGui::DragFloat("IBL Intensity", &m_uiParams.iblIntensity, 0.01f, 0.0f, 5.0f);
+      if (!m_environmentPaths.empty()) {
+        const char *preview =
+            m_environmentPaths[m_selectedEnvironment].c_str();
+        if (ImGui::BeginCombo("Environment", preview)) {
+          for (int i = 0; i < (int)m_environmentPaths.size(); ++i) {
+            bool selected = i == m_selectedEnvironment;
+            if (ImGui::Selectable(m_environmentPaths[i].c_str(), selected) &&
+                !selected) {
+              m_selectedEnvironment = i;
+              m_envManager->requestEnvironment(m_environmentPaths[i]);
+            }
+          }
+          ImGui::EndCombo();
+        }
+        if (m_envManager->isLoading()) {
+          ImGui::SameLine();
+          ImGui::TextDisabled("Loading...");
+        }
+      }
       
       ImGui::Separator();
       ImGui::Checkbox("Show Skybox", &m_uiParams.showSkybox);
@@ -543,6 +629,27 @@ void Application::updateUI(float deltaTime) {
         ImGui::Checkbox("Enable FXAA", &m_uiParams.enableFXAA);
       }
 
+      if (ImGui::CollapsingHeader("Geometry", ImGuiTreeNodeFlags_DefaultOpen)) {
+        ImGui::DragFloat("LOD Error (px)", &m_uiParams.lodErrorThreshold, 0.05f, 0.0f, 16.0f);
+      }
+
+      if (ImGui::CollapsingHeader("Reflection Probes", ImGuiTreeNodeFlags_DefaultOpen)) {
+        auto &probes = m_renderer->getReflectionProbes();
+        ImGui::SliderInt("Capture Steps / Frame", &m_uiParams.probeFacesPerFrame, 0,
+                         (int)ReflectionProbeManager::MAX_STEPS_PER_FRAME);
+        ImGui::DragFloat("Box Half Extent", &m_probeHalfExtent, 0.1f, 0.5f, 50.0f);
+        if (ImGui::Button("Add Probe at Camera")) {
+          glm::vec3 position = m_camera.getPosition();
+          glm::vec3 extent(m_probeHalfExtent);
+          probes.addProbe(position, position - extent, position + extent);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Recapture")) {
+          probes.invalidateAll();
+        }
+        ImGui::Text("Probes: %u / %u", probes.getProbeCount(), ReflectionProbeManager::MAX_PROBES);
+      }
+
       ImGui::EndTabItem();
     }
 
@@ -0,0 +1,278 @@
+#include "astral/core/asset_archive.hpp"
+#include "astral/core/hash.hpp"
+#include "astral/core/lz4.hpp"
+#include "astral/core/thread_pool.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <type_traits>
+
+namespace astral {
+
+namespace {
+
+constexpr uint32_t ARCHIVE_MAGIC = 0x43524141; // "AARC"
+constexpr uint32_t ARCHIVE_VERSION = 1;
+
+struct ArchiveHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t alignment;
+    uint32_t entryCount;
+    uint64_t tocOffset; // ArchiveEntry[entryCount], then the name table
+    uint64_t namesSize;
+};
+
+static_assert(std::is_trivially_copyable_v<ArchiveEntry>, "ArchiveEntry is stored as raw bytes");
+static_assert(sizeof(ArchiveEntry) == 56, "ArchiveEntry layout is part of the file format");
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+std::string normalizeArchivePath(std::string_view path) {
+    std::vector<std::string_view> parts;
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        std::string_view part = path.substr(start, end - start);
+        if (part == "..") {
+            if (!parts.empty()) {
+                parts.pop_back();
+            }
+        } else if (!part.empty() && part != ".") {
+            parts.push_back(part);
+        }
+        start = end + 1;
+    }
+
+    std::string result;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        if (i > 0) {
+            result += '/';
+        }
+        result += parts[i];
+    }
+    return result;
+}
+
+AssetArchive::AssetArchive(const std::filesystem::path& path) : m_file(path) {
+    const std::byte* data = m_file.data();
+    const size_t fileSize = m_file.size();
+
+    ArchiveHeader header;
+    if (fileSize < sizeof(header)) {
+        throw std::runtime_error("Asset archive is truncated: " + path.string());
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (header.magic != ARCHIVE_MAGIC || header.version != ARCHIVE_VERSION) {
+        throw std::runtime_error("Not a supported asset archive: " + path.string());
+    }
+
+    const uint64_t tocSize = static_cast<uint64_t>(header.entryCount) * sizeof(ArchiveEntry);
+    if (header.tocOffset % alignof(ArchiveEntry) != 0 || header.tocOffset > fileSize ||
+        tocSize > fileSize - header.tocOffset || header.namesSize > fileSize - header.tocOffset - tocSize) {
+        throw std::runtime_error("Asset archive has a corrupt table of contents: " + path.string());
+    }
+
+    m_entries = reinterpret_cast<const ArchiveEntry*>(data + header.tocOffset);
+    m_entryCount = header.entryCount;
+    m_names = reinterpret_cast<const char*>(data + header.tocOffset + tocSize);
+    m_namesSize = header.namesSize;
+
+    // Validate every range once so lookups and reads need no checks
+    for (const ArchiveEntry& entry : *this) {
+        bool valid = entry.offset <= header.tocOffset && entry.storedSize <= header.tocOffset - entry.offset &&
+                     entry.nameOffset <= m_namesSize && entry.nameLength <= m_namesSize - entry.nameOffset;
+        switch (entry.compression) {
+            case ArchiveCompression::None:
+                valid = valid && entry.storedSize == entry.size;
+                break;
+            case ArchiveCompression::LZ4:
+                break;
+            default:
+                valid = false;
+                break;
+        }
+        if (!valid) {
+            throw std::runtime_error("Asset archive has a corrupt entry: " + path.string());
+        }
+    }
+
+    // Every lookup touches the TOC and name table, so fault them in now
+    m_file.advise(MappedFile::Access::WillNeed, header.tocOffset, tocSize + m_namesSize);
+}
+
+const ArchiveEntry* AssetArchive::find(std::string_view path) const {
+    std::string normalized = normalizeArchivePath(path);
+    const uint64_t hash = hashString(normalized);
+
+    const ArchiveEntry* it = std::lower_bound(begin(), end(), hash, [](const ArchiveEntry& entry, uint64_t value) {
+        return entry.pathHash < value;
+    });
+    for (; it != end() && it->pathHash == hash; ++it) {
+        if (getName(*it) == normalized) {
+            return it;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view AssetArchive::getName(const ArchiveEntry& entry) const {
+    return std::string_view(m_names + entry.nameOffset, entry.nameLength);
+}
+
+const std::byte* AssetArchive::getStoredData(const ArchiveEntry& entry) const {
+    return m_file.data() + entry.offset;
+}
+
+void AssetArchive::readInto(const ArchiveEntry& entry, void* destination) const {
+    const std::byte* stored = getStoredData(entry);
+    switch (entry.compression) {
+        case ArchiveCompression::None:
+            std::memcpy(destination, stored, entry.size);
+            break;
+        case ArchiveCompression::LZ4:
+            if (!lz4Decompress(stored, entry.storedSize, destination, entry.size)) {
+                throw std::runtime_error("Corrupt LZ4 data in asset archive entry: " + std::string(getName(entry)));
+            }
+            break;
+    }
+}
+
+std::vector<std::byte> AssetArchive::read(const ArchiveEntry& entry) const {
+    std::vector<std::byte> data(entry.size);
+    readInto(entry, data.data());
+    return data;
+}
+
+std::vector<std::vector<std::byte>> AssetArchive::readAll(const std::vector<const ArchiveEntry*>& entries,
+                                                          ThreadPool* pool) const {
+    std::vector<std::vector<std::byte>> results(entries.size());
+    auto readEntry = [&](size_t i) { results[i] = read(*entries[i]); };
+    if (pool) {
+        pool->parallelFor(entries.size(), readEntry);
+    } else {
+        for (size_t i = 0; i < entries.size(); ++i) {
+            readEntry(i);
+        }
+    }
+    return results;
+}
+
+AssetArchiveWriter::AssetArchiveWriter(uint32_t alignment) : m_alignment(alignment) {
+    if (alignment < alignof(ArchiveEntry) || (alignment & (alignment - 1)) != 0) {
+        throw std::runtime_error("Asset archive alignment must be a power of two of at least 8");
+    }
+}
+
+void AssetArchiveWriter::add(std::string path, std::vector<std::byte> data, ArchiveCompression compression) {
+    m_pending.push_back({normalizeArchivePath(path), std::move(data), compression});
+}
+
+void AssetArchiveWriter::write(const std::filesystem::path& path, ThreadPool* pool) {
+    std::sort(m_pending.begin(), m_pending.end(), [](const PendingEntry& a, const PendingEntry& b) {
+        return a.path < b.path;
+    });
+    for (size_t i = 1; i < m_pending.size(); ++i) {
+        if (m_pending[i].path == m_pending[i - 1].path) {
+            throw std::runtime_error("Duplicate asset archive path: " + m_pending[i].path);
+        }
+    }
+
+    // Compress every entry; the stored bytes replace the source bytes
+    std::vector<ArchiveEntry> entries(m_pending.size());
+    auto compressEntry = [&](size_t i) {
+        PendingEntry& pending = m_pending[i];
+        ArchiveEntry& entry = entries[i];
+        entry = {};
+        entry.pathHash = hashString(pending.path);
+        entry.size = pending.data.size();
+        entry.contentHash = hashBytes(pending.data.data(), pending.data.size());
+        entry.compression = ArchiveCompression::None;
+
+        if (pending.compression == ArchiveCompression::LZ4 && !pending.data.empty()) {
+            std::vector<std::byte> compressed(lz4CompressBound(pending.data.size()));
+            // Require a 1/16 saving, otherwise decompression is not worth it
+            size_t capacity = pending.data.size() - pending.data.size() / 16;
+            size_t compressedSize = lz4Compress(pending.data.data(), pending.data.size(), compressed.data(),
+                                                std::min(capacity, compressed.size()));
+            if (compressedSize > 0) {
+                compressed.resize(compressedSize);
+                pending.data = std::move(compressed);
+                entry.compression = ArchiveCompression::LZ4;
+            }
+        }
+        entry.storedSize = pending.data.size();
+    };
+    if (pool) {
+        pool->parallelFor(m_pending.size(), compressEntry);
+    } else {
+        for (size_t i = 0; i < m_pending.size(); ++i) {
+            compressEntry(i);
+        }
+    }
+
+    // Lay out data, then the TOC sorted by path hash, then the names
+    std::string names;
+    uint64_t offset = alignUp(sizeof(ArchiveHeader), m_alignment);
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].offset = offset;
+        entries[i].nameOffset = static_cast<uint32_t>(names.size());
+        entries[i].nameLength = static_cast<uint32_t>(m_pending[i].path.size());
+        names += m_pending[i].path;
+        offset = alignUp(offset + entries[i].storedSize, m_alignment);
+    }
+
+    std::vector<uint32_t> order(entries.size());
+    for (uint32_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return entries[a].pathHash < entries[b].pathHash;
+    });
+
+    ArchiveHeader header = {};
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.alignment = m_alignment;
+    header.entryCount = static_cast<uint32_t>(entries.size());
+    header.tocOffset = offset;
+    header.namesSize = names.size();
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to open asset archive for writing: " + path.string());
+    }
+
+    const std::vector<char> zeros(m_alignment, 0);
+    auto padTo = [&](uint64_t position) {
+        uint64_t current = static_cast<uint64_t>(file.tellp());
+        file.write(zeros.data(), static_cast<std::streamsize>(position - current));
+    };
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (size_t i = 0; i < entries.size(); ++i) {
+        padTo(entries[i].offset);
+        file.write(reinterpret_cast<const char*>(m_pending[i].data.data()),
+                   static_cast<std::streamsize>(m_pending[i].data.size()));
+    }
+    padTo(header.tocOffset);
+    for (uint32_t i : order) {
+        file.write(reinterpret_cast<const char*>(&entries[i]), sizeof(ArchiveEntry));
+    }
+    file.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+    if (!file) {
+        throw std::runtime_error("Failed to write asset archive: " + path.string());
+    }
+    m_pending.clear();
+}
+
+} // namespace astral
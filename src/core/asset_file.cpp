@@ -0,0 +1,71 @@
+#include "astral/core/asset_file.hpp"
+#include <stdexcept>
+
+namespace astral {
+
+namespace {
+
+struct ArchiveMount {
+    std::shared_ptr<const AssetArchive> archive;
+    std::filesystem::path root;
+};
+
+ArchiveMount& getMount() {
+    static ArchiveMount mount;
+    return mount;
+}
+
+// The archive entry for path, or null if it is outside the mounted root
+const ArchiveEntry* findMounted(const std::filesystem::path& path) {
+    const ArchiveMount& mount = getMount();
+    if (!mount.archive) {
+        return nullptr;
+    }
+    std::filesystem::path relative = path.lexically_normal().lexically_relative(mount.root);
+    if (relative.empty() || *relative.begin() == "..") {
+        return nullptr;
+    }
+    return mount.archive->find(relative.generic_string());
+}
+
+} // namespace
+
+void mountAssetArchive(std::shared_ptr<const AssetArchive> archive, const std::filesystem::path& root) {
+    getMount() = {std::move(archive), root.lexically_normal()};
+}
+
+AssetFile::AssetFile(const std::filesystem::path& path) : m_path(path) {
+    if (const ArchiveEntry* entry = findMounted(path)) {
+        m_archive = getMount().archive;
+        if (entry->compression == ArchiveCompression::None) {
+            m_data = m_archive->getStoredData(*entry);
+        } else {
+            m_decompressed = m_archive->read(*entry);
+            m_data = m_decompressed.data();
+        }
+        m_size = static_cast<size_t>(entry->size);
+        return;
+    }
+
+    m_file = std::make_unique<MappedFile>(path);
+    m_data = m_file->data();
+    m_size = m_file->size();
+}
+
+bool AssetFile::exists(const std::filesystem::path& path) {
+    std::error_code ec;
+    return findMounted(path) != nullptr || std::filesystem::is_regular_file(path, ec);
+}
+
+void AssetFile::advise(MappedFile::Access access, size_t offset, size_t size) const {
+    if (m_file) {
+        m_file->advise(access, offset, size);
+    }
+}
+
+std::string readAssetFile(const std::filesystem::path& path) {
+    AssetFile file(path);
+    return std::string(reinterpret_cast<const char*>(file.data()), file.size());
+}
+
+} // namespace astral
@@ -1,5 +1,7 @@
 #include "astral/core/context.hpp"
 #include "astral/platform/window.hpp"
+#include "astral/core/upload_manager.hpp"
+#include "astral/core/sampler_cache.hpp"
 #include "astral/renderer/descriptor_manager.hpp"
 #include <spdlog/spdlog.h>
 #include <stdexcept>
@@ -31,9 +33,13 @@ Context::Context(Window* window) : m_window(window) {
     createLogicalDevice();
     createAllocator();
     m_descriptorManager = std::make_unique<DescriptorManager>(this);
+    m_uploadManager = std::make_unique<UploadManager>(this);
+    m_samplerCache = std::make_unique<SamplerCache>(this);
 }
 
 Context::~Context() {
+    m_uploadManager.reset();
+    m_samplerCache.reset();
     m_descriptorManager.reset();
     vmaDestroyAllocator(m_allocator);
     vkDestroyDevice(m_device, nullptr);
@@ -162,8 +168,57 @@ bool Context::isDeviceSuitable(VkPhysicalDevice device) {
     VkPhysicalDeviceProperties deviceProperties;
     vkGetPhysicalDeviceProperties(device, &deviceProperties);
     bool apiVersionOk = deviceProperties.apiVersion >= VK_API_VERSION_1_3;
+    if (!indices.isComplete() || !apiVersionOk) {
+        return false;
+    }
 
-    return indices.isComplete() && apiVersionOk;
+    // Optional features createLogicalDevice enables unconditionally
+    VkPhysicalDeviceVulkan12Features features12{};
+    features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    VkPhysicalDeviceFeatures2 features{};
+    features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features.pNext = &features12;
+    vkGetPhysicalDeviceFeatures2(device, &features);
+
+    bool indirectOk = features12.drawIndirectCount && features.features.multiDrawIndirect &&
+                      features.features.drawIndirectFirstInstance;
+    if (!indirectOk) {
+        spdlog::info("Skipping {}: no multi draw indirect with count", deviceProperties.deviceName);
+        return false;
+    }
+    bool bindlessOk = features12.descriptorIndexing && features12.runtimeDescriptorArray &&
+                      features12.descriptorBindingPartiallyBound &&
+                      features12.descriptorBindingVariableDescriptorCount &&
+                      features12.shaderSampledImageArrayNonUniformIndexing &&
+                      features12.shaderStorageBufferArrayNonUniformIndexing &&
+                      features12.shaderStorageImageArrayNonUniformIndexing &&
+                      features12.descriptorBindingSampledImageUpdateAfterBind &&
+                      features12.descriptorBindingStorageBufferUpdateAfterBind &&
+                      features12.descriptorBindingStorageImageUpdateAfterBind &&
+                      features12.descriptorBindingUpdateUnusedWhilePending;
+    if (!bindlessOk) {
+        spdlog::info("Skipping {}: incomplete descriptor indexing for the bindless set", deviceProperties.deviceName);
+        return false;
+    }
+    if (!features.features.imageCubeArray) {
+        spdlog::info("Skipping {}: no cube map arrays for the reflection probe atlas", deviceProperties.deviceName);
+        return false;
+    }
+    return true;
+}
+
+bool Context::supportsExtension(VkPhysicalDevice device, const char* name) {
+    uint32_t extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions) {
+        if (strcmp(extension.extensionName, name) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 QueueFamilyIndices Context::findQueueFamilies(VkPhysicalDevice device) {
@@ -213,19 +268,46 @@ void Context::createLogicalDevice() {
         m_indices.transferFamily.value()
     };
 
-    float queuePriority = 1.0f;
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+    // The graphics family gets a second, lower priority queue for async compute
+    const uint32_t graphicsFamily = m_indices.graphicsFamily.value();
+    const bool asyncCompute = queueFamilies[graphicsFamily].queueCount > 1;
+    const float queuePriorities[] = {1.0f, 0.5f};
     for (uint32_t queueFamily : uniqueQueueFamilies) {
         VkDeviceQueueCreateInfo queueCreateInfo{};
         queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
         queueCreateInfo.queueFamilyIndex = queueFamily;
-        queueCreateInfo.queueCount = 1;
-        queueCreateInfo.pQueuePriorities = &queuePriority;
+        queueCreateInfo.queueCount = queueFamily == graphicsFamily && asyncCompute ? 2 : 1;
+        queueCreateInfo.pQueuePriorities = queuePriorities;
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
+    // Descriptor buffers for the bindless set, when supported
+    // (DescriptorManager falls back to a descriptor pool)
+#ifdef ASTRAL_DESCRIPTOR_BUFFER
+    if (supportsExtension(m_physicalDevice, VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME)) {
+        VkPhysicalDeviceDescriptorBufferFeaturesEXT supportedDescriptorBuffer{};
+        supportedDescriptorBuffer.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2 supportedFeatures{};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &supportedDescriptorBuffer;
+        vkGetPhysicalDeviceFeatures2(m_physicalDevice, &supportedFeatures);
+        m_descriptorBuffer = supportedDescriptorBuffer.descriptorBuffer == VK_TRUE;
+    }
+#endif
+
+    VkPhysicalDeviceDescriptorBufferFeaturesEXT descriptorBufferFeatures{};
+    descriptorBufferFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_FEATURES_EXT;
+    descriptorBufferFeatures.descriptorBuffer = VK_TRUE;
+
     // Vulkan 1.2 features
     VkPhysicalDeviceVulkan12Features features12{};
     features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    features12.drawIndirectCount = VK_TRUE; // Cluster culled main pass draws
     features12.descriptorIndexing = VK_TRUE;
     features12.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
     features12.shaderStorageBufferArrayNonUniformIndexing = VK_TRUE;
@@ -236,6 +318,12 @@ void Context::createLogicalDevice() {
     features12.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
     features12.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
     features12.descriptorBindingStorageImageUpdateAfterBind = VK_TRUE;
+    features12.descriptorBindingUpdateUnusedWhilePending = VK_TRUE; // Batched bindless writes
+    features12.timelineSemaphore = VK_TRUE; // Asynchronous environment bakes
+    features12.bufferDeviceAddress = VK_TRUE; // Required by 1.3; scene data pointers and descriptor buffers
+    if (m_descriptorBuffer) {
+        features12.pNext = &descriptorBufferFeatures;
+    }
 
     VkPhysicalDeviceVulkan13Features features13{};
     features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
@@ -245,6 +333,9 @@ void Context::createLogicalDevice() {
 
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.samplerAnisotropy = VK_TRUE;
+    deviceFeatures.multiDrawIndirect = VK_TRUE;
+    deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+    deviceFeatures.imageCubeArray = VK_TRUE; // Reflection probe atlas
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -256,6 +347,9 @@ void Context::createLogicalDevice() {
     std::vector<const char*> deviceExtensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
     };
+    if (m_descriptorBuffer) {
+        deviceExtensions.push_back(VK_EXT_DESCRIPTOR_BUFFER_EXTENSION_NAME);
+    }
     createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
     createInfo.ppEnabledExtensionNames = deviceExtensions.data();
 
@@ -267,8 +361,17 @@ void Context::createLogicalDevice() {
     vkGetDeviceQueue(m_device, m_indices.presentFamily.value(), 0, &m_presentQueue);
     vkGetDeviceQueue(m_device, m_indices.computeFamily.value(), 0, &m_computeQueue);
     vkGetDeviceQueue(m_device, m_indices.transferFamily.value(), 0, &m_transferQueue);
+    if (asyncCompute) {
+        vkGetDeviceQueue(m_device, graphicsFamily, 1, &m_asyncComputeQueue);
+    } else {
+        m_asyncComputeQueue = m_graphicsQueue;
+        spdlog::info("Graphics queue family has a single queue, async compute shares the graphics queue");
+    }
     
     spdlog::info("Logical device created successfully with Dynamic Rendering and Sync2");
+    if (m_descriptorBuffer) {
+        spdlog::info("VK_EXT_descriptor_buffer enabled");
+    }
 }
 
 void Context::createAllocator() {
@@ -277,6 +380,7 @@ void Context::createAllocator() {
     allocatorInfo.physicalDevice = m_physicalDevice;
     allocatorInfo.device = m_device;
     allocatorInfo.instance = m_instance;
+    allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 
     if (vmaCreateAllocator(&allocatorInfo, &m_allocator) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create VMA allocator!");
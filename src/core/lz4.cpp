@@ -0,0 +1,213 @@
+#include "astral/core/lz4.hpp"
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace astral {
+
+namespace {
+
+constexpr size_t MIN_MATCH = 4;
+constexpr size_t LAST_LITERALS = 5;  // The block always ends with this many literals
+constexpr size_t MATCH_FIND_LIMIT = 12; // No match may start closer to the end
+constexpr size_t MAX_OFFSET = 65535;
+constexpr uint32_t HASH_BITS = 16;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hashSequence(uint32_t sequence) {
+    return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Writes a 4-bit length field overflow as 255-byte runs
+uint8_t* writeLength(uint8_t* op, size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<uint8_t>(length);
+    return op;
+}
+
+// Bytes needed for a sequence with the given literal and match lengths
+size_t sequenceSize(size_t literalLength, size_t matchLength) {
+    size_t size = 1 + literalLength;
+    if (literalLength >= 15) {
+        size += (literalLength - 15) / 255 + 1;
+    }
+    if (matchLength > 0) {
+        size += 2;
+        if (matchLength - MIN_MATCH >= 15) {
+            size += (matchLength - MIN_MATCH - 15) / 255 + 1;
+        }
+    }
+    return size;
+}
+
+uint8_t* writeSequence(uint8_t* op, const uint8_t* literals, size_t literalLength, size_t offset,
+                       size_t matchLength) {
+    uint8_t* token = op++;
+    *token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+    if (literalLength >= 15) {
+        op = writeLength(op, literalLength - 15);
+    }
+    if (literalLength > 0) {
+        std::memcpy(op, literals, literalLength);
+        op += literalLength;
+    }
+
+    if (matchLength > 0) {
+        *op++ = static_cast<uint8_t>(offset & 0xFF);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        size_t code = matchLength - MIN_MATCH;
+        *token |= static_cast<uint8_t>(std::min<size_t>(code, 15));
+        if (code >= 15) {
+            op = writeLength(op, code - 15);
+        }
+    }
+    return op;
+}
+
+} // namespace
+
+size_t lz4CompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lz4Compress(const void* source, size_t sourceSize, void* destination, size_t capacity) {
+    const auto* src = static_cast<const uint8_t*>(source);
+    const uint8_t* end = src + sourceSize;
+    auto* dst = static_cast<uint8_t*>(destination);
+    uint8_t* op = dst;
+    const uint8_t* anchor = src;
+
+    if (sourceSize > MATCH_FIND_LIMIT) {
+        const uint8_t* matchLimit = end - LAST_LITERALS;
+        const uint8_t* searchLimit = end - MATCH_FIND_LIMIT;
+        // Position + 1 of the last occurrence of each hashed 4-byte sequence
+        std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+
+        const uint8_t* ip = src;
+        while (ip < searchLimit) {
+            uint32_t sequence = read32(ip);
+            uint32_t& slot = table[hashSequence(sequence)];
+            const uint8_t* match = slot ? src + (slot - 1) : nullptr;
+            slot = static_cast<uint32_t>(ip - src) + 1;
+
+            if (!match || static_cast<size_t>(ip - match) > MAX_OFFSET || read32(match) != sequence) {
+                // Step faster through data that keeps missing
+                ip += 1 + (static_cast<size_t>(ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && match > src && ip[-1] == match[-1]) {
+                ip--;
+                match--;
+            }
+            size_t matchLength = MIN_MATCH;
+            while (ip + matchLength < matchLimit && ip[matchLength] == match[matchLength]) {
+                matchLength++;
+            }
+
+            size_t literalLength = static_cast<size_t>(ip - anchor);
+            if (sequenceSize(literalLength, matchLength) > capacity - static_cast<size_t>(op - dst)) {
+                return 0;
+            }
+            op = writeSequence(op, anchor, literalLength, static_cast<size_t>(ip - match), matchLength);
+
+            ip += matchLength;
+            anchor = ip;
+        }
+    }
+
+    size_t literalLength = static_cast<size_t>(end - anchor);
+    if (sequenceSize(literalLength, 0) > capacity - static_cast<size_t>(op - dst)) {
+        return 0;
+    }
+    op = writeSequence(op, anchor, literalLength, 0, 0);
+    return static_cast<size_t>(op - dst);
+}
+
+bool lz4Decompress(const void* source, size_t sourceSize, void* destination, size_t destinationSize) {
+    const auto* ip = static_cast<const uint8_t*>(source);
+    const uint8_t* inputEnd = ip + sourceSize;
+    auto* dst = static_cast<uint8_t*>(destination);
+    uint8_t* op = dst;
+    uint8_t* outputEnd = dst + destinationSize;
+
+    auto readLength = [&](size_t& length) {
+        uint8_t byte;
+        do {
+            if (ip >= inputEnd) {
+                return false;
+            }
+            byte = *ip++;
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (true) {
+        if (ip >= inputEnd) {
+            return false;
+        }
+        const uint8_t token = *ip++;
+
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLength(literalLength)) {
+            return false;
+        }
+        if (literalLength > static_cast<size_t>(inputEnd - ip) ||
+            literalLength > static_cast<size_t>(outputEnd - op)) {
+            return false;
+        }
+        if (literalLength > 0) {
+            std::memcpy(op, ip, literalLength);
+            ip += literalLength;
+            op += literalLength;
+        }
+
+        // The last sequence has literals only
+        if (ip == inputEnd) {
+            break;
+        }
+
+        if (inputEnd - ip < 2) {
+            return false;
+        }
+        const size_t offset = static_cast<size_t>(ip[0]) | (static_cast<size_t>(ip[1]) << 8);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - dst)) {
+            return false;
+        }
+
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (matchLength > static_cast<size_t>(outputEnd - op)) {
+            return false;
+        }
+
+        const uint8_t* match = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(op, match, matchLength);
+            op += matchLength;
+        } else {
+            // Overlapping copy repeats the last offset bytes
+            for (size_t i = 0; i < matchLength; ++i) {
+                *op++ = match[i];
+            }
+        }
+    }
+
+    return op == outputEnd;
+}
+
+} // namespace astral
@@ -0,0 +1,85 @@
+#include "astral/core/sampler_cache.hpp"
+#include "astral/core/hash.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace astral {
+
+static_assert(sizeof(VkSamplerCreateFlags) == 4 && sizeof(VkFilter) == 4 && sizeof(float) == 4,
+              "SamplerCache::Key assumes 32-bit members");
+
+bool SamplerCache::Key::operator==(const Key& other) const {
+    return std::memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+size_t SamplerCache::KeyHash::operator()(const Key& key) const {
+    return static_cast<size_t>(hashBytes(&key, sizeof(Key)));
+}
+
+SamplerCache::SamplerCache(Context* context) : m_context(context) {
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(m_context->getPhysicalDevice(), &features);
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(m_context->getPhysicalDevice(), &properties);
+    m_maxAnisotropy = features.samplerAnisotropy ? properties.limits.maxSamplerAnisotropy : 0.0f;
+}
+
+SamplerCache::~SamplerCache() {
+    for (auto& [key, sampler] : m_samplers) {
+        vkDestroySampler(m_context->getDevice(), sampler, nullptr);
+    }
+}
+
+VkSampler SamplerCache::getSampler(const VkSamplerCreateInfo& info) {
+    if (info.pNext) {
+        throw std::runtime_error("SamplerCache does not support sampler pNext chains!");
+    }
+
+    Key key;
+    std::memset(&key, 0, sizeof(key));
+    key.flags = info.flags;
+    key.magFilter = info.magFilter;
+    key.minFilter = info.minFilter;
+    key.mipmapMode = info.mipmapMode;
+    key.addressModeU = info.addressModeU;
+    key.addressModeV = info.addressModeV;
+    key.addressModeW = info.addressModeW;
+    key.mipLodBias = info.mipLodBias;
+    key.anisotropyEnable = info.anisotropyEnable && m_maxAnisotropy > 0.0f ? VK_TRUE : VK_FALSE;
+    // Ignored by Vulkan when anisotropy is off; zero it so such samplers share a key
+    key.maxAnisotropy = key.anisotropyEnable ? std::clamp(info.maxAnisotropy, 1.0f, m_maxAnisotropy) : 0.0f;
+    key.compareEnable = info.compareEnable;
+    key.compareOp = info.compareEnable ? info.compareOp : VK_COMPARE_OP_NEVER;
+    key.minLod = info.minLod;
+    key.maxLod = info.maxLod;
+    key.borderColor = info.borderColor;
+    key.unnormalizedCoordinates = info.unnormalizedCoordinates;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_samplers.find(key);
+    if (it != m_samplers.end()) {
+        return it->second;
+    }
+
+    VkSamplerCreateInfo createInfo = info;
+    createInfo.anisotropyEnable = key.anisotropyEnable;
+    createInfo.maxAnisotropy = key.anisotropyEnable ? key.maxAnisotropy : 1.0f;
+    createInfo.compareOp = key.compareOp;
+
+    VkSampler sampler;
+    if (vkCreateSampler(m_context->getDevice(), &createInfo, nullptr, &sampler) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create sampler!");
+    }
+    m_samplers.emplace(key, sampler);
+    spdlog::debug("SamplerCache: created sampler #{}", m_samplers.size());
+    return sampler;
+}
+
+size_t SamplerCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_samplers.size();
+}
+
+} // namespace astral
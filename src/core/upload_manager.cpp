@@ -0,0 +1,274 @@
+#include "astral/core/upload_manager.hpp"
+#include "astral/resources/buffer.hpp"
+#include "astral/resources/image.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace astral {
+
+UploadManager::UploadManager(Context* context) : m_context(context) {
+    // Uploaded resources use exclusive sharing, so uploads go to a queue of the
+    // graphics family. The transfer queue is used when it shares that family.
+    auto indices = m_context->getQueueFamilyIndices();
+    uint32_t family = indices.graphicsFamily.value();
+    if (indices.transferFamily.has_value() && indices.transferFamily.value() == family) {
+        m_queue = m_context->getTransferQueue();
+    } else {
+        m_queue = m_context->getGraphicsQueue();
+    }
+
+    VkCommandPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+    poolInfo.queueFamilyIndex = family;
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    if (vkCreateCommandPool(m_context->getDevice(), &poolInfo, nullptr, &m_pool) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to create upload command pool!");
+    }
+}
+
+UploadManager::~UploadManager() {
+    waitIdle();
+
+    for (auto& batch : m_freeBatches) {
+        vkDestroyFence(m_context->getDevice(), batch->fence, nullptr);
+    }
+    vkDestroyCommandPool(m_context->getDevice(), m_pool, nullptr);
+}
+
+UploadManager::Batch& UploadManager::beginRecording() {
+    if (m_recording) {
+        return *m_recording;
+    }
+
+    if (!m_freeBatches.empty()) {
+        m_recording = std::move(m_freeBatches.back());
+        m_freeBatches.pop_back();
+        vkResetCommandBuffer(m_recording->commandBuffer, 0);
+        vkResetFences(m_context->getDevice(), 1, &m_recording->fence);
+    } else {
+        m_recording = std::make_unique<Batch>();
+
+        VkCommandBufferAllocateInfo allocInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+        allocInfo.commandPool = m_pool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(m_context->getDevice(), &allocInfo, &m_recording->commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to allocate upload command buffer!");
+        }
+
+        VkFenceCreateInfo fenceInfo = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+        if (vkCreateFence(m_context->getDevice(), &fenceInfo, nullptr, &m_recording->fence) != VK_SUCCESS) {
+            throw std::runtime_error("Failed to create upload fence!");
+        }
+    }
+
+    VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(m_recording->commandBuffer, &beginInfo);
+    return *m_recording;
+}
+
+Buffer& UploadManager::createStaging(const void* data, VkDeviceSize size) {
+    Batch& batch = beginRecording();
+    auto staging = std::make_unique<Buffer>(m_context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_AUTO,
+                                            VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    staging->upload(data, size);
+    batch.bytes += size;
+    batch.stagingBuffers.push_back(std::move(staging));
+    return *batch.stagingBuffers.back();
+}
+
+void UploadManager::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void* data, VkDeviceSize size) {
+    if (size == 0) {
+        return;
+    }
+
+    Buffer& staging = createStaging(data, size);
+
+    VkBufferCopy region = {};
+    region.srcOffset = 0;
+    region.dstOffset = dstOffset;
+    region.size = size;
+    vkCmdCopyBuffer(m_recording->commandBuffer, staging.getHandle(), dstBuffer, 1, &region);
+}
+
+void UploadManager::uploadImage(Image& image, const void* data, VkDeviceSize size) {
+    Buffer& staging = createStaging(data, size);
+    VkCommandBuffer cmd = m_recording->commandBuffer;
+    const ImageSpecs& specs = image.getSpecs();
+
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.getHandle();
+    barrier.subresourceRange.aspectMask = specs.aspectFlags;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = specs.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = specs.arrayLayers;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = specs.aspectFlags;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = specs.arrayLayers;
+    region.imageExtent = {specs.width, specs.height, specs.depth};
+    vkCmdCopyBufferToImage(cmd, staging.getHandle(), image.getHandle(),
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void UploadManager::uploadImageLevels(Image& image, uint32_t firstLevel, uint32_t levelCount, const void* data,
+                                      VkDeviceSize size) {
+    if (levelCount == 0) {
+        return;
+    }
+
+    const ImageSpecs& specs = image.getSpecs();
+    auto levelExtent = [&specs](uint32_t level) {
+        return VkExtent3D{std::max(specs.width >> level, 1u), std::max(specs.height >> level, 1u),
+                          std::max(specs.depth >> level, 1u)};
+    };
+
+    // Texel size follows from the packed size of the levels
+    VkDeviceSize texelCount = 0;
+    for (uint32_t level = firstLevel; level < firstLevel + levelCount; ++level) {
+        VkExtent3D extent = levelExtent(level);
+        texelCount += static_cast<VkDeviceSize>(extent.width) * extent.height * extent.depth * specs.arrayLayers;
+    }
+    if (texelCount == 0 || size % texelCount != 0) {
+        throw std::runtime_error("Mip level data size does not match the image!");
+    }
+    const VkDeviceSize texelSize = size / texelCount;
+
+    Buffer& staging = createStaging(data, size);
+    VkCommandBuffer cmd = m_recording->commandBuffer;
+
+    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.getHandle();
+    barrier.subresourceRange.aspectMask = specs.aspectFlags;
+    barrier.subresourceRange.baseMipLevel = firstLevel;
+    barrier.subresourceRange.levelCount = levelCount;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = specs.arrayLayers;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    std::vector<VkBufferImageCopy> regions(levelCount);
+    VkDeviceSize offset = 0;
+    for (uint32_t i = 0; i < levelCount; ++i) {
+        VkExtent3D extent = levelExtent(firstLevel + i);
+        VkBufferImageCopy& region = regions[i];
+        region.bufferOffset = offset;
+        region.imageSubresource.aspectMask = specs.aspectFlags;
+        region.imageSubresource.mipLevel = firstLevel + i;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = specs.arrayLayers;
+        region.imageExtent = extent;
+        offset += static_cast<VkDeviceSize>(extent.width) * extent.height * extent.depth * specs.arrayLayers * texelSize;
+    }
+    vkCmdCopyBufferToImage(cmd, staging.getHandle(), image.getHandle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32_t>(regions.size()), regions.data());
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+void UploadManager::submit(std::function<void()> onComplete) {
+    if (!m_recording && !onComplete) {
+        return;
+    }
+
+    Batch& batch = beginRecording();
+    if (onComplete) {
+        batch.callbacks.push_back(std::move(onComplete));
+    }
+
+    // Make transfer writes visible to every later consumer on this queue
+    VkMemoryBarrier barrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                            VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+    vkEndCommandBuffer(batch.commandBuffer);
+
+    VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.commandBuffer;
+    if (vkQueueSubmit(m_queue, 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+        throw std::runtime_error("Failed to submit upload batch!");
+    }
+
+    m_bytesInFlight += batch.bytes;
+    m_inFlight.push_back(std::move(m_recording));
+}
+
+void UploadManager::retire(Batch& batch) {
+    m_bytesInFlight -= batch.bytes;
+    batch.stagingBuffers.clear();
+    batch.bytes = 0;
+
+    auto callbacks = std::move(batch.callbacks);
+    batch.callbacks.clear();
+    for (auto& callback : callbacks) {
+        callback();
+    }
+}
+
+uint32_t UploadManager::poll() {
+    uint32_t retired = 0;
+    // Batches complete in submission order on a single queue
+    while (!m_inFlight.empty() &&
+           vkGetFenceStatus(m_context->getDevice(), m_inFlight.front()->fence) == VK_SUCCESS) {
+        auto batch = std::move(m_inFlight.front());
+        m_inFlight.pop_front();
+        retire(*batch);
+        m_freeBatches.push_back(std::move(batch));
+        retired++;
+    }
+    return retired;
+}
+
+void UploadManager::waitIdle() {
+    if (m_recording) {
+        submit();
+    }
+
+    // Callbacks may record and submit more work, so loop until drained
+    while (!m_inFlight.empty()) {
+        VkFence fence = m_inFlight.back()->fence;
+        vkWaitForFences(m_context->getDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+        poll();
+        if (m_recording) {
+            submit();
+        }
+    }
+}
+
+} // namespace astral
@@ -1,4 +1,5 @@
 #include "astral/renderer/compute_pipeline.hpp"
+#include "astral/renderer/descriptor_manager.hpp"
 #include <spdlog/spdlog.h>
 #include <stdexcept>
 
@@ -13,6 +14,7 @@ ComputePipeline::ComputePipeline(Context* context, const ComputePipelineSpecs& s
     pipelineInfo.stage.module = specs.computeShader->getModule();
     pipelineInfo.stage.pName = "main";
     pipelineInfo.layout = specs.layout;
+    pipelineInfo.flags = m_context->getDescriptorManager().getPipelineCreateFlags();
 
     if (vkCreateComputePipelines(m_context->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create compute pipeline!");
@@ -1,22 +1,47 @@
 #include "astral/renderer/descriptor_manager.hpp"
 #include "astral/core/context.hpp"
+#include "astral/resources/buffer.hpp"
+#include <spdlog/spdlog.h>
 #include <stdexcept>
 #include <vector>
 #include <string>
 
 namespace astral {
 
+static constexpr VkBufferUsageFlags DESCRIPTOR_BUFFER_USAGE = VK_BUFFER_USAGE_RESOURCE_DESCRIPTOR_BUFFER_BIT_EXT |
+                                                              VK_BUFFER_USAGE_SAMPLER_DESCRIPTOR_BUFFER_BIT_EXT |
+                                                              VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+
 DescriptorManager::DescriptorManager(Context* context) : m_context(context) {
-    createLayout();
+    for (uint32_t binding : BUFFER_BINDINGS) {
+        m_slots[binding].capacity = MAX_BINDLESS_BUFFERS;
+    }
+    for (uint32_t binding : {0u, 4u, 5u, 12u}) {
+        m_slots[binding].capacity = MAX_BINDLESS_IMAGES;
+    }
+    m_slots[14].capacity = MAX_BINDLESS_CUBE_ARRAYS;
+
+    if (m_context->hasDescriptorBuffer()) {
+        createLayout(true);
+        if (createDescriptorBuffer()) {
+            spdlog::info("Bindless set in a descriptor buffer ({} KiB)", m_descriptorBuffer->getSize() / 1024);
+            return;
+        }
+        spdlog::warn("Bindless set exceeds the descriptor buffer limits, using a descriptor pool");
+        vkDestroyDescriptorSetLayout(m_context->getDevice(), m_layout, nullptr);
+    }
+
+    createLayout(false);
     createPoolAndSet();
 }
 
 DescriptorManager::~DescriptorManager() {
+    m_descriptorBuffer.reset();
     vkDestroyDescriptorPool(m_context->getDevice(), m_pool, nullptr);
     vkDestroyDescriptorSetLayout(m_context->getDevice(), m_layout, nullptr);
 }
 
-void DescriptorManager::createLayout() {
+void DescriptorManager::createLayout(bool descriptorBuffer) {
     std::vector<VkDescriptorSetLayoutBinding> bindings;
     
     // Binding 0: Images
@@ -28,8 +53,7 @@ void DescriptorManager::createLayout() {
     bindings.push_back(b0);
 
     // Binding 1-3, 6-11: Storage Buffers
-    uint32_t bufferBindings[] = { 1, 2, 3, 6, 7, 8, 9, 10, 11, 13 };
-    for (uint32_t b : bufferBindings) {
+    for (uint32_t b : BUFFER_BINDINGS) {
         VkDescriptorSetLayoutBinding bind = {};
         bind.binding = b;
         bind.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
@@ -62,11 +86,28 @@ void DescriptorManager::createLayout() {
     b5.stageFlags = VK_SHADER_STAGE_ALL;
     bindings.push_back(b5);
 
-    std::vector<VkDescriptorBindingFlags> flags(bindings.size(), VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT);
+    // Binding 14: Cube Map Arrays (samplerCubeArray)
+    VkDescriptorSetLayoutBinding b14 = {};
+    b14.binding = 14;
+    b14.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    b14.descriptorCount = MAX_BINDLESS_CUBE_ARRAYS;
+    b14.stageFlags = VK_SHADER_STAGE_ALL;
+    bindings.push_back(b14);
+
+    // Writes are flushed while the previous frame may still be executing; they
+    // only touch slots it does not use (fresh or retired, see beginFrame).
+    // Descriptor buffers allow that without any flags, and reject the update
+    // after bind and variable count ones.
+    std::vector<VkDescriptorBindingFlags> flags(bindings.size(), VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+    if (!descriptorBuffer) {
+        for (VkDescriptorBindingFlags& flag : flags) {
+            flag |= VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        }
+    }
 
-    // Find index of binding 13 for variable count (must be the HIGHEST binding number per Vulkan spec)
-    for(size_t i = 0; i < bindings.size(); ++i) {
-        if(bindings[i].binding == 13) {
+    // Find index of binding 14 for variable count (must be the HIGHEST binding number per Vulkan spec)
+    for(size_t i = 0; i < bindings.size() && !descriptorBuffer; ++i) {
+        if(bindings[i].binding == 14) {
             flags[i] |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
             break;
         }
@@ -80,7 +121,8 @@ void DescriptorManager::createLayout() {
     layoutInfo.pNext = &flagsInfo;
     layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
     layoutInfo.pBindings = bindings.data();
-    layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    layoutInfo.flags = descriptorBuffer ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_DESCRIPTOR_BUFFER_BIT_EXT
+                                        : VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
 
     if (vkCreateDescriptorSetLayout(m_context->getDevice(), &layoutInfo, nullptr, &m_layout) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create bindless descriptor set layout!");
@@ -89,7 +131,7 @@ void DescriptorManager::createLayout() {
 
 void DescriptorManager::createPoolAndSet() {
     std::vector<VkDescriptorPoolSize> poolSizes = {
-        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_BINDLESS_IMAGES * 3}, // Binding 0, 4 and 12
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, MAX_BINDLESS_IMAGES * 3 + MAX_BINDLESS_CUBE_ARRAYS}, // Binding 0, 4, 12 and 14
         {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, MAX_BINDLESS_BUFFERS * 12}, // 10 buffer bindings + headroom
         {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, MAX_BINDLESS_IMAGES} // Binding 5
     };
@@ -104,8 +146,8 @@ void DescriptorManager::createPoolAndSet() {
         throw std::runtime_error("Failed to create bindless descriptor pool!");
     }
 
-    // We need to find the count for the variable binding (binding 13 is a storage buffer)
-    uint32_t variableCount = MAX_BINDLESS_BUFFERS;
+    // We need to find the count for the variable binding (binding 14 holds cube map arrays)
+    uint32_t variableCount = MAX_BINDLESS_CUBE_ARRAYS;
     
     VkDescriptorSetVariableDescriptorCountAllocateInfo variableInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO};
     variableInfo.descriptorSetCount = 1;
@@ -122,132 +164,333 @@ void DescriptorManager::createPoolAndSet() {
     }
 }
 
-uint32_t DescriptorManager::registerImage(VkImageView view, VkSampler sampler) {
-    if (m_nextImageIndex >= MAX_BINDLESS_IMAGES) {
-        throw std::runtime_error("Maximum bindless images reached!");
+bool DescriptorManager::createDescriptorBuffer() {
+    VkDevice device = m_context->getDevice();
+    m_getLayoutSize = reinterpret_cast<PFN_vkGetDescriptorSetLayoutSizeEXT>(
+        vkGetDeviceProcAddr(device, "vkGetDescriptorSetLayoutSizeEXT"));
+    m_getBindingOffset = reinterpret_cast<PFN_vkGetDescriptorSetLayoutBindingOffsetEXT>(
+        vkGetDeviceProcAddr(device, "vkGetDescriptorSetLayoutBindingOffsetEXT"));
+    m_getDescriptor = reinterpret_cast<PFN_vkGetDescriptorEXT>(vkGetDeviceProcAddr(device, "vkGetDescriptorEXT"));
+    m_cmdBindDescriptorBuffers = reinterpret_cast<PFN_vkCmdBindDescriptorBuffersEXT>(
+        vkGetDeviceProcAddr(device, "vkCmdBindDescriptorBuffersEXT"));
+    m_cmdSetDescriptorBufferOffsets = reinterpret_cast<PFN_vkCmdSetDescriptorBufferOffsetsEXT>(
+        vkGetDeviceProcAddr(device, "vkCmdSetDescriptorBufferOffsetsEXT"));
+    if (!m_getLayoutSize || !m_getBindingOffset || !m_getDescriptor || !m_cmdBindDescriptorBuffers ||
+        !m_cmdSetDescriptorBufferOffsets) {
+        return false;
     }
 
-    uint32_t index = m_nextImageIndex++;
-    
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = view;
-    imageInfo.sampler = sampler;
+    VkPhysicalDeviceDescriptorBufferPropertiesEXT properties = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_BUFFER_PROPERTIES_EXT};
+    VkPhysicalDeviceProperties2 properties2 = {VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2};
+    properties2.pNext = &properties;
+    vkGetPhysicalDeviceProperties2(m_context->getPhysicalDevice(), &properties2);
+
+    VkDeviceSize size = 0;
+    m_getLayoutSize(device, m_layout, &size);
+
+    // Combined image samplers are written as one descriptor each; devices that
+    // want their image and sampler halves in separate arrays use the pool
+    if (!properties.combinedImageSamplerDescriptorSingleArray || size > properties.maxResourceDescriptorBufferRange ||
+        size > properties.maxSamplerDescriptorBufferRange ||
+        size > properties.samplerDescriptorBufferAddressSpaceSize) {
+        return false;
+    }
+
+    for (uint32_t binding = 0; binding < BINDING_COUNT; ++binding) {
+        m_getBindingOffset(device, m_layout, binding, &m_bindingOffsets[binding]);
+    }
+    m_combinedImageSamplerSize = properties.combinedImageSamplerDescriptorSize;
+    m_storageImageSize = properties.storageImageDescriptorSize;
+    m_storageBufferSize = properties.storageBufferDescriptorSize;
+
+    m_descriptorBuffer = std::make_unique<Buffer>(m_context, size, DESCRIPTOR_BUFFER_USAGE, VMA_MEMORY_USAGE_AUTO,
+                                                  VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    void* data = nullptr;
+    m_descriptorBuffer->map(&data); // Stays mapped; the Buffer unmaps on destruction
+    m_descriptorData = static_cast<uint8_t*>(data);
+
+    m_descriptorAddress = m_descriptorBuffer->getDeviceAddress();
+    return true;
+}
+
+VkPipelineCreateFlags DescriptorManager::getPipelineCreateFlags() const {
+    return m_descriptorBuffer ? VK_PIPELINE_CREATE_DESCRIPTOR_BUFFER_BIT_EXT : 0;
+}
+
+void DescriptorManager::bind(VkCommandBuffer cb, VkPipelineBindPoint bindPoint, VkPipelineLayout layout) const {
+    if (!m_descriptorBuffer) {
+        vkCmdBindDescriptorSets(cb, bindPoint, layout, 0, 1, &m_set, 0, nullptr);
+        return;
+    }
 
-    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    write.dstSet = m_set;
-    write.dstBinding = 0;
-    write.dstArrayElement = index;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write.descriptorCount = 1;
-    write.pImageInfo = &imageInfo;
+    VkDescriptorBufferBindingInfoEXT bindingInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_BUFFER_BINDING_INFO_EXT};
+    bindingInfo.address = m_descriptorAddress;
+    bindingInfo.usage = DESCRIPTOR_BUFFER_USAGE;
+    m_cmdBindDescriptorBuffers(cb, 1, &bindingInfo);
 
-    vkUpdateDescriptorSets(m_context->getDevice(), 1, &write, 0, nullptr);
+    const uint32_t bufferIndex = 0;
+    const VkDeviceSize offset = 0;
+    m_cmdSetDescriptorBufferOffsets(cb, bindPoint, layout, 0, 1, &bufferIndex, &offset);
+}
 
+uint32_t DescriptorManager::registerImage(VkImageView view, VkSampler sampler) {
+    uint32_t index = allocateSlot(0, "images");
+    queueImageWrite(0, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, view, sampler,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     return index;
 }
 
 uint32_t DescriptorManager::registerImageArray(VkImageView view, VkSampler sampler) {
-    if (m_nextArrayImageIndex >= MAX_BINDLESS_IMAGES) {
-        throw std::runtime_error("Maximum bindless array images reached!");
-    }
+    uint32_t index = allocateSlot(4, "array images");
+    queueImageWrite(4, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, view, sampler,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    return index;
+}
 
-    uint32_t index = m_nextArrayImageIndex++;
-    
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    imageInfo.imageView = view;
-    imageInfo.sampler = sampler;
+uint32_t DescriptorManager::registerStorageImage(VkImageView view) {
+    uint32_t index = allocateSlot(5, "storage images");
+    queueImageWrite(5, index, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, view, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL);
+    return index;
+}
+
+uint32_t DescriptorManager::registerImageCube(VkImageView view, VkSampler sampler) {
+    uint32_t index = allocateSlot(12, "cube images");
+    queueImageWrite(12, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, view, sampler,
+                    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    return index;
+}
+
+uint32_t DescriptorManager::registerImageCubeArray(VkImageView view, VkSampler sampler, VkImageLayout layout) {
+    uint32_t index = allocateSlot(14, "cube array images");
+    queueImageWrite(14, index, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, view, sampler, layout);
+    return index;
+}
+
+uint32_t DescriptorManager::registerBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding) {
+    if (!isBufferBinding(binding)) {
+        throw std::runtime_error("Invalid binding index for registerBuffer! (Expected a storage buffer binding)");
+    }
+    if (m_descriptorBuffer && range == VK_WHOLE_SIZE) {
+        throw std::runtime_error("registerBuffer needs an explicit range with a descriptor buffer!");
+    }
 
-    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    write.dstSet = m_set;
-    write.dstBinding = 4; // Array Images
-    write.dstArrayElement = index;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write.descriptorCount = 1;
-    write.pImageInfo = &imageInfo;
+    uint32_t index = allocateSlot(binding, "buffers");
 
-    vkUpdateDescriptorSets(m_context->getDevice(), 1, &write, 0, nullptr);
+    VkDescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = offset;
+    bufferInfo.range = range;
+    queueWrite({binding, index, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, static_cast<uint32_t>(m_pendingBufferInfos.size())});
+    m_pendingBufferInfos.push_back(bufferInfo);
 
     return index;
 }
 
-uint32_t DescriptorManager::registerStorageImage(VkImageView view) {
-    if (m_nextStorageImageIndex >= MAX_BINDLESS_IMAGES) {
-        throw std::runtime_error("Maximum bindless storage images reached!");
+void DescriptorManager::flush() {
+    if (m_pendingWrites.empty()) {
+        return;
+    }
+    for (const PendingWrite& pending : m_pendingWrites) {
+        m_slots[pending.binding].written[pending.index] = true;
+    }
+    if (m_descriptorBuffer) {
+        writeDescriptorBuffer();
+        return;
     }
 
-    uint32_t index = m_nextStorageImageIndex++;
-    
-    VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageView = view;
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+    // Writes to consecutive slots of one binding become a single write, so a
+    // model's textures registered back to back cost one entry
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(m_pendingWrites.size());
+    for (const PendingWrite& pending : m_pendingWrites) {
+        const bool isBuffer = pending.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        const VkDescriptorImageInfo* imageInfo = isBuffer ? nullptr : &m_pendingImageInfos[pending.infoIndex];
+        const VkDescriptorBufferInfo* bufferInfo = isBuffer ? &m_pendingBufferInfos[pending.infoIndex] : nullptr;
+
+        if (!writes.empty()) {
+            VkWriteDescriptorSet& last = writes.back();
+            if (last.dstBinding == pending.binding && last.descriptorType == pending.type &&
+                last.dstArrayElement + last.descriptorCount == pending.index &&
+                (isBuffer ? last.pBufferInfo + last.descriptorCount == bufferInfo
+                          : last.pImageInfo + last.descriptorCount == imageInfo)) {
+                last.descriptorCount++;
+                continue;
+            }
+        }
 
-    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    write.dstSet = m_set;
-    write.dstBinding = 5; // Storage Images
-    write.dstArrayElement = index;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-    write.descriptorCount = 1;
-    write.pImageInfo = &imageInfo;
+        VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        write.dstSet = m_set;
+        write.dstBinding = pending.binding;
+        write.dstArrayElement = pending.index;
+        write.descriptorType = pending.type;
+        write.descriptorCount = 1;
+        write.pImageInfo = imageInfo;
+        write.pBufferInfo = bufferInfo;
+        writes.push_back(write);
+    }
 
-    vkUpdateDescriptorSets(m_context->getDevice(), 1, &write, 0, nullptr);
+    vkUpdateDescriptorSets(m_context->getDevice(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
 
-    return index;
+    m_pendingWrites.clear();
+    m_pendingImageInfos.clear();
+    m_pendingBufferInfos.clear();
 }
 
-uint32_t DescriptorManager::registerImageCube(VkImageView view, VkSampler sampler) {
-    if (m_nextCubeImageIndex >= MAX_BINDLESS_IMAGES) {
-        throw std::runtime_error("Maximum bindless cube images reached!");
+void DescriptorManager::writeDescriptorBuffer() {
+    VkDevice device = m_context->getDevice();
+    for (const PendingWrite& pending : m_pendingWrites) {
+        VkDescriptorGetInfoEXT getInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_GET_INFO_EXT};
+        getInfo.type = pending.type;
+
+        VkDescriptorAddressInfoEXT addressInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_ADDRESS_INFO_EXT};
+        size_t size;
+        if (pending.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            const VkDescriptorBufferInfo& bufferInfo = m_pendingBufferInfos[pending.infoIndex];
+            VkBufferDeviceAddressInfo bufferAddress = {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+            bufferAddress.buffer = bufferInfo.buffer;
+            addressInfo.address = vkGetBufferDeviceAddress(device, &bufferAddress) + bufferInfo.offset;
+            addressInfo.range = bufferInfo.range;
+            getInfo.data.pStorageBuffer = &addressInfo;
+            size = m_storageBufferSize;
+        } else if (pending.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+            getInfo.data.pStorageImage = &m_pendingImageInfos[pending.infoIndex];
+            size = m_storageImageSize;
+        } else {
+            getInfo.data.pCombinedImageSampler = &m_pendingImageInfos[pending.infoIndex];
+            size = m_combinedImageSamplerSize;
+        }
+
+        m_getDescriptor(device, &getInfo, size,
+                        m_descriptorData + m_bindingOffsets[pending.binding] + pending.index * size);
     }
+    vmaFlushAllocation(m_context->getAllocator(), m_descriptorBuffer->getAllocation(), 0, VK_WHOLE_SIZE);
 
-    uint32_t index = m_nextCubeImageIndex++;
-    
+    m_pendingWrites.clear();
+    m_pendingImageInfos.clear();
+    m_pendingBufferInfos.clear();
+}
+
+void DescriptorManager::queueWrite(const PendingWrite& write) {
+    // Frames in flight may use any slot that has been flushed, and neither a
+    // pending set update nor a CPU write into the descriptor buffer may
+    // change what they read
+    if (m_slots[write.binding].written[write.index]) {
+        throw std::runtime_error("Bindless slot " + std::to_string(write.index) + " of binding " +
+                                 std::to_string(write.binding) + " is already written; register a new slot instead!");
+    }
+    m_pendingWrites.push_back(write);
+}
+
+void DescriptorManager::queueImageWrite(uint32_t binding, uint32_t index, VkDescriptorType type, VkImageView view,
+                                        VkSampler sampler, VkImageLayout layout) {
     VkDescriptorImageInfo imageInfo = {};
-    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    imageInfo.imageLayout = layout;
     imageInfo.imageView = view;
     imageInfo.sampler = sampler;
+    queueWrite({binding, index, type, static_cast<uint32_t>(m_pendingImageInfos.size())});
+    m_pendingImageInfos.push_back(imageInfo);
+}
 
-    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    write.dstSet = m_set;
-    write.dstBinding = 12; // Cube Maps
-    write.dstArrayElement = index;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    write.descriptorCount = 1;
-    write.pImageInfo = &imageInfo;
+void DescriptorManager::unregisterImage(uint32_t index) { releaseSlot(0, index); }
+void DescriptorManager::unregisterImageArray(uint32_t index) { releaseSlot(4, index); }
+void DescriptorManager::unregisterStorageImage(uint32_t index) { releaseSlot(5, index); }
+void DescriptorManager::unregisterImageCube(uint32_t index) { releaseSlot(12, index); }
+void DescriptorManager::unregisterImageCubeArray(uint32_t index) { releaseSlot(14, index); }
 
-    vkUpdateDescriptorSets(m_context->getDevice(), 1, &write, 0, nullptr);
+void DescriptorManager::unregisterBuffer(uint32_t index, uint32_t binding) {
+    if (!isBufferBinding(binding)) {
+        throw std::runtime_error("Invalid binding index for unregisterBuffer! (Expected a storage buffer binding)");
+    }
+    releaseSlot(binding, index);
+}
 
-    return index;
+void DescriptorManager::retire(std::shared_ptr<void> resource) {
+    m_retiredResources.push_back({std::move(resource), MAX_FRAMES_IN_FLIGHT});
 }
 
-uint32_t DescriptorManager::registerBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding) {
-    if (binding == 0 || binding > 15) {
-        throw std::runtime_error("Invalid binding index for registerBuffer! (Expected 1-15)");
+DescriptorManager::BindlessHandle DescriptorManager::getHandle(uint32_t binding, uint32_t index) const {
+    if (!isRegistered(binding, index)) {
+        throw std::runtime_error("Bindless slot " + std::to_string(index) + " of binding " + std::to_string(binding) +
+                                 " is not registered!");
     }
-    
-    if (m_nextBufferIndices[binding] >= MAX_BINDLESS_BUFFERS) {
-        throw std::runtime_error("Maximum bindless buffers reached for binding " + std::to_string(binding));
+    return {binding, index, m_slots[binding].generations[index]};
+}
+
+bool DescriptorManager::isValid(const BindlessHandle& handle) const {
+    return isRegistered(handle.binding, handle.index) &&
+           m_slots[handle.binding].generations[handle.index] == handle.generation;
+}
+
+void DescriptorManager::beginFrame() {
+    for (auto it = m_pendingFrees.begin(); it != m_pendingFrees.end();) {
+        if (--it->framesLeft > 0) {
+            ++it;
+            continue;
+        }
+
+        m_slots[it->binding].freeList.push_back(it->index);
+        it = m_pendingFrees.erase(it);
     }
 
-    uint32_t index = m_nextBufferIndices[binding]++;
-    
-    VkDescriptorBufferInfo bufferInfo = {};
-    bufferInfo.buffer = buffer;
-    bufferInfo.offset = offset;
-    bufferInfo.range = range;
+    for (auto it = m_retiredResources.begin(); it != m_retiredResources.end();) {
+        if (--it->framesLeft > 0) {
+            ++it;
+            continue;
+        }
+        it = m_retiredResources.erase(it);
+    }
+}
 
-    VkWriteDescriptorSet write = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
-    write.dstSet = m_set;
-    write.dstBinding = binding;
-    write.dstArrayElement = index;
-    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-    write.descriptorCount = 1;
-    write.pBufferInfo = &bufferInfo;
+bool DescriptorManager::isBufferBinding(uint32_t binding) {
+    for (uint32_t b : BUFFER_BINDINGS) {
+        if (b == binding) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    vkUpdateDescriptorSets(m_context->getDevice(), 1, &write, 0, nullptr);
+bool DescriptorManager::isRegistered(uint32_t binding, uint32_t index) const {
+    if (binding >= BINDING_COUNT) {
+        return false;
+    }
+    const SlotTable& table = m_slots[binding];
+    return index < table.live.size() && table.live[index];
+}
 
+uint32_t DescriptorManager::allocateSlot(uint32_t binding, const char* kind) {
+    SlotTable& table = m_slots[binding];
+    uint32_t index;
+    if (!table.freeList.empty()) {
+        index = table.freeList.back();
+        table.freeList.pop_back();
+    } else {
+        if (table.live.size() >= table.capacity) {
+            throw std::runtime_error(std::string("Maximum bindless ") + kind + " reached for binding " +
+                                     std::to_string(binding) + "!");
+        }
+        index = static_cast<uint32_t>(table.live.size());
+        table.live.push_back(false);
+        table.generations.push_back(0);
+        table.written.push_back(false);
+    }
+    table.live[index] = true;
+    table.written[index] = false;
     return index;
 }
 
+void DescriptorManager::releaseSlot(uint32_t binding, uint32_t index) {
+    // A second unregister, or one with an index from another binding, would
+    // otherwise hand the slot out twice
+    if (!isRegistered(binding, index)) {
+        throw std::runtime_error("Bindless slot " + std::to_string(index) + " of binding " + std::to_string(binding) +
+                                 " is not registered!");
+    }
+    SlotTable& table = m_slots[binding];
+    table.live[index] = false;
+    table.generations[index]++;
+    m_pendingFrees.push_back({binding, index, MAX_FRAMES_IN_FLIGHT});
+}
+
 } // namespace astral
@@ -1,11 +1,23 @@
 #include "astral/renderer/environment_manager.hpp"
+#include "astral/core/asset_file.hpp"
 #include "astral/core/commands.hpp"
+#include "astral/core/hash.hpp"
+#include "astral/core/sampler_cache.hpp"
+#include "astral/core/thread_pool.hpp"
 #include "astral/renderer/compute_pipeline.hpp"
 #include "astral/renderer/descriptor_manager.hpp"
+#include "astral/renderer/ibl_cache.hpp"
+#include "astral/resources/buffer.hpp"
+#include "astral/resources/hdr_decoder.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <iterator>
 #include <spdlog/spdlog.h>
 #include <sstream>
 #include <stb_image.h>
@@ -13,205 +25,504 @@
 
 namespace astral {
 
-static std::string readFile(const std::string &filename) {
-  std::ifstream file(filename, std::ios::ate | std::ios::binary);
-  if (!file.is_open()) {
-    throw std::runtime_error("Failed to open file: " + filename);
-  }
-  size_t fileSize = (size_t)file.tellg();
-  std::string buffer;
-  buffer.resize(fileSize);
-  file.seekg(0);
-  file.read(buffer.data(), fileSize);
-  return buffer;
+// Bake parameters; all of them are part of the IBL cache key
+constexpr uint32_t SKYBOX_SIZE = 1024;
+constexpr uint32_t SH_TILES = 8; // SH workgroups per cube face edge
+constexpr uint32_t PREFILTERED_SIZE = 512;
+constexpr uint32_t PREFILTERED_MIPS = 5;
+constexpr uint32_t BRDF_LUT_SIZE = 512;
+constexpr VkFormat CUBE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr VkFormat BRDF_LUT_FORMAT = VK_FORMAT_R16G16_SFLOAT;
+constexpr uint32_t SH_GROUP_COUNT = SH_TILES * SH_TILES * 6;
+constexpr uint32_t SH_COEFFICIENTS = 9;
+
+static const char *const BAKE_SHADERS[] = {
+    "assets/shaders/equirect_to_cube.comp", "assets/shaders/sh_project.comp",
+    "assets/shaders/prefilter.comp", "assets/shaders/brdf_lut.comp"};
+
+static VkDeviceSize getTexelSize(VkFormat format) {
+  switch (format) {
+  case VK_FORMAT_R16G16_SFLOAT:
+    return 4;
+  case VK_FORMAT_R16G16B16A16_SFLOAT:
+    return 8;
+  case VK_FORMAT_R32G32B32A32_SFLOAT:
+    return 16;
+  default:
+    throw std::runtime_error("Unsupported IBL image format!");
+  }
 }
 
-EnvironmentManager::EnvironmentManager(Context *context) : m_context(context) {}
-
-EnvironmentManager::~EnvironmentManager() {
-  // Resources are managed by unique_ptrs
+// Bytes of all mips and layers, packed as in IblCacheImage
+static VkDeviceSize getPackedSize(VkFormat format, uint32_t width,
+                                  uint32_t height, uint32_t layers,
+                                  uint32_t mipLevels) {
+  VkDeviceSize size = 0;
+  for (uint32_t i = 0; i < mipLevels; ++i) {
+    size += static_cast<VkDeviceSize>(std::max(width >> i, 1u)) *
+            std::max(height >> i, 1u) * layers;
+  }
+  return size * getTexelSize(format);
 }
 
-void EnvironmentManager::loadHDR(const std::string &path) {
-  if (!std::filesystem::exists(path)) {
-    spdlog::warn("Skybox HDR not found at: {}. IBL will be disabled.", path);
-    return;
-  }
-  spdlog::info("Loading HDR environment map: {}", path);
-  int width, height, channels;
-  stbi_set_flip_vertically_on_load(true);
-  float *data = stbi_loadf(path.c_str(), &width, &height, &channels, 4);
-  stbi_set_flip_vertically_on_load(false);
+// Describes a baked image for the IBL cache, without its texels
+static IblCacheImage describeImage(const Image &image) {
+  const ImageSpecs &specs = image.getSpecs();
+  IblCacheImage result;
+  result.format = specs.format;
+  result.width = specs.width;
+  result.height = specs.height;
+  result.layers = specs.arrayLayers;
+  result.mipLevels = specs.mipLevels;
+  return result;
+}
 
-  if (!data) {
-    spdlog::error("Failed to load HDR image: {}", path);
-    return;
-  }
+static VkDeviceSize getPackedSize(const Image &image) {
+  const ImageSpecs &specs = image.getSpecs();
+  return getPackedSize(specs.format, specs.width, specs.height,
+                       specs.arrayLayers, specs.mipLevels);
+}
 
-  ImageSpecs equirectSpecs;
-  equirectSpecs.width = static_cast<uint32_t>(width);
-  equirectSpecs.height = static_cast<uint32_t>(height);
-  equirectSpecs.format = VK_FORMAT_R32G32B32A32_SFLOAT;
-  equirectSpecs.usage =
-      VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+// Records a copy of every mip of a baked image (SHADER_READ_ONLY_OPTIMAL,
+// written by compute) into buffer at offset
+static void recordReadback(VkCommandBuffer cb, const Image &image,
+                           VkBuffer buffer, VkDeviceSize offset) {
+  const ImageSpecs &specs = image.getSpecs();
 
-  auto equirect = std::make_unique<Image>(m_context, equirectSpecs);
-  equirect->upload(data, width * height * 4 * sizeof(float));
-  stbi_image_free(data);
+  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+  barrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+  barrier.image = image.getHandle();
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.levelCount = specs.mipLevels;
+  barrier.subresourceRange.layerCount = specs.arrayLayers;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
 
-  // Convert to Cubemap
-  convertEquirectToCube(equirect);
+  std::vector<VkBufferImageCopy> regions(specs.mipLevels);
+  for (uint32_t i = 0; i < specs.mipLevels; ++i) {
+    regions[i].bufferOffset = offset;
+    regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    regions[i].imageSubresource.mipLevel = i;
+    regions[i].imageSubresource.layerCount = specs.arrayLayers;
+    regions[i].imageExtent = {std::max(specs.width >> i, 1u),
+                              std::max(specs.height >> i, 1u), 1};
+    offset += getPackedSize(specs.format, specs.width >> i, specs.height >> i,
+                            specs.arrayLayers, 1);
+  }
+  vkCmdCopyImageToBuffer(cb, image.getHandle(),
+                         VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer,
+                         static_cast<uint32_t>(regions.size()),
+                         regions.data());
 
-  // Generate IBL maps
-  generateIrradiance();
-  generatePrefiltered();
-  generateBrdfLut();
+  barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barrier.srcAccessMask = 0;
+  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
+}
 
-  spdlog::info("Environment IBL maps generated successfully.");
+static VkImageMemoryBarrier makeLayoutBarrier(const Image &image,
+                                              VkImageLayout oldLayout,
+                                              VkImageLayout newLayout,
+                                              VkAccessFlags srcAccess,
+                                              VkAccessFlags dstAccess) {
+  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+  barrier.oldLayout = oldLayout;
+  barrier.newLayout = newLayout;
+  barrier.srcAccessMask = srcAccess;
+  barrier.dstAccessMask = dstAccess;
+  barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  barrier.image = image.getHandle();
+  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+  barrier.subresourceRange.levelCount = image.getSpecs().mipLevels;
+  barrier.subresourceRange.layerCount = image.getSpecs().arrayLayers;
+  return barrier;
 }
 
-void EnvironmentManager::convertEquirectToCube(
-    const std::unique_ptr<Image> &equirect) {
-  uint32_t cubemapSize = 1024;
+// Sums the per-workgroup partials of sh_project.comp into irradiance SH.
+// The projection is normalized by the measured solid angle (4 pi for an
+// exact quadrature) and each band is convolved with the clamped cosine,
+// A_l / pi = 1, 2/3, 1/4, which yields irradiance / pi.
+static std::array<glm::vec4, 9>
+reduceIrradianceSH(const glm::vec4 *partials) {
+  glm::dvec4 sums[SH_COEFFICIENTS] = {};
+  for (uint32_t group = 0; group < SH_GROUP_COUNT; ++group) {
+    for (uint32_t k = 0; k < SH_COEFFICIENTS; ++k) {
+      sums[k] += glm::dvec4(partials[group * SH_COEFFICIENTS + k]);
+    }
+  }
 
-  ImageSpecs cubeSpecs;
-  cubeSpecs.width = cubemapSize;
-  cubeSpecs.height = cubemapSize;
-  cubeSpecs.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-  cubeSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
-                    VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-  cubeSpecs.arrayLayers = 6;
-  cubeSpecs.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+  constexpr double bandFactors[] = {1.0,       2.0 / 3.0, 2.0 / 3.0,
+                                    2.0 / 3.0, 0.25,      0.25,
+                                    0.25,      0.25,      0.25};
+  const double normalization =
+      sums[0].w > 0.0 ? 4.0 * glm::pi<double>() / sums[0].w : 0.0;
 
-  m_skybox = std::make_unique<Image>(m_context, cubeSpecs);
+  std::array<glm::vec4, 9> result;
+  for (uint32_t k = 0; k < SH_COEFFICIENTS; ++k) {
+    result[k] = glm::vec4(
+        glm::dvec3(sums[k]) * (normalization * bandFactors[k]), 0.0f);
+  }
+  return result;
+}
 
+static VkSamplerCreateInfo getClampSamplerInfo(float maxLod) {
   VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
   samplerInfo.magFilter = VK_FILTER_LINEAR;
   samplerInfo.minFilter = VK_FILTER_LINEAR;
   samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  samplerInfo.minLod = 0.0f;
+  samplerInfo.maxLod = maxLod;
   samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
   samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
   samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  return samplerInfo;
+}
 
-  VkSampler sampler;
-  vkCreateSampler(m_context->getDevice(), &samplerInfo, nullptr, &sampler);
+static uint64_t computeBakeKey(const void *hdrData, size_t hdrSize) {
+  uint64_t key = hashBytes(hdrData, hdrSize);
+  for (uint32_t param : {SKYBOX_SIZE, SH_TILES, PREFILTERED_SIZE,
+                         PREFILTERED_MIPS, BRDF_LUT_SIZE,
+                         static_cast<uint32_t>(CUBE_FORMAT),
+                         static_cast<uint32_t>(BRDF_LUT_FORMAT)}) {
+    key = hashCombine(key, param);
+  }
+  // Edited bake shaders invalidate old entries
+  for (const char *shader : BAKE_SHADERS) {
+    try {
+      key = hashCombine(key, hashString(readAssetFile(shader)));
+    } catch (const std::exception &) {
+      // Missing shaders fail the bake itself
+    }
+  }
+  return key;
+}
 
-  uint32_t equirectIdx = m_context->getDescriptorManager().registerImage(
-      equirect->getView(), sampler);
-  uint32_t cubeIdx = m_context->getDescriptorManager().registerStorageImage(
-      m_skybox->getView());
-  m_skyboxIndex = m_context->getDescriptorManager().registerImageCube(
-      m_skybox->getView(), sampler);
+// Whether a cache entry matches what a bake would produce
+static bool isValidCacheEntry(const IblCacheData &baked) {
+  const std::pair<const IblCacheImage *, uint32_t> images[] = {
+      {&baked.skybox, 6}, {&baked.prefiltered, 6}, {&baked.brdfLut, 1}};
+  for (const auto &[image, layers] : images) {
+    // The format comes from the file; getTexelSize throws for others
+    if (image->format != VK_FORMAT_R16G16_SFLOAT &&
+        image->format != VK_FORMAT_R16G16B16A16_SFLOAT &&
+        image->format != VK_FORMAT_R32G32B32A32_SFLOAT) {
+      return false;
+    }
+    if (image->layers != layers || image->mipLevels == 0 ||
+        image->mipLevels > 32 ||
+        image->data.size() != getPackedSize(image->format, image->width,
+                                            image->height, image->layers,
+                                            image->mipLevels)) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  auto compShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/equirect_to_cube.comp.spv"),
-      ShaderStage::Compute, "EquirectToCube");
+// Records a copy of every mip of image from buffer at offset, packed as in
+// IblCacheImage, and leaves it SHADER_READ_ONLY_OPTIMAL
+static void recordUpload(VkCommandBuffer cb, const Image &image,
+                         VkBuffer buffer, VkDeviceSize offset) {
+  const ImageSpecs &specs = image.getSpecs();
+
+  VkImageMemoryBarrier barrier = makeLayoutBarrier(
+      image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+      0, VK_ACCESS_TRANSFER_WRITE_BIT);
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                       nullptr, 1, &barrier);
 
-  VkPushConstantRange pushRange = {};
-  pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-  pushRange.offset = 0;
-  pushRange.size = sizeof(uint32_t) * 2;
+  std::vector<VkBufferImageCopy> regions(specs.mipLevels);
+  for (uint32_t i = 0; i < specs.mipLevels; ++i) {
+    regions[i].bufferOffset = offset;
+    regions[i].imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    regions[i].imageSubresource.mipLevel = i;
+    regions[i].imageSubresource.layerCount = specs.arrayLayers;
+    regions[i].imageExtent = {std::max(specs.width >> i, 1u),
+                              std::max(specs.height >> i, 1u), 1};
+    offset += getPackedSize(specs.format, specs.width >> i, specs.height >> i,
+                            specs.arrayLayers, 1);
+  }
+  vkCmdCopyBufferToImage(cb, buffer, image.getHandle(),
+                         VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                         static_cast<uint32_t>(regions.size()),
+                         regions.data());
+
+  barrier = makeLayoutBarrier(image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                              VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                              VK_ACCESS_TRANSFER_WRITE_BIT,
+                              VK_ACCESS_SHADER_READ_BIT);
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
 
-  VkPipelineLayoutCreateInfo layoutInfo = {
-      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-  layoutInfo.pushConstantRangeCount = 1;
-  layoutInfo.pPushConstantRanges = &pushRange;
-  VkDescriptorSetLayout setLayouts[] = {
-      m_context->getDescriptorManager().getLayout()};
-  layoutInfo.setLayoutCount = 1;
-  layoutInfo.pSetLayouts = setLayouts;
+EnvironmentManager::EnvironmentManager(Context *context)
+    : m_context(context), m_threadPool(std::make_unique<ThreadPool>()) {
+  // Baked maps use exclusive sharing, so bakes stay in the graphics family,
+  // on its second queue where the device has one
+  m_bakeQueueFamily = m_context->getQueueFamilyIndices().graphicsFamily.value();
+  m_bakeQueue = m_context->getAsyncComputeQueue();
+
+  VkSemaphoreTypeCreateInfo typeInfo = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO};
+  typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+  typeInfo.initialValue = 0;
+  VkSemaphoreCreateInfo semaphoreInfo = {
+      VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+  semaphoreInfo.pNext = &typeInfo;
+  if (vkCreateSemaphore(m_context->getDevice(), &semaphoreInfo, nullptr,
+                        &m_timeline) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create IBL bake timeline semaphore!");
+  }
+}
 
-  VkPipelineLayout layout;
-  vkCreatePipelineLayout(m_context->getDevice(), &layoutInfo, nullptr, &layout);
-
-  ComputePipelineSpecs specs;
-  specs.computeShader = compShader;
-  specs.layout = layout;
-  ComputePipeline pipeline(m_context, specs);
-
-  ImmediateCommands cmd(m_context);
-  VkCommandBuffer cb = cmd.getBuffer();
-
-  // Transition skybox to GENERAL for storage writing
-  {
-    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier.image = m_skybox->getHandle();
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.layerCount = 6;
-    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                         nullptr, 1, &barrier);
+EnvironmentManager::~EnvironmentManager() {
+  for (auto &decode : m_decodes) {
+    decode.result.wait();
   }
+  m_decodes.clear();
+  if (m_bake) {
+    waitForBake();
+    for (VkImageView view : m_bake->prefilteredMipViews) {
+      vkDestroyImageView(m_context->getDevice(), view, nullptr);
+    }
+    m_bake.reset();
+  }
+  // Drains pending cache writes
+  m_threadPool.reset();
 
-  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getHandle());
-  VkDescriptorSet set = m_context->getDescriptorManager().getDescriptorSet();
-  vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1,
-                          &set, 0, nullptr);
+  vkDestroySemaphore(m_context->getDevice(), m_timeline, nullptr);
+  if (m_bakeLayout != VK_NULL_HANDLE) {
+    vkDestroyPipelineLayout(m_context->getDevice(), m_bakeLayout, nullptr);
+  }
+}
 
-  uint32_t pcs[] = {equirectIdx, cubeIdx};
-  vkCmdPushConstants(cb, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pcs),
-                     pcs);
+void EnvironmentManager::loadHDR(const std::string &path) {
+  requestEnvironment(path);
+  while (isLoading()) {
+    for (auto &decode : m_decodes) {
+      decode.result.wait();
+    }
+    if (m_bake) {
+      waitForBake();
+    }
+    poll();
+  }
+}
 
-  vkCmdDispatch(cb, cubemapSize / 16, cubemapSize / 16, 6);
+void EnvironmentManager::requestEnvironment(const std::string &path) {
+  if (!AssetFile::exists(path)) {
+    spdlog::warn("Environment HDR not found at: {}", path);
+    return;
+  }
+  spdlog::info("Loading HDR environment map: {}", path);
 
-  // Barrier for skybox generation
-  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  barrier.image = m_skybox->getHandle();
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.layerCount = 6;
-  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                       nullptr, 1, &barrier);
+  const uint64_t request = ++m_latestRequest;
+  const VkFormat format = getEquirectFormat();
+  m_decodes.push_back(
+      {request, path,
+       m_threadPool->submit(
+           [this, path, cacheDirectory = m_cacheDirectory, format]() {
+             return decode(path, cacheDirectory, format);
+           })});
+}
 
-  vkDestroyPipelineLayout(m_context->getDevice(), layout, nullptr);
+void EnvironmentManager::update() {
+  m_frame++;
+  // Frames recorded before a swap may still sample the old maps
+  while (!m_retired.empty() &&
+         m_frame - m_retired.front().frame >= MAX_FRAMES_IN_FLIGHT) {
+    releaseMaps(m_retired.front().maps);
+    m_retired.pop_front();
+  }
+  poll();
 }
 
-void EnvironmentManager::generateIrradiance() {
-  uint32_t irradianceSize = 32;
+void EnvironmentManager::poll() {
+  if (m_bake && isComplete(*m_bake)) {
+    completeBake();
+  }
 
-  ImageSpecs irrSpecs;
-  irrSpecs.width = irradianceSize;
-  irrSpecs.height = irradianceSize;
-  irrSpecs.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-  irrSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-  irrSpecs.arrayLayers = 6;
-  irrSpecs.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+  // Superseded decodes are dropped as they finish; the latest one is baked
+  // once the GPU is free
+  for (auto it = m_decodes.begin(); it != m_decodes.end();) {
+    if (it->result.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++it;
+      continue;
+    }
+    if (it->request != m_latestRequest) {
+      it = m_decodes.erase(it);
+      continue;
+    }
+    if (m_bake) {
+      break;
+    }
+
+    const uint64_t request = it->request;
+    const std::string path = it->path;
+    std::unique_ptr<DecodedEnvironment> decoded = it->result.get();
+    it = m_decodes.erase(it);
+    if (!decoded) {
+      spdlog::error("Failed to load HDR image: {}", path);
+      continue;
+    }
+    submitBake(request, path, std::move(decoded));
+  }
+}
 
-  m_irradiance = std::make_unique<Image>(m_context, irrSpecs);
+bool EnvironmentManager::isComplete(const BakeJob &job) const {
+  uint64_t value = 0;
+  vkGetSemaphoreCounterValue(m_context->getDevice(), m_timeline, &value);
+  return value >= job.timelineValue;
+}
 
-  VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+void EnvironmentManager::waitForBake() const {
+  VkSemaphoreWaitInfo waitInfo = {VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO};
+  waitInfo.semaphoreCount = 1;
+  waitInfo.pSemaphores = &m_timeline;
+  waitInfo.pValues = &m_bake->timelineValue;
+  vkWaitSemaphores(m_context->getDevice(), &waitInfo, UINT64_MAX);
+}
+
+// Shared exponent halves the equirect upload again over RGBA16F, where the
+// device can filter it
+VkFormat EnvironmentManager::getEquirectFormat() const {
+  VkFormatProperties properties;
+  vkGetPhysicalDeviceFormatProperties(m_context->getPhysicalDevice(),
+                                      VK_FORMAT_E5B9G9R9_UFLOAT_PACK32,
+                                      &properties);
+  const VkFormatFeatureFlags required =
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT |
+      VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT |
+      VK_FORMAT_FEATURE_TRANSFER_DST_BIT;
+  if ((properties.optimalTilingFeatures & required) == required) {
+    return VK_FORMAT_E5B9G9R9_UFLOAT_PACK32;
+  }
+  return VK_FORMAT_R16G16B16A16_SFLOAT;
+}
 
-  VkSampler sampler;
-  vkCreateSampler(m_context->getDevice(), &samplerInfo, nullptr, &sampler);
+// Runs on a worker: reads the baked maps from the IBL cache when an entry
+// for the file's content exists, otherwise decodes the equirect. Either way
+// the texels end up in a staging buffer. Returns null on failure.
+std::unique_ptr<EnvironmentManager::DecodedEnvironment>
+EnvironmentManager::decode(const std::string &path,
+                           const std::filesystem::path &cacheDirectory,
+                           VkFormat format) const {
+  std::unique_ptr<AssetFile> file;
+  try {
+    file = std::make_unique<AssetFile>(path);
+  } catch (const std::exception &e) {
+    spdlog::error("Failed to read HDR image {}: {}", path, e.what());
+    return nullptr;
+  }
 
-  uint32_t outputIdx = m_context->getDescriptorManager().registerStorageImage(
-      m_irradiance->getView());
-  m_irradianceIndex = m_context->getDescriptorManager().registerImageCube(
-      m_irradiance->getView(), sampler);
+  auto result = std::make_unique<DecodedEnvironment>();
+  result->cacheKey = computeBakeKey(file->data(), file->size());
+
+  auto createStaging = [this, &result](VkDeviceSize size) {
+    result->staging = std::make_unique<Buffer>(
+        m_context, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        VMA_MEMORY_USAGE_AUTO,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT);
+    void *mapped = nullptr;
+    result->staging->map(&mapped);
+    return static_cast<uint8_t *>(mapped);
+  };
+  auto finishStaging = [this, &result]() {
+    vmaFlushAllocation(m_context->getAllocator(),
+                       result->staging->getAllocation(), 0, VK_WHOLE_SIZE);
+    result->staging->unmap();
+  };
+
+  // Any failure reading the cache is a miss: the equirect is decoded and
+  // baked instead, and nothing propagates to poll() on the main thread
+  IblCacheData &cached = result->cached;
+  try {
+    if (!cacheDirectory.empty() &&
+        IblCache(cacheDirectory).load(result->cacheKey, cached)) {
+      if (isValidCacheEntry(cached)) {
+        IblCacheImage *images[] = {&cached.skybox, &cached.prefiltered,
+                                   &cached.brdfLut};
+        VkDeviceSize size = 0;
+        for (const IblCacheImage *image : images) {
+          size += image->data.size();
+        }
+        uint8_t *mapped = createStaging(size);
+        for (IblCacheImage *image : images) {
+          std::memcpy(mapped, image->data.data(), image->data.size());
+          mapped += image->data.size();
+        }
+        finishStaging();
+        // The LUT texels are kept for later cache entries
+        cached.skybox.data = {};
+        cached.prefiltered.data = {};
+        result->fromCache = true;
+        return result;
+      }
+      spdlog::warn("IBL cache entry does not match the bake, rebaking");
+    }
+  } catch (const std::exception &e) {
+    spdlog::warn("Failed to read IBL cache entry, rebaking: {}", e.what());
+    result->staging.reset();
+  }
+  cached = IblCacheData();
+
+  // Texels are converted straight into the staging buffer, bottom row
+  // first like the equirect has always been uploaded
+  result->format = format;
+  const size_t texelSize = getHdrTexelSize(format);
+  HdrInfo info;
+  if (readHdrInfo(file->data(), file->size(), info)) {
+    result->width = info.width;
+    result->height = info.height;
+    const bool decoded = decodeHdr(
+        file->data(), file->size(), info, format, true,
+        createStaging(static_cast<VkDeviceSize>(info.width) * info.height *
+                      texelSize),
+        m_threadPool.get());
+    finishStaging();
+    if (!decoded) {
+      return nullptr;
+    }
+    return result;
+  }
 
-  auto compShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/irradiance.comp.spv"),
-      ShaderStage::Compute, "IrradianceMap");
+  // Anything else stb_image reads, through a float intermediate
+  int width, height, channels;
+  float *data = stbi_loadf_from_memory(
+      reinterpret_cast<const stbi_uc *>(file->data()),
+      static_cast<int>(file->size()), &width, &height, &channels, 4);
+  if (!data) {
+    return nullptr;
+  }
+  result->width = static_cast<uint32_t>(width);
+  result->height = static_cast<uint32_t>(height);
+  convertFloatRgba(data, result->width, result->height, format, true,
+                   createStaging(static_cast<VkDeviceSize>(width) * height *
+                                 texelSize),
+                   m_threadPool.get());
+  stbi_image_free(data);
+  finishStaging();
+  return result;
+}
 
+void EnvironmentManager::createBakePipelines() {
+  // One layout for every bake stage; the prefilter pass pushes the most
   VkPushConstantRange pushRange = {};
   pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
   pushRange.offset = 0;
-  pushRange.size = sizeof(uint32_t) * 2;
+  pushRange.size = sizeof(uint32_t) * 2 + sizeof(float);
 
   VkPipelineLayoutCreateInfo layoutInfo = {
       VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
@@ -222,147 +533,226 @@ void EnvironmentManager::generateIrradiance() {
   layoutInfo.setLayoutCount = 1;
   layoutInfo.pSetLayouts = setLayouts;
 
-  VkPipelineLayout layout;
-  vkCreatePipelineLayout(m_context->getDevice(), &layoutInfo, nullptr, &layout);
-
-  ComputePipelineSpecs specs;
-  specs.computeShader = compShader;
-  specs.layout = layout;
-  ComputePipeline pipeline(m_context, specs);
-
-  ImmediateCommands cmd(m_context);
-  VkCommandBuffer cb = cmd.getBuffer();
-
-  // Transition irradiance to GENERAL for storage writing
-  {
-    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier.image = m_irradiance->getHandle();
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.layerCount = 6;
-    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                         nullptr, 1, &barrier);
+  if (vkCreatePipelineLayout(m_context->getDevice(), &layoutInfo, nullptr,
+                             &m_bakeLayout) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create IBL bake pipeline layout!");
   }
 
-  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getHandle());
-  VkDescriptorSet set = m_context->getDescriptorManager().getDescriptorSet();
-  vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1,
-                          &set, 0, nullptr);
-
-  uint32_t pcs[] = {m_skyboxIndex, outputIdx};
-  vkCmdPushConstants(cb, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(pcs),
-                     pcs);
-
-  vkCmdDispatch(cb, irradianceSize / 16, irradianceSize / 16, 6);
-
-  // Barrier for irradiance generation
-  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  barrier.image = m_irradiance->getHandle();
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.layerCount = 6;
-  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                       nullptr, 1, &barrier);
-
-  vkDestroyPipelineLayout(m_context->getDevice(), layout, nullptr);
+  auto createPipeline = [this](const char *path, const char *name) {
+    ComputePipelineSpecs specs;
+    specs.computeShader = std::make_shared<Shader>(
+        m_context, readAssetFile(path), ShaderStage::Compute, name);
+    specs.layout = m_bakeLayout;
+    return std::make_unique<ComputePipeline>(m_context, specs);
+  };
+  m_equirectPipeline = createPipeline(BAKE_SHADERS[0], "EquirectToCube");
+  m_shProjectPipeline = createPipeline(BAKE_SHADERS[1], "SHProject");
+  m_prefilterPipeline = createPipeline(BAKE_SHADERS[2], "PrefilterMap");
+  m_brdfLutPipeline = createPipeline(BAKE_SHADERS[3], "BrdfLut");
+
+  const VkDeviceSize partialsSize =
+      sizeof(glm::vec4) * SH_COEFFICIENTS * SH_GROUP_COUNT;
+  m_shPartials = std::make_unique<Buffer>(
+      m_context, partialsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+      VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+  m_shPartialsIndex = m_context->getDescriptorManager().registerBuffer(
+      m_shPartials->getHandle(), 0, partialsSize);
 }
 
-void EnvironmentManager::generatePrefiltered() {
-  uint32_t prefilteredSize = 512;
-  uint32_t mipLevels = 5;
-
-  ImageSpecs prefSpecs;
-  prefSpecs.width = prefilteredSize;
-  prefSpecs.height = prefilteredSize;
-  prefSpecs.format = VK_FORMAT_R16G16B16A16_SFLOAT;
-  prefSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-  prefSpecs.arrayLayers = 6;
-  prefSpecs.mipLevels = mipLevels;
-  prefSpecs.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-
-  m_prefiltered = std::make_unique<Image>(m_context, prefSpecs);
-
-  VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  samplerInfo.minLod = 0.0f;
-  samplerInfo.maxLod = static_cast<float>(mipLevels);
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-
-  VkSampler sampler;
-  vkCreateSampler(m_context->getDevice(), &samplerInfo, nullptr, &sampler);
-
-  m_prefilteredIndex = m_context->getDescriptorManager().registerImageCube(
-      m_prefiltered->getView(), sampler);
+// Records the upload of the bake and the equirect, then the bake itself,
+// and on a cache miss the readback, into one command buffer that signals
+// the timeline when done
+void EnvironmentManager::submitBake(
+    uint64_t request, const std::string &path,
+    std::unique_ptr<DecodedEnvironment> source) {
+  if (m_bakeLayout == VK_NULL_HANDLE) {
+    createBakePipelines();
+  }
 
-  auto compShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/prefilter.comp.spv"),
-      ShaderStage::Compute, "PrefilterMap");
+  auto job = std::make_unique<BakeJob>();
+  job->request = request;
+  job->path = path;
+  job->source = std::move(source);
+  const DecodedEnvironment &decoded = *job->source;
+
+  VkSampler sampler =
+      m_context->getSamplerCache().getSampler(getClampSamplerInfo(0.0f));
+
+  job->commandPool = std::make_unique<CommandPool>(
+      m_context, m_bakeQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+  job->commandBuffer = job->commandPool->allocateBuffer();
+  job->commandBuffer->begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+  VkCommandBuffer cb = job->commandBuffer->getHandle();
+
+  if (decoded.fromCache) {
+    recordCachedUpload(*job, cb);
+  } else {
+    ImageSpecs equirectSpecs;
+    equirectSpecs.width = decoded.width;
+    equirectSpecs.height = decoded.height;
+    equirectSpecs.format = decoded.format;
+    equirectSpecs.usage =
+        VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    job->equirect = std::make_unique<Image>(m_context, equirectSpecs);
+    job->equirectIndex = m_context->getDescriptorManager().registerImage(
+        job->equirect->getView(), sampler);
+
+    VkImageMemoryBarrier barrier = makeLayoutBarrier(
+        *job->equirect, VK_IMAGE_LAYOUT_UNDEFINED,
+        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, VK_ACCESS_TRANSFER_WRITE_BIT);
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0,
+                         nullptr, 1, &barrier);
 
-  VkPushConstantRange pushRange = {};
-  pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-  pushRange.offset = 0;
-  pushRange.size = sizeof(uint32_t) * 2 + sizeof(float);
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {decoded.width, decoded.height, 1};
+    vkCmdCopyBufferToImage(cb, decoded.staging->getHandle(),
+                           job->equirect->getHandle(),
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    barrier = makeLayoutBarrier(
+        *job->equirect, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_TRANSFER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT);
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr,
+                         0, nullptr, 1, &barrier);
+
+    createBakeTargets(*job, sampler);
+    recordBake(*job, cb, job->equirectIndex);
+
+    // Only images created by this job are read back; the shared LUT may be
+    // sampled by frames in flight
+    if (!m_cacheDirectory.empty()) {
+      std::vector<const Image *> images = {job->maps.skybox.get(),
+                                           job->maps.prefiltered.get()};
+      if (job->brdfLut) {
+        images.push_back(job->brdfLut.get());
+      }
+      VkDeviceSize readbackSize = 0;
+      for (const Image *image : images) {
+        readbackSize += getPackedSize(*image);
+      }
+      job->readback = std::make_unique<Buffer>(
+          m_context, readbackSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+          VMA_MEMORY_USAGE_AUTO, VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT);
+      VkDeviceSize offset = 0;
+      for (const Image *image : images) {
+        recordReadback(cb, *image, job->readback->getHandle(), offset);
+        offset += getPackedSize(*image);
+      }
+    }
+  }
+  job->commandBuffer->end();
+
+  job->timelineValue = ++m_timelineValue;
+  VkTimelineSemaphoreSubmitInfo timelineInfo = {
+      VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO};
+  timelineInfo.signalSemaphoreValueCount = 1;
+  timelineInfo.pSignalSemaphoreValues = &job->timelineValue;
+
+  VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.pNext = &timelineInfo;
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &cb;
+  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.pSignalSemaphores = &m_timeline;
+  m_context->getDescriptorManager().flush();
+  if (vkQueueSubmit(m_bakeQueue, 1, &submitInfo, VK_NULL_HANDLE) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to submit IBL bake!");
+  }
+  m_bake = std::move(job);
+}
 
-  VkPipelineLayoutCreateInfo layoutInfo = {
-      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-  layoutInfo.pushConstantRangeCount = 1;
-  layoutInfo.pPushConstantRanges = &pushRange;
-  VkDescriptorSetLayout setLayouts[] = {
-      m_context->getDescriptorManager().getLayout()};
-  layoutInfo.setLayoutCount = 1;
-  layoutInfo.pSetLayouts = setLayouts;
+// Creates the maps of a cache entry and records their upload from the
+// staging buffer, which holds skybox, prefiltered map and LUT in that order
+void EnvironmentManager::recordCachedUpload(BakeJob &job, VkCommandBuffer cb) {
+  const DecodedEnvironment &decoded = *job.source;
+  auto &descriptors = m_context->getDescriptorManager();
+  auto &samplers = m_context->getSamplerCache();
+
+  auto createImage = [this](const IblCacheImage &cached,
+                            VkImageViewType viewType) {
+    ImageSpecs specs;
+    specs.width = cached.width;
+    specs.height = cached.height;
+    specs.format = cached.format;
+    specs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT |
+                  VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    specs.arrayLayers = cached.layers;
+    specs.mipLevels = cached.mipLevels;
+    specs.viewType = viewType;
+    return std::make_unique<Image>(m_context, specs);
+  };
+
+  job.maps.skybox =
+      createImage(decoded.cached.skybox, VK_IMAGE_VIEW_TYPE_CUBE);
+  job.maps.prefiltered =
+      createImage(decoded.cached.prefiltered, VK_IMAGE_VIEW_TYPE_CUBE);
+  VkDeviceSize offset = 0;
+  for (const Image *image :
+       {job.maps.skybox.get(), job.maps.prefiltered.get()}) {
+    recordUpload(cb, *image, decoded.staging->getHandle(), offset);
+    offset += getPackedSize(*image);
+  }
 
-  VkPipelineLayout layout;
-  vkCreatePipelineLayout(m_context->getDevice(), &layoutInfo, nullptr, &layout);
-
-  ComputePipelineSpecs specs;
-  specs.computeShader = compShader;
-  specs.layout = layout;
-  ComputePipeline pipeline(m_context, specs);
-
-  ImmediateCommands cmd(m_context);
-  VkCommandBuffer cb = cmd.getBuffer();
-
-  // Transition prefiltered to GENERAL for storage writing
-  {
-    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier.image = m_prefiltered->getHandle();
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.levelCount = mipLevels;
-    barrier.subresourceRange.layerCount = 6;
-    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                         nullptr, 1, &barrier);
+  VkSampler sampler = samplers.getSampler(getClampSamplerInfo(0.0f));
+  job.maps.skyboxIndex =
+      descriptors.registerImageCube(job.maps.skybox->getView(), sampler);
+  job.maps.prefilteredIndex = descriptors.registerImageCube(
+      job.maps.prefiltered->getView(),
+      samplers.getSampler(getClampSamplerInfo(
+          static_cast<float>(job.maps.prefiltered->getSpecs().mipLevels))));
+
+  // The LUT does not depend on the environment
+  if (!m_brdfLut) {
+    job.brdfLut = createImage(decoded.cached.brdfLut, VK_IMAGE_VIEW_TYPE_2D);
+    recordUpload(cb, *job.brdfLut, decoded.staging->getHandle(), offset);
+    job.brdfLutIndex = descriptors.registerImage(job.brdfLut->getView(),
+                                                 sampler);
   }
+}
 
-  for (uint32_t i = 0; i < mipLevels; ++i) {
-    uint32_t mipWidth = prefilteredSize >> i;
-    uint32_t mipHeight = prefilteredSize >> i;
-    float roughness = static_cast<float>(i) / static_cast<float>(mipLevels - 1);
+// Creates the bake outputs and their sampled and storage bindless slots
+void EnvironmentManager::createBakeTargets(BakeJob &job, VkSampler sampler) {
+  auto &descriptors = m_context->getDescriptorManager();
+  auto &samplers = m_context->getSamplerCache();
+
+  ImageSpecs cubeSpecs;
+  cubeSpecs.width = SKYBOX_SIZE;
+  cubeSpecs.height = SKYBOX_SIZE;
+  cubeSpecs.format = CUBE_FORMAT;
+  cubeSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+                    VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+  cubeSpecs.arrayLayers = 6;
+  cubeSpecs.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
 
-    // We need a view for each mip level for storage image access
+  job.maps.skybox = std::make_unique<Image>(m_context, cubeSpecs);
+  job.skyboxStorageIndex =
+      descriptors.registerStorageImage(job.maps.skybox->getView());
+  job.maps.skyboxIndex =
+      descriptors.registerImageCube(job.maps.skybox->getView(), sampler);
+
+  ImageSpecs prefSpecs = cubeSpecs;
+  prefSpecs.width = PREFILTERED_SIZE;
+  prefSpecs.height = PREFILTERED_SIZE;
+  prefSpecs.mipLevels = PREFILTERED_MIPS;
+
+  job.maps.prefiltered = std::make_unique<Image>(m_context, prefSpecs);
+  job.maps.prefilteredIndex = descriptors.registerImageCube(
+      job.maps.prefiltered->getView(),
+      samplers.getSampler(
+          getClampSamplerInfo(static_cast<float>(PREFILTERED_MIPS))));
+
+  // Each mip is written through its own storage view
+  for (uint32_t i = 0; i < PREFILTERED_MIPS; ++i) {
     VkImageViewCreateInfo viewInfo = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
-    viewInfo.image = m_prefiltered->getHandle();
+    viewInfo.image = job.maps.prefiltered->getHandle();
     viewInfo.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
-    viewInfo.format = VK_FORMAT_R16G16B16A16_SFLOAT;
+    viewInfo.format = CUBE_FORMAT;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = i;
     viewInfo.subresourceRange.levelCount = 1;
@@ -370,147 +760,258 @@ void EnvironmentManager::generatePrefiltered() {
     viewInfo.subresourceRange.layerCount = 6;
 
     VkImageView mipView;
-    vkCreateImageView(m_context->getDevice(), &viewInfo, nullptr, &mipView);
-    uint32_t mipOutputIdx =
-        m_context->getDescriptorManager().registerStorageImage(mipView);
+    if (vkCreateImageView(m_context->getDevice(), &viewInfo, nullptr,
+                          &mipView) != VK_SUCCESS) {
+      throw std::runtime_error("Failed to create prefiltered mip view!");
+    }
+    job.prefilteredMipViews.push_back(mipView);
+    job.prefilteredMipIndices.push_back(
+        descriptors.registerStorageImage(mipView));
+  }
+
+  // The BRDF LUT does not depend on the environment and is baked once
+  if (!m_brdfLut) {
+    ImageSpecs lutSpecs;
+    lutSpecs.width = BRDF_LUT_SIZE;
+    lutSpecs.height = BRDF_LUT_SIZE;
+    lutSpecs.format = BRDF_LUT_FORMAT;
+    lutSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT |
+                     VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+    job.brdfLut = std::make_unique<Image>(m_context, lutSpecs);
+    job.brdfLutStorageIndex =
+        descriptors.registerStorageImage(job.brdfLut->getView());
+    job.brdfLutIndex = descriptors.registerImage(job.brdfLut->getView(),
+                                                 sampler);
+  }
+}
+
+// Records equirect -> cube, SH projection, prefilter and (optionally) BRDF
+// LUT passes with only the barriers between dependent stages
+void EnvironmentManager::recordBake(BakeJob &job, VkCommandBuffer cb,
+                                    uint32_t equirectIndex) {
+  const bool bakeBrdfLut = job.brdfLut != nullptr;
+
+  // Every target becomes writable at once
+  std::vector<VkImageMemoryBarrier> barriers;
+  for (const Image *image :
+       {job.maps.skybox.get(), job.maps.prefiltered.get()}) {
+    barriers.push_back(makeLayoutBarrier(*image, VK_IMAGE_LAYOUT_UNDEFINED,
+                                         VK_IMAGE_LAYOUT_GENERAL, 0,
+                                         VK_ACCESS_SHADER_WRITE_BIT));
+  }
+  if (bakeBrdfLut) {
+    barriers.push_back(makeLayoutBarrier(*job.brdfLut,
+                                         VK_IMAGE_LAYOUT_UNDEFINED,
+                                         VK_IMAGE_LAYOUT_GENERAL, 0,
+                                         VK_ACCESS_SHADER_WRITE_BIT));
+  }
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
+                       nullptr, static_cast<uint32_t>(barriers.size()),
+                       barriers.data());
+
+  m_context->getDescriptorManager().bind(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                         m_bakeLayout);
+
+  // The LUT has no inputs and overlaps with the cube passes
+  if (bakeBrdfLut) {
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      m_brdfLutPipeline->getHandle());
+    vkCmdPushConstants(cb, m_bakeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(uint32_t), &job.brdfLutStorageIndex);
+    vkCmdDispatch(cb, BRDF_LUT_SIZE / 16, BRDF_LUT_SIZE / 16, 1);
+  }
 
-    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getHandle());
-    VkDescriptorSet set = m_context->getDescriptorManager().getDescriptorSet();
-    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1,
-                            &set, 0, nullptr);
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    m_equirectPipeline->getHandle());
+  uint32_t equirectPcs[] = {equirectIndex, job.skyboxStorageIndex};
+  vkCmdPushConstants(cb, m_bakeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(equirectPcs), equirectPcs);
+  vkCmdDispatch(cb, SKYBOX_SIZE / 16, SKYBOX_SIZE / 16, 6);
+
+  // SH projection and prefilter sample the finished skybox
+  VkImageMemoryBarrier skyboxBarrier = makeLayoutBarrier(
+      *job.maps.skybox, VK_IMAGE_LAYOUT_GENERAL,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT);
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0, 0, nullptr, 0, nullptr, 1, &skyboxBarrier);
+
+  // Every skybox texel contributes once; partials are read on the host
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    m_shProjectPipeline->getHandle());
+  uint32_t shPcs[] = {job.maps.skyboxIndex, m_shPartialsIndex, SKYBOX_SIZE};
+  vkCmdPushConstants(cb, m_bakeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                     sizeof(shPcs), shPcs);
+  vkCmdDispatch(cb, SH_TILES, SH_TILES, 6);
+
+  VkBufferMemoryBarrier shBarrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+  shBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  shBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+  shBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  shBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  shBarrier.buffer = m_shPartials->getHandle();
+  shBarrier.size = VK_WHOLE_SIZE;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1,
+                       &shBarrier, 0, nullptr);
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    m_prefilterPipeline->getHandle());
+  for (uint32_t i = 0; i < PREFILTERED_MIPS; ++i) {
+    uint32_t mipSize = PREFILTERED_SIZE >> i;
 
     struct PushConstants {
       uint32_t inputIdx;
       uint32_t outputIdx;
       float roughness;
     } pc;
-    pc.inputIdx = m_skyboxIndex;
-    pc.outputIdx = mipOutputIdx;
-    pc.roughness = roughness;
-    vkCmdPushConstants(cb, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+    pc.inputIdx = job.maps.skyboxIndex;
+    pc.outputIdx = job.prefilteredMipIndices[i];
+    pc.roughness =
+        static_cast<float>(i) / static_cast<float>(PREFILTERED_MIPS - 1);
+    vkCmdPushConstants(cb, m_bakeLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
                        sizeof(PushConstants), &pc);
-
-    vkCmdDispatch(cb, std::max(1u, mipWidth / 16), std::max(1u, mipHeight / 16),
+    vkCmdDispatch(cb, std::max(1u, mipSize / 16), std::max(1u, mipSize / 16),
                   6);
-
-    // Note: In a production renderer, we would cleanup these views or reuse
-    // them. For now we just let them leak as this is a one-time startup
-    // operation.
   }
 
-  // Barrier for prefiltered generation
-  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  barrier.image = m_prefiltered->getHandle();
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.levelCount = mipLevels;
-  barrier.subresourceRange.layerCount = 6;
+  barriers.clear();
+  barriers.push_back(makeLayoutBarrier(
+      *job.maps.prefiltered, VK_IMAGE_LAYOUT_GENERAL,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT,
+      VK_ACCESS_SHADER_READ_BIT));
+  if (bakeBrdfLut) {
+    barriers.push_back(makeLayoutBarrier(
+        *job.brdfLut, VK_IMAGE_LAYOUT_GENERAL,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_ACCESS_SHADER_WRITE_BIT,
+        VK_ACCESS_SHADER_READ_BIT));
+  }
   vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                       nullptr, 1, &barrier);
-
-  vkDestroyPipelineLayout(m_context->getDevice(), layout, nullptr);
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT |
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       0, 0, nullptr, 0, nullptr,
+                       static_cast<uint32_t>(barriers.size()),
+                       barriers.data());
 }
 
-void EnvironmentManager::generateBrdfLut() {
-  uint32_t lutSize = 512;
-
-  ImageSpecs lutSpecs;
-  lutSpecs.width = lutSize;
-  lutSpecs.height = lutSize;
-  lutSpecs.format = VK_FORMAT_R16G16_SFLOAT;
-  lutSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
-
-  m_brdfLut = std::make_unique<Image>(m_context, lutSpecs);
-
-  VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
-  samplerInfo.magFilter = VK_FILTER_LINEAR;
-  samplerInfo.minFilter = VK_FILTER_LINEAR;
-  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-
-  VkSampler sampler;
-  vkCreateSampler(m_context->getDevice(), &samplerInfo, nullptr, &sampler);
-
-  uint32_t outputIdx = m_context->getDescriptorManager().registerStorageImage(
-      m_brdfLut->getView());
-  m_brdfLutIndex = m_context->getDescriptorManager().registerImage(
-      m_brdfLut->getView(), sampler);
-
-  auto compShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/brdf_lut.comp.spv"),
-      ShaderStage::Compute, "BrdfLut");
-
-  VkPushConstantRange pushRange = {};
-  pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-  pushRange.offset = 0;
-  pushRange.size = sizeof(uint32_t);
-
-  VkPipelineLayoutCreateInfo layoutInfo = {
-      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-  layoutInfo.pushConstantRangeCount = 1;
-  layoutInfo.pPushConstantRanges = &pushRange;
-  VkDescriptorSetLayout setLayouts[] = {
-      m_context->getDescriptorManager().getLayout()};
-  layoutInfo.setLayoutCount = 1;
-  layoutInfo.pSetLayouts = setLayouts;
+void EnvironmentManager::releaseMaps(EnvironmentMaps &maps) {
+  auto &descriptors = m_context->getDescriptorManager();
+  for (uint32_t index : {maps.skyboxIndex, maps.prefilteredIndex}) {
+    if (index != (uint32_t)-1) {
+      descriptors.unregisterImageCube(index);
+    }
+  }
+  maps.skyboxIndex = (uint32_t)-1;
+  maps.prefilteredIndex = (uint32_t)-1;
+}
 
-  VkPipelineLayout layout;
-  vkCreatePipelineLayout(m_context->getDevice(), &layoutInfo, nullptr, &layout);
-
-  ComputePipelineSpecs specs;
-  specs.computeShader = compShader;
-  specs.layout = layout;
-  ComputePipeline pipeline(m_context, specs);
-
-  ImmediateCommands cmd(m_context);
-  VkCommandBuffer cb = cmd.getBuffer();
-
-  // Transition BRDF LUT to GENERAL for storage writing
-  {
-    VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier.image = m_brdfLut->getHandle();
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.layerCount = 1;
-    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                         nullptr, 1, &barrier);
+// Runs once the bake's timeline value is reached: finishes the SH, hands
+// the readback to a worker for the IBL cache and swaps the maps in
+void EnvironmentManager::completeBake() {
+  std::unique_ptr<BakeJob> job = std::move(m_bake);
+  // Even a superseded bake may hand over the BRDF LUT
+  m_swapWaitValue = job->timelineValue;
+  for (VkImageView view : job->prefilteredMipViews) {
+    vkDestroyImageView(m_context->getDevice(), view, nullptr);
   }
 
-  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.getHandle());
-  VkDescriptorSet set = m_context->getDescriptorManager().getDescriptorSet();
-  vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, layout, 0, 1,
-                          &set, 0, nullptr);
+  // Slots only the bake used
+  auto &descriptors = m_context->getDescriptorManager();
+  for (uint32_t index : job->prefilteredMipIndices) {
+    descriptors.unregisterStorageImage(index);
+  }
+  for (uint32_t index : {job->skyboxStorageIndex, job->brdfLutStorageIndex}) {
+    if (index != (uint32_t)-1) {
+      descriptors.unregisterStorageImage(index);
+    }
+  }
+  if (job->equirectIndex != (uint32_t)-1) {
+    descriptors.unregisterImage(job->equirectIndex);
+  }
 
-  vkCmdPushConstants(cb, layout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
-                     sizeof(uint32_t), &outputIdx);
+  DecodedEnvironment &source = *job->source;
+  if (source.fromCache) {
+    job->maps.irradianceSH = source.cached.irradianceSH;
+  } else {
+    void *partials = nullptr;
+    m_shPartials->map(&partials);
+    vmaInvalidateAllocation(m_context->getAllocator(),
+                            m_shPartials->getAllocation(), 0, VK_WHOLE_SIZE);
+    job->maps.irradianceSH =
+        reduceIrradianceSH(static_cast<const glm::vec4 *>(partials));
+    m_shPartials->unmap();
+  }
 
-  vkCmdDispatch(cb, lutSize / 16, lutSize / 16, 1);
+  if (job->brdfLut) {
+    m_brdfLut = std::move(job->brdfLut);
+    m_brdfLutIndex = job->brdfLutIndex;
+    if (source.fromCache) {
+      m_brdfLutCache = std::move(source.cached.brdfLut);
+    } else if (job->readback) {
+      // The LUT follows skybox and prefiltered map in the readback
+      m_brdfLutCache = describeImage(*m_brdfLut);
+      const VkDeviceSize offset = getPackedSize(*job->maps.skybox) +
+                                  getPackedSize(*job->maps.prefiltered);
+      void *mapped = nullptr;
+      job->readback->map(&mapped);
+      vmaInvalidateAllocation(m_context->getAllocator(),
+                              job->readback->getAllocation(), 0,
+                              VK_WHOLE_SIZE);
+      const auto *bytes = static_cast<const uint8_t *>(mapped) + offset;
+      m_brdfLutCache.data.assign(bytes, bytes + getPackedSize(*m_brdfLut));
+      job->readback->unmap();
+    }
+  }
 
-  // Barrier for BRDF LUT generation
-  VkImageMemoryBarrier barrier = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
-  barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-  barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-  barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-  barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-  barrier.image = m_brdfLut->getHandle();
-  barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-  barrier.subresourceRange.levelCount = 1;
-  barrier.subresourceRange.layerCount = 1;
-  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0,
-                       nullptr, 1, &barrier);
+  // Copying out tens of megabytes and writing the file happen on a worker
+  if (job->readback && !m_brdfLutCache.data.empty()) {
+    IblCacheData baked;
+    baked.skybox = describeImage(*job->maps.skybox);
+    baked.prefiltered = describeImage(*job->maps.prefiltered);
+    baked.brdfLut = m_brdfLutCache;
+    baked.irradianceSH = job->maps.irradianceSH;
+    m_threadPool->submit([this, readback = std::shared_ptr<Buffer>(
+                                    std::move(job->readback)),
+                          baked = std::move(baked),
+                          cacheDirectory = m_cacheDirectory,
+                          cacheKey = source.cacheKey]() mutable {
+      void *mapped = nullptr;
+      readback->map(&mapped);
+      vmaInvalidateAllocation(m_context->getAllocator(),
+                              readback->getAllocation(), 0, VK_WHOLE_SIZE);
+      VkDeviceSize offset = 0;
+      for (IblCacheImage *image : {&baked.skybox, &baked.prefiltered}) {
+        VkDeviceSize size =
+            getPackedSize(image->format, image->width, image->height,
+                          image->layers, image->mipLevels);
+        const auto *bytes = static_cast<const uint8_t *>(mapped) + offset;
+        image->data.assign(bytes, bytes + size);
+        offset += size;
+      }
+      readback->unmap();
+
+      if (IblCache(cacheDirectory).store(cacheKey, baked)) {
+        spdlog::info("Stored environment IBL maps in cache ({:016x}).",
+                     cacheKey);
+      }
+    });
+  }
 
-  vkDestroyPipelineLayout(m_context->getDevice(), layout, nullptr);
+  // The GPU is done with a superseded bake and no frame ever sampled it
+  if (job->request != m_latestRequest) {
+    releaseMaps(job->maps);
+    return;
+  }
+  if (m_current.skybox) {
+    m_retired.push_back({std::move(m_current), m_frame});
+  }
+  m_current = std::move(job->maps);
+  spdlog::info("Environment {} in use ({}).", job->path,
+               source.fromCache ? "from cache" : "baked");
 }
 
 } // namespace astral
@@ -0,0 +1,241 @@
+#include "astral/renderer/geometry_pool.hpp"
+#include "astral/core/commands.hpp"
+#include "astral/core/upload_manager.hpp"
+#include "astral/renderer/descriptor_manager.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace astral {
+
+// RangeAllocator
+
+RangeAllocator::RangeAllocator(uint32_t capacity) : m_capacity(capacity) {
+    if (capacity > 0) {
+        m_freeRanges[0] = capacity;
+    }
+}
+
+uint32_t RangeAllocator::allocate(uint32_t size) {
+    if (size == 0) {
+        return 0;
+    }
+
+    for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it) {
+        if (it->second < size) {
+            continue;
+        }
+
+        uint32_t offset = it->first;
+        uint32_t remaining = it->second - size;
+        m_freeRanges.erase(it);
+        if (remaining > 0) {
+            m_freeRanges[offset + size] = remaining;
+        }
+        m_used += size;
+        return offset;
+    }
+    return INVALID_OFFSET;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size) {
+    if (size == 0) {
+        return;
+    }
+    m_used -= size;
+
+    auto next = m_freeRanges.lower_bound(offset);
+
+    // Merge with the following range
+    if (next != m_freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = m_freeRanges.erase(next);
+    }
+
+    // Merge with the preceding range
+    if (next != m_freeRanges.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+
+    m_freeRanges[offset] = size;
+}
+
+void RangeAllocator::grow(uint32_t newCapacity) {
+    if (newCapacity <= m_capacity) {
+        return;
+    }
+    uint32_t oldCapacity = m_capacity;
+    m_capacity = newCapacity;
+    m_used += newCapacity - oldCapacity; // release() subtracts it again
+    release(oldCapacity, newCapacity - oldCapacity);
+}
+
+// GeometryPool
+
+GeometryPool::GeometryPool(Context* context, uint32_t initialVertexCapacity, uint32_t initialIndexCapacity,
+                           uint32_t initialMeshletCapacity)
+    : m_context(context) {
+    const VkBufferUsageFlags commonUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                                           VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                                           VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+
+    m_vertexPools.resize(2);
+    for (uint32_t i = 0; i < m_vertexPools.size(); ++i) {
+        auto& pool = m_vertexPools[i];
+        pool.allocator = RangeAllocator(initialVertexCapacity);
+        pool.elementSize = getVertexStride(static_cast<VertexFormat>(i));
+        pool.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | commonUsage;
+    }
+
+    m_indexPool.allocator = RangeAllocator(initialIndexCapacity);
+    m_indexPool.elementSize = sizeof(uint32_t);
+    m_indexPool.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | commonUsage;
+
+    m_meshletPool.allocator = RangeAllocator(initialMeshletCapacity);
+    m_meshletPool.elementSize = sizeof(Meshlet);
+    m_meshletPool.usage = commonUsage;
+}
+
+GeometryPool::~GeometryPool() = default;
+
+uint32_t GeometryPool::getVertexStride(VertexFormat format) {
+    switch (format) {
+    case VertexFormat::Packed:
+        return sizeof(PackedVertex);
+    case VertexFormat::Standard:
+    default:
+        return sizeof(Vertex);
+    }
+}
+
+VkBuffer GeometryPool::getVertexBuffer(VertexFormat format) const {
+    const auto& pool = m_vertexPools[static_cast<uint32_t>(format)];
+    return pool.buffer ? pool.buffer->getHandle() : VK_NULL_HANDLE;
+}
+
+VkBuffer GeometryPool::getIndexBuffer() const {
+    return m_indexPool.buffer ? m_indexPool.buffer->getHandle() : VK_NULL_HANDLE;
+}
+
+void GeometryPool::createPoolBuffer(Pool& pool, uint32_t capacity) {
+    pool.buffer = std::make_unique<Buffer>(
+        m_context,
+        static_cast<VkDeviceSize>(capacity) * pool.elementSize,
+        pool.usage,
+        VMA_MEMORY_USAGE_GPU_ONLY
+    );
+}
+
+void GeometryPool::growPool(Pool& pool, uint32_t requiredCapacity) {
+    uint32_t oldCapacity = pool.allocator.getCapacity();
+    uint32_t newCapacity = std::max(oldCapacity * 2, requiredCapacity);
+
+    spdlog::info("Growing geometry pool buffer: {} -> {} elements ({} bytes each)",
+                 oldCapacity, newCapacity, pool.elementSize);
+
+    std::unique_ptr<Buffer> oldBuffer = std::move(pool.buffer);
+    createPoolBuffer(pool, newCapacity);
+
+    if (oldBuffer) {
+        // Pending uploads target the old buffer and frames in flight may still
+        // reference it
+        m_context->getUploadManager().waitIdle();
+        vkDeviceWaitIdle(m_context->getDevice());
+
+        ImmediateCommands cmd(m_context);
+        VkBufferCopy region = {};
+        region.size = static_cast<VkDeviceSize>(oldCapacity) * pool.elementSize;
+        vkCmdCopyBuffer(cmd.getBuffer(), oldBuffer->getHandle(), pool.buffer->getHandle(), 1, &region);
+    }
+    // ImmediateCommands waits for completion, so the old buffer is free to go
+
+    pool.allocator.grow(newCapacity);
+}
+
+uint32_t GeometryPool::allocateFrom(Pool& pool, uint32_t count) {
+    if (!pool.buffer) {
+        createPoolBuffer(pool, pool.allocator.getCapacity());
+    }
+
+    uint32_t offset = pool.allocator.allocate(count);
+    if (offset == RangeAllocator::INVALID_OFFSET) {
+        growPool(pool, pool.allocator.getCapacity() + count);
+        offset = pool.allocator.allocate(count);
+        if (offset == RangeAllocator::INVALID_OFFSET) {
+            throw std::runtime_error("GeometryPool allocation failed after growing!");
+        }
+    }
+    return offset;
+}
+
+GeometryAllocation GeometryPool::allocate(VertexFormat format, const void* vertexData, uint32_t vertexCount,
+                                          const uint32_t* indexData, uint32_t indexCount,
+                                          const Meshlet* meshletData, uint32_t meshletCount) {
+    auto& vertexPool = m_vertexPools[static_cast<uint32_t>(format)];
+
+    GeometryAllocation allocation;
+    allocation.vertexFormat = format;
+    allocation.vertexCount = vertexCount;
+    allocation.indexCount = indexCount;
+    allocation.vertexOffset = allocateFrom(vertexPool, vertexCount);
+    allocation.firstIndex = allocateFrom(m_indexPool, indexCount);
+    allocation.meshletCount = meshletCount;
+    allocation.firstMeshlet = allocateFrom(m_meshletPool, meshletCount);
+
+    // Growing replaces the buffer, so shaders need a fresh descriptor
+    if (m_meshletPool.buffer->getHandle() != m_registeredMeshletBuffer) {
+        auto& descriptors = m_context->getDescriptorManager();
+        if (m_registeredMeshletBuffer != VK_NULL_HANDLE) {
+            descriptors.unregisterBuffer(m_meshletBufferIndex, 13);
+        }
+        m_registeredMeshletBuffer = m_meshletPool.buffer->getHandle();
+        m_meshletBufferIndex = descriptors.registerBuffer(
+            m_registeredMeshletBuffer, 0, m_meshletPool.buffer->getSize(), 13);
+    }
+
+    VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexCount) * vertexPool.elementSize;
+    VkDeviceSize indexBytes = static_cast<VkDeviceSize>(indexCount) * sizeof(uint32_t);
+
+    // Recorded into the current upload batch; the caller decides when to submit
+    auto& uploads = m_context->getUploadManager();
+    uploads.uploadBuffer(vertexPool.buffer->getHandle(),
+                         static_cast<VkDeviceSize>(allocation.vertexOffset) * vertexPool.elementSize,
+                         vertexData, vertexBytes);
+    uploads.uploadBuffer(m_indexPool.buffer->getHandle(),
+                         static_cast<VkDeviceSize>(allocation.firstIndex) * sizeof(uint32_t),
+                         indexData, indexBytes);
+    uploads.uploadBuffer(m_meshletPool.buffer->getHandle(),
+                         static_cast<VkDeviceSize>(allocation.firstMeshlet) * sizeof(Meshlet),
+                         meshletData, static_cast<VkDeviceSize>(meshletCount) * sizeof(Meshlet));
+
+    return allocation;
+}
+
+void GeometryPool::free(const GeometryAllocation& allocation) {
+    if (!allocation.isValid()) {
+        return;
+    }
+    m_pendingFrees.push_back({allocation, MAX_FRAMES_IN_FLIGHT});
+}
+
+void GeometryPool::beginFrame() {
+    for (auto it = m_pendingFrees.begin(); it != m_pendingFrees.end();) {
+        if (--it->framesLeft > 0) {
+            ++it;
+            continue;
+        }
+
+        const auto& allocation = it->allocation;
+        m_vertexPools[static_cast<uint32_t>(allocation.vertexFormat)].allocator.release(
+            allocation.vertexOffset, allocation.vertexCount);
+        m_indexPool.allocator.release(allocation.firstIndex, allocation.indexCount);
+        m_meshletPool.allocator.release(allocation.firstMeshlet, allocation.meshletCount);
+        it = m_pendingFrees.erase(it);
+    }
+}
+
+} // namespace astral
@@ -1,26 +1,110 @@
 #include "astral/renderer/gltf_loader.hpp"
 #include "astral/core/context.hpp"
+#include "astral/core/sampler_cache.hpp"
+#include "astral/core/thread_pool.hpp"
+#include "astral/core/upload_manager.hpp"
 #include "astral/renderer/scene_manager.hpp"
 #include "astral/renderer/descriptor_manager.hpp"
+#include "astral/renderer/geometry_pool.hpp"
+#include "astral/renderer/gltf_source.hpp"
+#include "astral/renderer/mesh_attributes.hpp"
+#include "astral/renderer/mesh_cache.hpp"
+#include "astral/renderer/mesh_optimizer.hpp"
+#include "astral/renderer/texture_cache.hpp"
+#include "astral/renderer/texture_streamer.hpp"
+#include "astral/core/hash.hpp"
+#include "astral/core/asset_file.hpp"
 #include <fastgltf/core.hpp>
 #include <fastgltf/types.hpp>
+#include <fastgltf/tools.hpp>
 #include <fastgltf/glm_element_traits.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <stb_image.h>
 #include <spdlog/spdlog.h>
-#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <numeric>
 
 namespace astral {
 
+struct StbiDeleter {
+    void operator()(stbi_uc* pixels) const { stbi_image_free(pixels); }
+};
+
+using ImportClock = std::chrono::steady_clock;
+
+static double elapsedMs(ImportClock::time_point start) {
+    return std::chrono::duration<double, std::milli>(ImportClock::now() - start).count();
+}
+
+// CPU side result of importing a glTF file. Built on a worker thread without
+// touching Vulkan and handed to the main thread for upload.
+struct ImportedModel {
+    // Meshes and nodes; primitives carry glTF material indices
+    std::unique_ptr<Model> model;
+    std::vector<Vertex> vertices;
+    std::vector<PackedVertex> packedVertices; // Used instead of vertices for VertexFormat::Packed
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets;
+
+    std::vector<VkSamplerCreateInfo> samplers;
+
+    struct DecodedImage {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        MipChain mips;                       // RGBA8, empty if decoding failed or cached
+        uint64_t key = 0;                    // TextureCache content key
+        std::shared_ptr<CachedImage> cached; // Already resident; decoding was skipped
+        uint64_t fileBytes = 0;              // Size of the external image file, if any
+
+        bool isValid() const { return !mips.empty() || cached; }
+    };
+    std::vector<DecodedImage> images;
+
+    struct Texture {
+        int32_t imageIndex = -1;
+        int32_t samplerIndex = -1;
+    };
+    std::vector<Texture> textures;
+
+    // Texture slots hold glTF texture indices until resolved against the
+    // bindless indices of resident textures
+    std::vector<MaterialMetadata> materials;
+};
+
+struct GltfLoader::LoadJob {
+    std::shared_ptr<ModelLoadHandle> handle;
+    SceneManager* sceneManager = nullptr;
+    bool publish = true; // Hand the model to SceneManager::addModel once drawable
+
+    std::future<std::unique_ptr<ImportedModel>> importTask;
+    std::unique_ptr<ImportedModel> imported;
+    std::shared_ptr<Model> model;
+
+    std::vector<VkSampler> samplers;       // glTF sampler -> VkSampler
+    std::vector<uint32_t> materialIndices; // glTF material -> SceneManager material
+    std::vector<int32_t> textureIndices;   // glTF texture -> bindless index, -1 until resident
+    std::vector<std::shared_ptr<CachedImage>> images; // glTF image -> shared image, null until staged
+
+    size_t nextImage = 0;
+    uint32_t batchesInFlight = 0;
+    bool geometryResident = false;
+};
+
 GltfLoader::GltfLoader(Context* context) : m_context(context) {
     createDefaultSampler();
+    m_textureCache = std::make_unique<TextureCache>(context);
+    m_textureStreamer = std::make_unique<TextureStreamer>(context);
+    m_threadPool = std::make_unique<ThreadPool>();
 }
 
 GltfLoader::~GltfLoader() {
-    for (auto sampler : m_samplers) {
-        vkDestroySampler(m_context->getDevice(), sampler, nullptr);
-    }
-    vkDestroySampler(m_context->getDevice(), m_defaultSampler, nullptr);
+    // Finish imports still on worker threads, then retire their uploads
+    // while the jobs they report to are alive
+    m_threadPool.reset();
+    m_context->getUploadManager().waitIdle();
+    m_jobs.clear();
 }
 
 static VkFilter getVkFilter(fastgltf::Filter filter) {
@@ -58,6 +142,335 @@ static VkSamplerAddressMode getVkWrapMode(fastgltf::Wrap wrap) {
     }
 }
 
+// Content key of the asset: the glTF/GLB file (which embeds GLB and data URI
+// buffers) plus all external buffers, read through the mappings.
+static uint64_t hashAssetSource(const GltfSource& source) {
+    const AssetFile& file = source.getFile();
+    uint64_t hash = hashBytes(file.data(), file.size(), HASH_SEED);
+
+    const auto& asset = source.getAsset();
+    for (size_t i = 0; i < asset.buffers.size(); ++i) {
+        if (std::holds_alternative<fastgltf::sources::URI>(asset.buffers[i].data)) {
+            auto bytes = source.getBufferBytes(i);
+            hash = hashBytes(bytes.data(), bytes.size(), hash);
+        }
+    }
+    return hash;
+}
+
+// One imported primitive. Index, LOD and meshlet ranges are relative to the
+// primitive's own streams until importGeometry concatenates the results.
+struct ImportedPrimitive {
+    bool valid = false;
+    Primitive primitive;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices; // LOD 0 followed by the coarser levels
+    std::vector<Meshlet> meshlets;
+
+    // Stage timings for GltfImportStats
+    double attributesMs = 0.0;
+    double optimizeMs = 0.0;
+    double meshletMs = 0.0;
+    double lodMs = 0.0;
+};
+
+// Reads one primitive, generates missing attributes and runs the
+// per-primitive import optimizations. Only reads the source, so primitives
+// can be processed concurrently.
+static ImportedPrimitive importPrimitive(const GltfSource& source, const fastgltf::Primitive& gltfPrimitive,
+                                         const std::string& meshName, size_t primIdx,
+                                         const GltfLoadOptions& options) {
+    const fastgltf::Asset& asset = source.getAsset();
+    ImportedPrimitive result;
+    auto stageStart = ImportClock::now();
+    Primitive& primitive = result.primitive;
+    auto& primVertices = result.vertices;
+    auto& primIndices = result.indices;
+    const bool triangles = gltfPrimitive.type == fastgltf::PrimitiveType::Triangles;
+
+    // POSITION
+    auto posAttr = gltfPrimitive.findAttribute("POSITION");
+    if (posAttr == gltfPrimitive.attributes.end()) {
+        spdlog::warn("Skipping primitive {} of mesh '{}' without POSITION", primIdx, meshName);
+        return result;
+    }
+    // The other attributes are written per vertex, so a stream longer than
+    // POSITION would write past primVertices
+    for (const char* name : {"NORMAL", "TEXCOORD_0", "TANGENT"}) {
+        auto attr = gltfPrimitive.findAttribute(name);
+        if (attr != gltfPrimitive.attributes.end() &&
+            asset.accessors[attr->accessorIndex].count != asset.accessors[posAttr->accessorIndex].count) {
+            spdlog::warn("Skipping primitive {} of mesh '{}': {} count does not match POSITION", primIdx, meshName,
+                         name);
+            return result;
+        }
+    }
+    {
+        auto& accessor = asset.accessors[posAttr->accessorIndex];
+        primVertices.resize(accessor.count);
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(asset, accessor, [&](glm::vec3 pos, size_t idx) {
+            primVertices[idx].position = pos;
+        }, source);
+    }
+
+    // NORMAL
+    auto normAttr = gltfPrimitive.findAttribute("NORMAL");
+    const bool hasNormals = normAttr != gltfPrimitive.attributes.end();
+    if (hasNormals) {
+        auto& accessor = asset.accessors[normAttr->accessorIndex];
+        fastgltf::iterateAccessorWithIndex<glm::vec3>(asset, accessor, [&](glm::vec3 norm, size_t idx) {
+            primVertices[idx].normal = norm;
+        }, source);
+    }
+
+    // TEXCOORD_0
+    auto uvAttr = gltfPrimitive.findAttribute("TEXCOORD_0");
+    if (uvAttr != gltfPrimitive.attributes.end()) {
+        auto& accessor = asset.accessors[uvAttr->accessorIndex];
+        fastgltf::iterateAccessorWithIndex<glm::vec2>(asset, accessor, [&](glm::vec2 uv, size_t idx) {
+            primVertices[idx].uv = uv;
+        }, source);
+    }
+
+    // TANGENT
+    auto tangAttr = gltfPrimitive.findAttribute("TANGENT");
+    const bool hasTangents = tangAttr != gltfPrimitive.attributes.end();
+    if (hasTangents) {
+        auto& accessor = asset.accessors[tangAttr->accessorIndex];
+        fastgltf::iterateAccessorWithIndex<glm::vec4>(asset, accessor, [&](glm::vec4 tang, size_t idx) {
+            primVertices[idx].tangent = tang;
+        }, source);
+    }
+
+    // Index verilerini oku (indekssiz primitive'ler için sıralı indeks üret)
+    if (gltfPrimitive.indicesAccessor.has_value()) {
+        auto& accessor = asset.accessors[gltfPrimitive.indicesAccessor.value()];
+        primIndices.reserve(accessor.count);
+        fastgltf::iterateAccessor<uint32_t>(asset, accessor, [&](uint32_t index) {
+            primIndices.push_back(index);
+        }, source);
+    } else {
+        primIndices.resize(primVertices.size());
+        std::iota(primIndices.begin(), primIndices.end(), 0u);
+    }
+
+    // Attribute generation and the optimizers index primVertices through
+    // these, including streams decoded by EXT_meshopt_compression
+    const size_t vertexCount = primVertices.size();
+    if (std::any_of(primIndices.begin(), primIndices.end(), [vertexCount](uint32_t index) {
+            return index >= vertexCount;
+        })) {
+        spdlog::warn("Skipping primitive {} of mesh '{}': index out of range of {} vertices", primIdx, meshName,
+                     vertexCount);
+        return result;
+    }
+    if (triangles && primIndices.size() % 3 != 0) {
+        spdlog::warn("Skipping primitive {} of mesh '{}': {} indices do not form whole triangles", primIdx,
+                     meshName, primIndices.size());
+        return result;
+    }
+
+    // Eksik attribute'ları üret: normal yoksa glTF flat normal ister,
+    // tangent yoksa normal map'ler için MikkTSpace uyumlu tangent üretilir
+    if (triangles && !hasNormals) {
+        generateFlatNormals(primVertices, primIndices);
+    }
+    if (triangles && !hasTangents) {
+        generateTangents(primVertices, primIndices);
+    }
+    result.attributesMs = elapsedMs(stageStart);
+
+    stageStart = ImportClock::now();
+    if (options.optimizeMeshes && triangles) {
+        float acmrBefore = computeACMR(primIndices, primVertices.size());
+        optimizeVertexCache(primIndices, primVertices.size());
+        optimizeOverdraw(primIndices, primVertices);
+        optimizeVertexFetch(primVertices, primIndices);
+        spdlog::debug("Optimized primitive {} of mesh '{}': ACMR {:.3f} -> {:.3f}", primIdx, meshName,
+                      acmrBefore, computeACMR(primIndices, primVertices.size()));
+    }
+
+    glm::vec3 minPos(std::numeric_limits<float>::max());
+    glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+    for (const auto& vertex : primVertices) {
+        minPos = glm::min(minPos, vertex.position);
+        maxPos = glm::max(maxPos, vertex.position);
+    }
+
+    primitive.firstIndex = 0;
+    primitive.indexCount = static_cast<uint32_t>(primIndices.size());
+    primitive.firstVertex = 0;
+    primitive.vertexCount = static_cast<uint32_t>(primVertices.size());
+    computeBoundingSphere(primVertices, primitive.boundingCenter, primitive.boundingRadius);
+    primitive.quantOffset = minPos;
+    primitive.quantScale = maxPos - minPos;
+    primitive.materialIndex = gltfPrimitive.materialIndex.has_value() ?
+        static_cast<int32_t>(gltfPrimitive.materialIndex.value()) : -1;
+
+    result.optimizeMs = elapsedMs(stageStart);
+
+    stageStart = ImportClock::now();
+    if (options.buildMeshlets && triangles) {
+        result.meshlets = buildMeshlets(primIndices, primVertices);
+        primitive.firstMeshlet = 0;
+        primitive.meshletCount = static_cast<uint32_t>(result.meshlets.size());
+    }
+    result.meshletMs = elapsedMs(stageStart);
+
+    // LOD zinciri: her seviye bir öncekinin yarısını hedefler ve aynı
+    // vertex'leri kullanır; indeksler LOD 0'ın hemen arkasına eklenir
+    stageStart = ImportClock::now();
+    primitive.lods[0] = {primitive.firstIndex, primitive.indexCount, 0.0f};
+    primitive.lodCount = 1;
+    const uint32_t maxLods = std::min(options.lodCount, MAX_PRIMITIVE_LODS);
+    if (triangles && maxLods > 1) {
+        const float errorLimit = options.lodTargetError * primitive.boundingRadius;
+        std::vector<uint32_t> lodIndices(primIndices.begin(), primIndices.end());
+        while (primitive.lodCount < maxLods) {
+            float lodError = 0.0f;
+            size_t targetIndexCount = lodIndices.size() / 6 * 3;
+            std::vector<uint32_t> simplified = simplifyMesh(lodIndices, primVertices, targetIndexCount,
+                                                            errorLimit, &lodError);
+            // A level that removes less than a quarter of the triangles is not worth a range
+            if (simplified.empty() || simplified.size() * 4 > lodIndices.size() * 3) {
+                break;
+            }
+            if (options.optimizeMeshes) {
+                optimizeVertexCache(simplified, primVertices.size());
+            }
+
+            PrimitiveLod& lod = primitive.lods[primitive.lodCount];
+            lod.firstIndex = static_cast<uint32_t>(primIndices.size());
+            lod.indexCount = static_cast<uint32_t>(simplified.size());
+            // Each level is simplified from the previous one, so errors add up
+            lod.error = primitive.lods[primitive.lodCount - 1].error + lodError;
+            primitive.lodCount++;
+
+            primIndices.insert(primIndices.end(), simplified.begin(), simplified.end());
+            lodIndices.swap(simplified);
+        }
+        spdlog::debug("Primitive {} of mesh '{}': {} LODs, coarsest {} of {} triangles", primIdx, meshName,
+                      primitive.lodCount, primitive.lods[primitive.lodCount - 1].indexCount / 3,
+                      primitive.indexCount / 3);
+    }
+    result.lodMs = elapsedMs(stageStart);
+
+    result.valid = true;
+    return result;
+}
+
+// Reads all mesh primitives into one vertex/index stream. Primitives are
+// imported in parallel on the pool (the calling thread helps), then
+// concatenated in file order so the result does not depend on scheduling.
+// Primitive::materialIndex is left as the glTF material index.
+static MeshCacheData importGeometry(const GltfSource& source, const GltfLoadOptions& options, ThreadPool* pool,
+                                    GltfImportStats* stats) {
+    const fastgltf::Asset& asset = source.getAsset();
+
+    struct PrimitiveRef {
+        size_t meshIdx;
+        size_t primIdx;
+    };
+    std::vector<PrimitiveRef> refs;
+    for (size_t meshIdx = 0; meshIdx < asset.meshes.size(); ++meshIdx) {
+        for (size_t primIdx = 0; primIdx < asset.meshes[meshIdx].primitives.size(); ++primIdx) {
+            refs.push_back({meshIdx, primIdx});
+        }
+    }
+
+    std::vector<ImportedPrimitive> imported(refs.size());
+    auto importRef = [&](size_t i) {
+        const auto& gltfMesh = asset.meshes[refs[i].meshIdx];
+        imported[i] = importPrimitive(source, gltfMesh.primitives[refs[i].primIdx], gltfMesh.name.c_str(),
+                                      refs[i].primIdx, options);
+    };
+    if (pool) {
+        pool->parallelFor(refs.size(), importRef);
+    } else {
+        for (size_t i = 0; i < refs.size(); ++i) {
+            importRef(i);
+        }
+    }
+
+    MeshCacheData geometry;
+    auto& vertices = geometry.vertices;
+    auto& indices = geometry.indices;
+
+    size_t next = 0;
+    for (size_t meshIdx = 0; meshIdx < asset.meshes.size(); ++meshIdx) {
+        Mesh mesh;
+        mesh.name = asset.meshes[meshIdx].name.c_str();
+
+        for (; next < refs.size() && refs[next].meshIdx == meshIdx; ++next) {
+            ImportedPrimitive& part = imported[next];
+            if (stats) {
+                stats->attributesMs += part.attributesMs;
+                stats->optimizeMs += part.optimizeMs;
+                stats->meshletMs += part.meshletMs;
+                stats->lodMs += part.lodMs;
+            }
+            if (!part.valid) {
+                continue;
+            }
+
+            Primitive primitive = part.primitive;
+            const uint32_t indexBase = static_cast<uint32_t>(indices.size());
+            primitive.firstIndex += indexBase;
+            primitive.firstVertex = static_cast<uint32_t>(vertices.size());
+            primitive.firstMeshlet = static_cast<uint32_t>(geometry.meshlets.size());
+            for (uint32_t lod = 0; lod < primitive.lodCount; ++lod) {
+                primitive.lods[lod].firstIndex += indexBase;
+            }
+
+            indices.reserve(indices.size() + part.indices.size());
+            for (uint32_t index : part.indices) {
+                indices.push_back(primitive.firstVertex + index);
+            }
+            vertices.insert(vertices.end(), part.vertices.begin(), part.vertices.end());
+            geometry.meshlets.insert(geometry.meshlets.end(), part.meshlets.begin(), part.meshlets.end());
+
+            // Release the per-primitive copy as soon as it is merged
+            part = ImportedPrimitive();
+            mesh.primitives.push_back(primitive);
+        }
+        geometry.meshes.push_back(std::move(mesh));
+    }
+
+    return geometry;
+}
+
+// Recursively imports a glTF node and its children. Nodes reference meshes
+// by index, so a mesh used by many nodes is stored (and uploaded) once.
+static void loadNode(const fastgltf::Asset& asset, size_t nodeIndex, Model::Node* parent, Model& model,
+                     std::vector<bool>& visited) {
+    if (visited[nodeIndex]) {
+        spdlog::warn("glTF node {} is referenced more than once, skipping", nodeIndex);
+        return;
+    }
+    visited[nodeIndex] = true;
+
+    const auto& gltfNode = asset.nodes[nodeIndex];
+    auto node = std::make_unique<Model::Node>();
+    node->parent = parent;
+    node->name = gltfNode.name.c_str();
+    node->meshIndex = gltfNode.meshIndex.has_value() ? static_cast<int32_t>(gltfNode.meshIndex.value()) : -1;
+
+    auto matrix = fastgltf::getTransformMatrix(gltfNode);
+    node->matrix = glm::make_mat4(matrix.data());
+
+    Model::Node* nodePtr = node.get();
+    model.linearNodes.push_back(nodePtr);
+    if (parent) {
+        parent->children.push_back(std::move(node));
+    } else {
+        model.nodes.push_back(std::move(node));
+    }
+
+    for (size_t childIndex : gltfNode.children) {
+        loadNode(asset, childIndex, nodePtr, model, visited);
+    }
+}
+
 void GltfLoader::createDefaultSampler() {
     VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
     samplerInfo.magFilter = VK_FILTER_LINEAR;
@@ -76,37 +489,140 @@ void GltfLoader::createDefaultSampler() {
     samplerInfo.minLod = 0.0f;
     samplerInfo.maxLod = 0.0f;
 
-    if (vkCreateSampler(m_context->getDevice(), &samplerInfo, nullptr, &m_defaultSampler) != VK_SUCCESS) {
-        throw std::runtime_error("Failed to create default sampler!");
+    m_defaultSampler = m_context->getSamplerCache().getSampler(samplerInfo);
+}
+
+
+// Every glTF image is uploaded as RGBA8 sRGB
+constexpr VkFormat GLTF_IMAGE_FORMAT = VK_FORMAT_R8G8B8A8_SRGB;
+
+// Hashes the encoded bytes and decodes them, with the full mip chain for
+// streaming, unless the texture cache already holds an image with the same
+// content
+static void decodeImageBytes(const void* data, size_t size, const TextureCache* textureCache,
+                             ImportedModel::DecodedImage& decoded) {
+    decoded.key = TextureCache::computeKey(data, size, GLTF_IMAGE_FORMAT);
+    if (textureCache && (decoded.cached = textureCache->find(decoded.key))) {
+        return;
+    }
+
+    int width = 0, height = 0, channels = 0;
+    std::unique_ptr<stbi_uc, StbiDeleter> pixels(stbi_load_from_memory(
+        reinterpret_cast<const stbi_uc*>(data), static_cast<int>(size), &width, &height, &channels, STBI_rgb_alpha));
+    if (pixels) {
+        decoded.width = static_cast<uint32_t>(width);
+        decoded.height = static_cast<uint32_t>(height);
+        decoded.mips = generateMipChain(pixels.get(), decoded.width, decoded.height,
+                                        GLTF_IMAGE_FORMAT == VK_FORMAT_R8G8B8A8_SRGB);
     }
 }
 
-std::unique_ptr<Model> GltfLoader::loadFromFile(const std::filesystem::path& path, SceneManager* sceneManager) {
-    if (!std::filesystem::exists(path)) {
+static ImportedModel::DecodedImage decodeImage(const GltfSource& source, size_t imageIndex,
+                                               const std::filesystem::path& basePath,
+                                               const TextureCache* textureCache) {
+    const fastgltf::Asset& asset = source.getAsset();
+    ImportedModel::DecodedImage decoded;
+
+    std::visit(fastgltf::visitor {
+        [&](const fastgltf::sources::URI& uri) {
+            if (uri.fileByteOffset != 0) {
+                spdlog::warn("URI with offset not supported yet: image index {}", imageIndex);
+                return;
+            }
+
+            std::filesystem::path imagePath;
+            if (uri.uri.scheme() == "file") {
+                imagePath = uri.uri.fspath();
+            } else if (uri.uri.scheme().empty()) {
+                imagePath = basePath / uri.uri.fspath();
+            } else {
+                spdlog::warn("Unsupported URI scheme: {} for image index {}", uri.uri.scheme(), imageIndex);
+                return;
+            }
+
+            try {
+                AssetFile file(imagePath);
+                decoded.fileBytes = file.size();
+                decodeImageBytes(file.data(), file.size(), textureCache, decoded);
+            } catch (const std::exception& e) {
+                spdlog::warn("Failed to read image {}: {}", imagePath.string(), e.what());
+                return;
+            }
+            if (decoded.cached) {
+                spdlog::info("Image already resident: {}", imagePath.string());
+            } else if (!decoded.mips.empty()) {
+                spdlog::info("Decoded image: {} ({}x{})", imagePath.string(), decoded.width, decoded.height);
+            }
+        },
+        [&](const fastgltf::sources::BufferView& view) {
+            auto bytes = source.getBufferViewBytes(view.bufferViewIndex);
+            if (bytes.size() == 0) {
+                return;
+            }
+            decodeImageBytes(bytes.data(), bytes.size(), textureCache, decoded);
+            if (decoded.cached) {
+                spdlog::info("Image from BufferView already resident");
+            } else if (!decoded.mips.empty()) {
+                spdlog::info("Decoded image from BufferView ({}x{})", decoded.width, decoded.height);
+            }
+        },
+        [&](const auto&) {}
+    }, asset.images[imageIndex].data);
+
+    return decoded;
+}
+
+// Parses the file and does all CPU work: image decoding, geometry import and
+// vertex packing. Safe to run on a worker thread; primitives are processed
+// in parallel on the pool when one is given. Images already in the texture
+// cache are referenced instead of decoded. Stage timings go to stats, if given.
+static std::unique_ptr<ImportedModel> importModel(const std::filesystem::path& path, const GltfLoadOptions& options,
+                                                  ThreadPool* pool, const TextureCache* textureCache,
+                                                  GltfImportStats* stats = nullptr) {
+    const auto importStart = ImportClock::now();
+    if (!AssetFile::exists(path)) {
         spdlog::error("glTF file not found: {}", path.string());
         return nullptr;
     }
 
-    static constexpr auto options = fastgltf::Options::DontRequireValidAssetMember |
-                                    fastgltf::Options::LoadExternalBuffers;
+    // Buffers are mapped by GltfSource, so LoadExternalBuffers is not set
+    static constexpr auto gltfOptions = fastgltf::Options::DontRequireValidAssetMember;
 
-    fastgltf::Parser parser;
-    auto data = fastgltf::GltfDataBuffer::FromPath(path);
-    if (data.error() != fastgltf::Error::None) {
-        spdlog::error("Failed to load glTF data buffer: {}", static_cast<uint64_t>(data.error()));
+    std::unique_ptr<GltfSource> source;
+    try {
+        source = std::make_unique<GltfSource>(path);
+    } catch (const std::exception& e) {
+        spdlog::error("Failed to map glTF file: {}", e.what());
         return nullptr;
     }
 
-    auto expectedAsset = parser.loadGltf(data.get(), path.parent_path(), options);
-    if (expectedAsset.error() != fastgltf::Error::None) {
-        spdlog::error("Failed to parse glTF: {}", static_cast<uint64_t>(expectedAsset.error()));
+    // Quantized attributes are converted by the accessor tools; compressed
+    // buffer views are decoded by GltfSource
+    fastgltf::Parser parser(fastgltf::Extensions::KHR_mesh_quantization |
+                            fastgltf::Extensions::EXT_meshopt_compression);
+    auto error = source->parse(parser, gltfOptions);
+    if (error != fastgltf::Error::None) {
+        spdlog::error("Failed to parse glTF: {}", static_cast<uint64_t>(error));
         return nullptr;
     }
 
-    fastgltf::Asset& asset = expectedAsset.get();
-    auto model = std::make_unique<Model>();
-    
-    // 1. Sampler'ları Yükle
+    const fastgltf::Asset& asset = source->getAsset();
+    if (stats) {
+        stats->parseMs = elapsedMs(importStart);
+        stats->sourceBytes = source->getFile().size();
+        for (size_t i = 0; i < asset.buffers.size(); ++i) {
+            if (std::holds_alternative<fastgltf::sources::URI>(asset.buffers[i].data)) {
+                stats->sourceBytes += source->getBufferBytes(i).size();
+            }
+        }
+    }
+
+    auto imported = std::make_unique<ImportedModel>();
+    imported->model = std::make_unique<Model>();
+    Model& model = *imported->model;
+    model.vertexFormat = options.vertexFormat;
+
+    // 1. Sampler tanımları (VkSampler'lar ana thread'de SamplerCache'ten alınır)
     for (auto& gltfSampler : asset.samplers) {
         VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
         samplerInfo.magFilter = gltfSampler.magFilter.has_value() ? getVkFilter(gltfSampler.magFilter.value()) : VK_FILTER_LINEAR;
@@ -118,252 +634,449 @@ std::unique_ptr<Model> GltfLoader::loadFromFile(const std::filesystem::path& pat
         samplerInfo.anisotropyEnable = VK_TRUE;
         samplerInfo.maxAnisotropy = 16.0f;
         samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
-
-        VkSampler sampler;
-        if (vkCreateSampler(m_context->getDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
-            spdlog::error("Failed to create glTF sampler!");
-            continue;
-        }
-        m_samplers.push_back(sampler);
+        imported->samplers.push_back(samplerInfo);
     }
 
-    // 2. Image'ları Yükle (Ham veriler)
-    std::vector<std::unique_ptr<Image>> loadedImages;
-    loadedImages.reserve(asset.images.size());
+    // 2. Image'ları çöz (ham RGBA8 veriler)
+    auto stageStart = ImportClock::now();
+    imported->images.reserve(asset.images.size());
     for (size_t i = 0; i < asset.images.size(); ++i) {
-        auto& gltfImage = asset.images[i];
-        std::unique_ptr<Image> image;
-        
-        std::visit(fastgltf::visitor {
-            [&](fastgltf::sources::URI& uri) {
-                if (uri.fileByteOffset != 0) {
-                    spdlog::warn("URI with offset not supported yet: image index {}", i);
-                    return;
-                }
-                
-                std::filesystem::path imagePath;
-                if (uri.uri.scheme() == "file") {
-                    imagePath = uri.uri.fspath();
-                } else if (uri.uri.scheme().empty()) {
-                    imagePath = path.parent_path() / uri.uri.fspath();
-                } else {
-                    spdlog::warn("Unsupported URI scheme: {} for image index {}", uri.uri.scheme(), i);
-                    return;
-                }
-                
-                int width, height, channels;
-                stbi_uc* pixels = stbi_load(imagePath.string().c_str(), &width, &height, &channels, STBI_rgb_alpha);
-                
-                if (pixels) {
-                    ImageSpecs specs;
-                    specs.width = static_cast<uint32_t>(width);
-                    specs.height = static_cast<uint32_t>(height);
-                    specs.format = VK_FORMAT_R8G8B8A8_SRGB; 
-                    specs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-                    
-                    image = std::make_unique<Image>(m_context, specs);
-                    image->upload(pixels, specs.width * specs.height * 4);
-                    stbi_image_free(pixels);
-                    spdlog::info("Loaded image: {} ({}x{})", imagePath.string(), width, height);
-                }
-            },
-            [&](fastgltf::sources::BufferView& view) {
-                auto& bufferView = asset.bufferViews[view.bufferViewIndex];
-                auto& buffer = asset.buffers[bufferView.bufferIndex];
-                
-                std::visit(fastgltf::visitor {
-                    [&](fastgltf::sources::Array& array) {
-                        int width, height, channels;
-                        stbi_uc* pixels = stbi_load_from_memory(
-                            reinterpret_cast<const stbi_uc*>(array.bytes.data() + bufferView.byteOffset),
-                            static_cast<int>(bufferView.byteLength),
-                            &width, &height, &channels, STBI_rgb_alpha
-                        );
-                        
-                        if (pixels) {
-                            ImageSpecs specs;
-                            specs.width = static_cast<uint32_t>(width);
-                            specs.height = static_cast<uint32_t>(height);
-                            specs.format = VK_FORMAT_R8G8B8A8_SRGB;
-                            specs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-                            
-                            image = std::make_unique<Image>(m_context, specs);
-                            image->upload(pixels, specs.width * specs.height * 4);
-                            stbi_image_free(pixels);
-                            spdlog::info("Loaded image from BufferView ({}x{})", width, height);
-                        }
-                    },
-                    [&](auto&) {}
-                }, buffer.data);
-            },
-            [&](auto&) {}
-        }, gltfImage.data);
-        
-        loadedImages.push_back(std::move(image));
-    }
-
-    // 3. Texture'ları Yükle (Image + Sampler kombinasyonları)
-    model->textureIndices.reserve(asset.textures.size());
-    for (size_t i = 0; i < asset.textures.size(); ++i) {
-        auto& gltfTex = asset.textures[i];
-        if (!gltfTex.imageIndex.has_value()) {
-            model->textureIndices.push_back(0); // Default fallback
-            continue;
-        }
-
-        uint32_t imgIdx = static_cast<uint32_t>(gltfTex.imageIndex.value());
-        VkSampler sampler = gltfTex.samplerIndex.has_value() ? 
-            m_samplers[gltfTex.samplerIndex.value()] : m_defaultSampler;
-
-        if (imgIdx < loadedImages.size() && loadedImages[imgIdx]) {
-            uint32_t texIdx = m_context->getDescriptorManager().registerImage(loadedImages[imgIdx]->getView(), sampler);
-            model->textureIndices.push_back(texIdx);
-            spdlog::debug("Registered texture {} using image {}", i, imgIdx);
-        } else {
-            spdlog::warn("Texture {} references missing or moved image {}", i, imgIdx);
-            model->textureIndices.push_back(0);
+        imported->images.push_back(decodeImage(*source, i, path.parent_path(), textureCache));
+    }
+    if (stats) {
+        stats->imageDecodeMs = elapsedMs(stageStart);
+        for (const auto& image : imported->images) {
+            stats->sourceBytes += image.fileBytes;
+            stats->imageCount += image.mips.empty() ? 0 : 1;
         }
     }
 
-    // Move images to model at the very end
-    for (auto& img : loadedImages) {
-        if (img) {
-            model->images.push_back(std::move(img));
-        }
+    // 3. Texture'lar (Image + Sampler kombinasyonları)
+    for (auto& gltfTex : asset.textures) {
+        ImportedModel::Texture texture;
+        texture.imageIndex = gltfTex.imageIndex.has_value() ? static_cast<int32_t>(gltfTex.imageIndex.value()) : -1;
+        texture.samplerIndex = gltfTex.samplerIndex.has_value() ? static_cast<int32_t>(gltfTex.samplerIndex.value()) : -1;
+        imported->textures.push_back(texture);
     }
 
-    // 4. Materyal Yükleme
-    std::vector<uint32_t> materialIndices;
+    // 4. Materyaller (texture slotlarında glTF texture indeksleri)
     for (auto& gltfMat : asset.materials) {
-        MaterialMetadata mat;
+        MaterialMetadata mat{};
         mat.baseColorFactor = glm::make_vec4(gltfMat.pbrData.baseColorFactor.data());
         mat.metallicFactor = gltfMat.pbrData.metallicFactor;
         mat.roughnessFactor = gltfMat.pbrData.roughnessFactor;
-        
-        mat.baseColorTextureIndex = gltfMat.pbrData.baseColorTexture.has_value() ? 
-            model->textureIndices[gltfMat.pbrData.baseColorTexture->textureIndex] : -1;
-            
-        mat.metallicRoughnessTextureIndex = gltfMat.pbrData.metallicRoughnessTexture.has_value() ? 
-            model->textureIndices[gltfMat.pbrData.metallicRoughnessTexture->textureIndex] : -1;
-            
-        mat.normalTextureIndex = gltfMat.normalTexture.has_value() ? 
-            model->textureIndices[gltfMat.normalTexture->textureIndex] : -1;
-            
-        mat.emissiveTextureIndex = gltfMat.emissiveTexture.has_value() ? 
-            model->textureIndices[gltfMat.emissiveTexture->textureIndex] : -1;
-            
-        mat.occlusionTextureIndex = gltfMat.occlusionTexture.has_value() ? 
-            model->textureIndices[gltfMat.occlusionTexture->textureIndex] : -1;
-
-        materialIndices.push_back(sceneManager->addMaterial(mat));
-    }
 
-    // Default material if none exist
-    if (materialIndices.empty()) {
-        MaterialMetadata defaultMat;
-        materialIndices.push_back(sceneManager->addMaterial(defaultMat));
+        mat.baseColorTextureIndex = gltfMat.pbrData.baseColorTexture.has_value() ?
+            static_cast<int>(gltfMat.pbrData.baseColorTexture->textureIndex) : -1;
+
+        mat.metallicRoughnessTextureIndex = gltfMat.pbrData.metallicRoughnessTexture.has_value() ?
+            static_cast<int>(gltfMat.pbrData.metallicRoughnessTexture->textureIndex) : -1;
+
+        mat.normalTextureIndex = gltfMat.normalTexture.has_value() ?
+            static_cast<int>(gltfMat.normalTexture->textureIndex) : -1;
+
+        mat.emissiveTextureIndex = gltfMat.emissiveTexture.has_value() ?
+            static_cast<int>(gltfMat.emissiveTexture->textureIndex) : -1;
+
+        mat.occlusionTextureIndex = gltfMat.occlusionTexture.has_value() ?
+            static_cast<int>(gltfMat.occlusionTexture->textureIndex) : -1;
+
+        imported->materials.push_back(mat);
     }
 
-    // 3. Geometri Yükleme
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
+    // 5. Geometri (optimize edilmiş geometri önbellekten gelebilir)
+    stageStart = ImportClock::now(); // Cache key hashing counts as cache time
+    MeshCacheData geometry;
+    std::unique_ptr<MeshCache> meshCache;
+    uint64_t cacheKey = 0;
+    if (!options.meshCacheDirectory.empty()) {
+        meshCache = std::make_unique<MeshCache>(options.meshCacheDirectory);
+        cacheKey = hashCombine(hashAssetSource(*source), options.optimizeMeshes ? 1 : 0);
+        cacheKey = hashCombine(cacheKey, options.lodCount);
+        cacheKey = hashCombine(cacheKey, static_cast<uint64_t>(options.lodTargetError * 1000000.0f));
+        cacheKey = hashCombine(cacheKey, options.buildMeshlets ? 1 : 0);
+    }
 
-    for (size_t meshIdx = 0; meshIdx < asset.meshes.size(); ++meshIdx) {
-        auto& gltfMesh = asset.meshes[meshIdx];
-        Mesh mesh;
-        mesh.name = gltfMesh.name.c_str();
-
-        for (size_t primIdx = 0; primIdx < gltfMesh.primitives.size(); ++primIdx) {
-            auto& gltfPrimitive = gltfMesh.primitives[primIdx];
-            Primitive primitive;
-            primitive.firstIndex = static_cast<uint32_t>(indices.size());
-            uint32_t vertexStart = static_cast<uint32_t>(vertices.size());
-
-            // Index verilerini oku
-            if (gltfPrimitive.indicesAccessor.has_value()) {
-                auto& accessor = asset.accessors[gltfPrimitive.indicesAccessor.value()];
-                indices.reserve(indices.size() + accessor.count);
-                
-                fastgltf::iterateAccessor<uint32_t>(asset, accessor, [&](uint32_t index) {
-                    indices.push_back(vertexStart + index);
-                });
-                primitive.indexCount = static_cast<uint32_t>(accessor.count);
+    if (meshCache && meshCache->load(cacheKey, geometry)) {
+        spdlog::info("Loaded geometry from mesh cache: {}", path.filename().string());
+        if (stats) {
+            stats->cacheHit = true;
+            stats->cacheMs += elapsedMs(stageStart);
+        }
+    } else {
+        if (stats) {
+            stats->cacheMs += elapsedMs(stageStart); // Key and failed lookup
+        }
+        stageStart = ImportClock::now();
+        geometry = importGeometry(*source, options, pool, stats);
+        if (stats) {
+            stats->geometryMs = elapsedMs(stageStart);
+        }
+        if (meshCache) {
+            stageStart = ImportClock::now();
+            meshCache->store(cacheKey, geometry);
+            if (stats) {
+                stats->cacheMs += elapsedMs(stageStart);
             }
+        }
+    }
 
-            // POSITION
-            auto posAttr = gltfPrimitive.findAttribute("POSITION");
-            if (posAttr != gltfPrimitive.attributes.end()) {
-                auto& accessor = asset.accessors[posAttr->accessorIndex];
-                vertices.resize(vertexStart + accessor.count);
-                
-                glm::vec3 minPos(std::numeric_limits<float>::max());
-                glm::vec3 maxPos(std::numeric_limits<float>::lowest());
-
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(asset, accessor, [&](glm::vec3 pos, size_t idx) {
-                    vertices[vertexStart + idx].position = pos;
-                    minPos = glm::min(minPos, pos);
-                    maxPos = glm::max(maxPos, pos);
-                });
-
-                primitive.boundingCenter = (minPos + maxPos) * 0.5f;
-                primitive.boundingRadius = glm::distance(maxPos, primitive.boundingCenter);
+    if (stats) {
+        for (const auto& mesh : geometry.meshes) {
+            stats->primitiveCount += static_cast<uint32_t>(mesh.primitives.size());
+        }
+        stats->vertexCount = static_cast<uint32_t>(geometry.vertices.size());
+        stats->indexCount = static_cast<uint32_t>(geometry.indices.size());
+        stats->meshletCount = static_cast<uint32_t>(geometry.meshlets.size());
+    }
+
+    stageStart = ImportClock::now();
+    model.meshes = std::move(geometry.meshes);
+    imported->indices = std::move(geometry.indices);
+    imported->meshlets = std::move(geometry.meshlets);
+
+    if (model.vertexFormat == VertexFormat::Packed) {
+        const std::vector<Vertex>& vertices = geometry.vertices;
+        imported->packedVertices.resize(vertices.size());
+        for (const auto& mesh : model.meshes) {
+            for (const auto& primitive : mesh.primitives) {
+                for (uint32_t v = 0; v < primitive.vertexCount; ++v) {
+                    uint32_t idx = primitive.firstVertex + v;
+                    imported->packedVertices[idx] = PackedVertex::pack(vertices[idx], primitive.quantOffset,
+                                                                       primitive.quantScale);
+                }
             }
+        }
+    } else {
+        imported->vertices = std::move(geometry.vertices);
+    }
 
-            // NORMAL
-            auto normAttr = gltfPrimitive.findAttribute("NORMAL");
-            if (normAttr != gltfPrimitive.attributes.end()) {
-                auto& accessor = asset.accessors[normAttr->accessorIndex];
-                fastgltf::iterateAccessorWithIndex<glm::vec3>(asset, accessor, [&](glm::vec3 norm, size_t idx) {
-                    vertices[vertexStart + idx].normal = norm;
-                });
+    // 6. Node hiyerarşisi (varsayılan sahne)
+    if (!asset.scenes.empty()) {
+        size_t sceneIndex = asset.defaultScene.value_or(0);
+        std::vector<bool> visited(asset.nodes.size(), false);
+        for (size_t rootIndex : asset.scenes[sceneIndex].nodeIndices) {
+            loadNode(asset, rootIndex, nullptr, model, visited);
+        }
+    } else {
+        // No scene: draw every mesh once at the origin
+        for (size_t meshIdx = 0; meshIdx < model.meshes.size(); ++meshIdx) {
+            auto node = std::make_unique<Model::Node>();
+            node->meshIndex = static_cast<int32_t>(meshIdx);
+            node->name = model.meshes[meshIdx].name;
+            model.linearNodes.push_back(node.get());
+            model.nodes.push_back(std::move(node));
+        }
+    }
+    model.updateWorldMatrices();
+
+    if (stats) {
+        stats->packMs = elapsedMs(stageStart);
+        stats->totalMs = elapsedMs(importStart);
+    }
+    return imported;
+}
+
+bool importGltfHeadless(const std::filesystem::path& path, const GltfLoadOptions& options, ThreadPool* pool,
+                        GltfImportStats* stats) {
+    if (stats) {
+        *stats = {};
+    }
+    try {
+        return importModel(path, options, pool, nullptr, stats) != nullptr;
+    } catch (const std::exception& e) {
+        spdlog::error("glTF import failed for {}: {}", path.string(), e.what());
+        return false;
+    }
+}
+
+std::shared_ptr<Model> GltfLoader::loadFromFile(const std::filesystem::path& path, SceneManager* sceneManager,
+                                                const GltfLoadOptions& options) {
+    auto job = std::make_unique<LoadJob>();
+    job->handle = std::make_shared<ModelLoadHandle>();
+    job->handle->path = path;
+    job->sceneManager = sceneManager;
+    job->publish = false;
+
+    job->imported = importModel(path, options, m_threadPool.get(), m_textureCache.get());
+    if (!job->imported) {
+        return nullptr;
+    }
+
+    beginUpload(*job);
+    uploadImages(*job, std::numeric_limits<VkDeviceSize>::max());
+    m_context->getUploadManager().waitIdle();
+    finishJob(*job);
+    return job->model;
+}
+
+std::shared_ptr<ModelLoadHandle> GltfLoader::loadAsync(const std::filesystem::path& path, SceneManager* sceneManager,
+                                                       const GltfLoadOptions& options) {
+    auto job = std::make_unique<LoadJob>();
+    job->handle = std::make_shared<ModelLoadHandle>();
+    job->handle->path = path;
+    job->sceneManager = sceneManager;
+    ThreadPool* pool = m_threadPool.get();
+    const TextureCache* textureCache = m_textureCache.get();
+    job->importTask = m_threadPool->submit([path, options, pool, textureCache]() {
+        return importModel(path, options, pool, textureCache);
+    });
+
+    auto handle = job->handle;
+    m_jobs.push_back(std::move(job));
+    return handle;
+}
+
+void GltfLoader::update() {
+    m_context->getUploadManager().poll();
+
+    VkDeviceSize budget = m_uploadBudget;
+    for (auto& jobPtr : m_jobs) {
+        LoadJob& job = *jobPtr;
+        ModelLoadHandle& handle = *job.handle;
+
+        if (handle.state == ModelLoadState::Loading) {
+            if (job.importTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                continue;
+            }
+            try {
+                job.imported = job.importTask.get();
+            } catch (const std::exception& e) {
+                spdlog::error("glTF import failed for {}: {}", handle.path.string(), e.what());
             }
+            if (!job.imported) {
+                handle.state = ModelLoadState::Failed;
+                continue;
+            }
+            beginUpload(job);
+        }
 
-            // TEXCOORD_0
-            auto uvAttr = gltfPrimitive.findAttribute("TEXCOORD_0");
-            if (uvAttr != gltfPrimitive.attributes.end()) {
-                auto& accessor = asset.accessors[uvAttr->accessorIndex];
-                fastgltf::iterateAccessorWithIndex<glm::vec2>(asset, accessor, [&](glm::vec2 uv, size_t idx) {
-                    vertices[vertexStart + idx].uv = uv;
-                });
+        if (handle.state == ModelLoadState::Uploading) {
+            if (budget > 0 && job.nextImage < job.imported->images.size()) {
+                budget -= std::min(budget, uploadImages(job, budget));
             }
+            if (job.geometryResident && job.batchesInFlight == 0 && job.nextImage == job.imported->images.size()) {
+                finishJob(job);
+            }
+        }
+    }
+
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(), [](const std::unique_ptr<LoadJob>& job) {
+        return job->handle->isDone() && job->batchesInFlight == 0;
+    }), m_jobs.end());
+}
+
+// Creates samplers and materials and records the geometry upload. Materials
+// start untextured and are refreshed as their textures become resident.
+void GltfLoader::beginUpload(LoadJob& job) {
+    ImportedModel& imported = *job.imported;
+    job.model = std::shared_ptr<Model>(std::move(imported.model));
+    Model& model = *job.model;
+
+    // Identical glTF samplers (within and across models) share one VkSampler
+    for (const auto& samplerInfo : imported.samplers) {
+        try {
+            job.samplers.push_back(m_context->getSamplerCache().getSampler(samplerInfo));
+        } catch (const std::exception& e) {
+            spdlog::error("Failed to create glTF sampler: {}", e.what());
+            job.samplers.push_back(m_defaultSampler);
+        }
+    }
+
+    job.textureIndices.assign(imported.textures.size(), -1);
+    job.images.assign(imported.images.size(), nullptr);
+
+    for (size_t i = 0; i < imported.materials.size(); ++i) {
+        job.materialIndices.push_back(job.sceneManager->addMaterial(MaterialMetadata{}));
+    }
+    // Default material if none exist
+    if (job.materialIndices.empty()) {
+        MaterialMetadata defaultMat{};
+        defaultMat.baseColorFactor = glm::vec4(1.0f);
+        defaultMat.metallicFactor = 1.0f;
+        defaultMat.roughnessFactor = 1.0f;
+        defaultMat.baseColorTextureIndex = -1;
+        defaultMat.metallicRoughnessTextureIndex = -1;
+        defaultMat.normalTextureIndex = -1;
+        defaultMat.occlusionTextureIndex = -1;
+        defaultMat.emissiveTextureIndex = -1;
+        job.materialIndices.push_back(job.sceneManager->addMaterial(defaultMat));
+    }
+    refreshMaterials(job);
+
+    // Imported primitives carry glTF material indices; map them to SceneManager materials
+    for (auto& mesh : model.meshes) {
+        for (auto& primitive : mesh.primitives) {
+            bool valid = primitive.materialIndex >= 0 &&
+                         static_cast<size_t>(primitive.materialIndex) < imported.materials.size();
+            primitive.materialIndex = static_cast<int32_t>(
+                valid ? job.materialIndices[primitive.materialIndex] : job.materialIndices[0]);
+        }
+    }
+
+    // GPU Buffer'larını yarat (ortak geometri havuzuna)
+    GeometryPool& geometryPool = job.sceneManager->getGeometryPool();
+    const uint32_t meshletCount = static_cast<uint32_t>(imported.meshlets.size());
+    if (model.vertexFormat == VertexFormat::Packed) {
+        model.geometry = geometryPool.allocate(VertexFormat::Packed, imported.packedVertices.data(),
+                                               static_cast<uint32_t>(imported.packedVertices.size()),
+                                               imported.indices.data(), static_cast<uint32_t>(imported.indices.size()),
+                                               imported.meshlets.data(), meshletCount);
+    } else {
+        model.geometry = geometryPool.allocate(VertexFormat::Standard, imported.vertices.data(),
+                                               static_cast<uint32_t>(imported.vertices.size()),
+                                               imported.indices.data(), static_cast<uint32_t>(imported.indices.size()),
+                                               imported.meshlets.data(), meshletCount);
+    }
+    model.geometryPool = &geometryPool;
+
+    // Staging holds its own copy
+    imported.vertices = {};
+    imported.packedVertices = {};
+    imported.indices = {};
+    imported.meshlets = {};
+
+    job.batchesInFlight++;
+    m_context->getUploadManager().submit([&job]() {
+        job.batchesInFlight--;
+        job.geometryResident = true;
+        if (job.publish) {
+            job.sceneManager->addModel(job.model);
+            job.handle->model = job.model;
+            spdlog::info("Model geometry resident, now drawing: {}", job.handle->path.string());
+        }
+    });
+
+    for (const auto& image : imported.images) {
+        if (image.isValid()) {
+            job.handle->texturesPending++;
+        }
+    }
+    job.handle->state = ModelLoadState::Uploading;
+}
+
+// Stages the mip tails of decoded images until the byte budget is used up
+// (always at least one) and submits them as one batch. Images already in the texture cache
+// are shared instead of uploaded. Returns the bytes staged.
+VkDeviceSize GltfLoader::uploadImages(LoadJob& job, VkDeviceSize budget) {
+    auto& decodedImages = job.imported->images;
+    auto& uploads = m_context->getUploadManager();
 
-            // TANGENT
-            auto tangAttr = gltfPrimitive.findAttribute("TANGENT");
-            if (tangAttr != gltfPrimitive.attributes.end()) {
-                auto& accessor = asset.accessors[tangAttr->accessorIndex];
-                fastgltf::iterateAccessorWithIndex<glm::vec4>(asset, accessor, [&](glm::vec4 tang, size_t idx) {
-                    vertices[vertexStart + idx].tangent = tang;
-                });
+    size_t firstImage = job.nextImage;
+    uint32_t imageCount = 0;
+    VkDeviceSize staged = 0;
+    for (; job.nextImage < decodedImages.size(); ++job.nextImage) {
+        auto& decoded = decodedImages[job.nextImage];
+        if (!decoded.isValid()) {
+            continue;
+        }
+
+        // Resident when decoded, or uploaded by an earlier image since then
+        std::shared_ptr<CachedImage> cached = decoded.cached ? decoded.cached : m_textureCache->find(decoded.key);
+        if (cached) {
+            decoded.mips = {};
+            decoded.cached.reset();
+            job.images[job.nextImage] = cached;
+            job.model->images.push_back(std::move(cached));
+            imageCount++;
+            continue;
+        }
+
+        if (staged > 0 && staged >= budget) {
+            break;
+        }
+
+        ImageSpecs specs;
+        specs.width = decoded.width;
+        specs.height = decoded.height;
+        specs.format = GLTF_IMAGE_FORMAT;
+        specs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+        specs.mipLevels = static_cast<uint32_t>(decoded.mips.levels.size());
+
+        // Only the mip tail is staged here; finer levels stream in later
+        auto entry = m_textureCache->insert(decoded.key, std::make_unique<Image>(m_context, specs));
+        staged += m_textureStreamer->add(entry, std::move(decoded.mips));
+        decoded.mips = {};
+
+        job.images[job.nextImage] = entry;
+        job.model->images.push_back(std::move(entry));
+        imageCount++;
+    }
+
+    if (imageCount == 0) {
+        return 0;
+    }
+
+    size_t lastImage = job.nextImage;
+    job.batchesInFlight++;
+    uploads.submit([this, &job, firstImage, lastImage, imageCount]() {
+        job.batchesInFlight--;
+        const auto& textures = job.imported->textures;
+        for (size_t t = 0; t < textures.size(); ++t) {
+            int32_t imgIdx = textures[t].imageIndex;
+            if (imgIdx < static_cast<int32_t>(firstImage) || imgIdx >= static_cast<int32_t>(lastImage) ||
+                !job.images[imgIdx]) {
+                continue;
             }
 
-            primitive.materialIndex = gltfPrimitive.materialIndex.has_value() ? 
-                materialIndices[gltfPrimitive.materialIndex.value()] : materialIndices[0];
-                
-            mesh.primitives.push_back(primitive);
+            job.textureIndices[t] = static_cast<int32_t>(
+                m_textureCache->getBindlessIndex(*job.images[imgIdx], getTextureSampler(job, t)));
+            spdlog::debug("Registered texture {} using image {}", t, imgIdx);
         }
-        model->meshes.push_back(mesh);
-    }
-
-    // GPU Buffer'larını yarat
-    model->vertexBuffer = std::make_unique<Buffer>(
-        m_context,
-        vertices.size() * sizeof(Vertex),
-        VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU
-    );
-    model->vertexBuffer->upload(vertices.data(), vertices.size() * sizeof(Vertex));
-
-    model->indexBuffer = std::make_unique<Buffer>(
-        m_context,
-        indices.size() * sizeof(uint32_t),
-        VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-        VMA_MEMORY_USAGE_CPU_TO_GPU
-    );
-    model->indexBuffer->upload(indices.data(), indices.size() * sizeof(uint32_t));
-
-    spdlog::info("glTF model loaded: {} meshes, {} materials, {} textures", 
-                 model->meshes.size(), materialIndices.size(), model->images.size());
-    return model;
+        job.handle->texturesPending -= imageCount;
+        refreshMaterials(job);
+    });
+    return staged;
+}
+
+VkSampler GltfLoader::getTextureSampler(const LoadJob& job, size_t texture) const {
+    int32_t samplerIdx = job.imported->textures[texture].samplerIndex;
+    return samplerIdx >= 0 && static_cast<size_t>(samplerIdx) < job.samplers.size() ?
+        job.samplers[samplerIdx] : m_defaultSampler;
+}
+
+void GltfLoader::resolveTextureIndices(LoadJob& job) {
+    // The texture streamer moves images to new bindless slots as finer mips
+    // become resident, so indices recorded at registration can be stale
+    const auto& textures = job.imported->textures;
+    for (size_t t = 0; t < textures.size(); ++t) {
+        if (job.textureIndices[t] >= 0) {
+            job.textureIndices[t] = static_cast<int32_t>(
+                m_textureCache->getBindlessIndex(*job.images[textures[t].imageIndex], getTextureSampler(job, t)));
+        }
+    }
+}
+
+void GltfLoader::refreshMaterials(LoadJob& job) {
+    resolveTextureIndices(job);
+    auto resolve = [&job](int slot) {
+        return slot >= 0 && static_cast<size_t>(slot) < job.textureIndices.size() ? job.textureIndices[slot] : -1;
+    };
+
+    const auto& materials = job.imported->materials;
+    for (size_t i = 0; i < materials.size(); ++i) {
+        MaterialMetadata mat = materials[i];
+        mat.baseColorTextureIndex = resolve(mat.baseColorTextureIndex);
+        mat.metallicRoughnessTextureIndex = resolve(mat.metallicRoughnessTextureIndex);
+        mat.normalTextureIndex = resolve(mat.normalTextureIndex);
+        mat.occlusionTextureIndex = resolve(mat.occlusionTextureIndex);
+        mat.emissiveTextureIndex = resolve(mat.emissiveTextureIndex);
+        job.sceneManager->updateMaterial(job.materialIndices[i], mat);
+    }
+}
+
+void GltfLoader::finishJob(LoadJob& job) {
+    Model& model = *job.model;
+    resolveTextureIndices(job);
+    model.textureIndices.clear();
+    for (int32_t index : job.textureIndices) {
+        model.textureIndices.push_back(index >= 0 ? static_cast<uint32_t>(index) : 0);
+    }
+
+    job.handle->state = ModelLoadState::Ready;
+    spdlog::info("glTF model loaded: {} meshes, {} nodes, {} materials, {} textures",
+                 model.meshes.size(), model.linearNodes.size(), job.materialIndices.size(), model.images.size());
+    job.imported.reset();
 }
 
 } // namespace astral
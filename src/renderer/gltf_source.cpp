@@ -0,0 +1,246 @@
+#include "astral/renderer/gltf_source.hpp"
+#include "astral/renderer/meshopt_decoder.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace astral {
+
+namespace {
+
+constexpr uint32_t GLB_MAGIC = 0x46546C67;      // "glTF"
+constexpr uint32_t GLB_CHUNK_BINARY = 0x004E4942; // "BIN\0"
+constexpr size_t GLB_HEADER_SIZE = 12;
+constexpr size_t GLB_CHUNK_HEADER_SIZE = 8;
+
+uint32_t readU32(const std::byte* data) {
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+// Feeds fastgltf from the mapping. Only reads that need simdjson padding (the
+// JSON) are copied.
+class GltfSource::DataGetter : public fastgltf::GltfDataGetter {
+public:
+    explicit DataGetter(const AssetFile& file) : m_file(file) {}
+
+    void read(void* ptr, std::size_t count) override {
+        count = std::min(count, m_file.size() - m_offset);
+        const std::byte* src = m_file.data() + m_offset;
+        // The GLB binary chunk is "read" into its own mapping (see mapBuffer)
+        if (ptr != src) {
+            std::memcpy(ptr, src, count);
+        }
+        m_offset += count;
+    }
+
+    fastgltf::span<std::byte> read(std::size_t count, std::size_t padding) override {
+        count = std::min(count, m_file.size() - m_offset);
+        m_padded.assign(count + padding, std::byte{0});
+        std::memcpy(m_padded.data(), m_file.data() + m_offset, count);
+        m_offset += count;
+        return fastgltf::span<std::byte>(m_padded.data(), count);
+    }
+
+    void reset() override { m_offset = 0; }
+    std::size_t bytesRead() override { return m_offset; }
+    std::size_t totalSize() override { return m_file.size(); }
+
+private:
+    const AssetFile& m_file;
+    size_t m_offset = 0;
+    std::vector<std::byte> m_padded;
+};
+
+GltfSource::GltfSource(const std::filesystem::path& path)
+    : m_path(path), m_file(std::make_unique<AssetFile>(path)) {}
+
+GltfSource::~GltfSource() = default;
+
+fastgltf::BufferInfo GltfSource::mapBuffer(std::uint64_t bufferSize, void* userPointer) {
+    auto* source = static_cast<GltfSource*>(userPointer);
+
+    // The GLB binary chunk maps onto the file itself; DataGetter::read then
+    // sees source == destination and skips the copy
+    if (source->m_glbBinaryLength != 0 && !source->m_glbBinaryClaimed &&
+        bufferSize == source->m_glbBinaryLength) {
+        source->m_glbBinaryClaimed = true;
+        return {const_cast<std::byte*>(source->m_file->data() + source->m_glbBinaryOffset), GLB_BUFFER_ID};
+    }
+
+    // Everything else (decoded data URIs) lives on the heap
+    source->m_heapBuffers.push_back(std::make_unique<std::byte[]>(bufferSize));
+    source->m_heapBufferSizes.push_back(static_cast<size_t>(bufferSize));
+    return {source->m_heapBuffers.back().get(), source->m_heapBuffers.size()};
+}
+
+fastgltf::Error GltfSource::parse(fastgltf::Parser& parser, fastgltf::Options options) {
+    const std::byte* data = m_file->data();
+    size_t size = m_file->size();
+
+    if (size >= GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE && readU32(data) == GLB_MAGIC) {
+        size_t jsonLength = readU32(data + GLB_HEADER_SIZE);
+        size_t binaryHeader = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE + jsonLength;
+        if (binaryHeader + GLB_CHUNK_HEADER_SIZE <= size &&
+            readU32(data + binaryHeader + 4) == GLB_CHUNK_BINARY) {
+            m_glbBinaryOffset = binaryHeader + GLB_CHUNK_HEADER_SIZE;
+            m_glbBinaryLength = std::min<size_t>(readU32(data + binaryHeader), size - m_glbBinaryOffset);
+        }
+    }
+    m_file->advise(MappedFile::Access::Sequential);
+
+    DataGetter getter(*m_file);
+    parser.setUserPointer(this);
+    parser.setBufferAllocationCallback(&GltfSource::mapBuffer);
+    auto expectedAsset = parser.loadGltf(getter, m_path.parent_path(), options);
+    parser.setBufferAllocationCallback(nullptr);
+    parser.setUserPointer(nullptr);
+
+    if (expectedAsset.error() != fastgltf::Error::None) {
+        return expectedAsset.error();
+    }
+    m_asset = std::move(expectedAsset.get());
+
+    // External buffers stay URIs; map them instead of loading them
+    m_bufferFiles.resize(m_asset.buffers.size());
+    for (size_t i = 0; i < m_asset.buffers.size(); ++i) {
+        const auto* uri = std::get_if<fastgltf::sources::URI>(&m_asset.buffers[i].data);
+        if (!uri) {
+            continue;
+        }
+
+        std::filesystem::path bufferPath;
+        if (uri->uri.scheme() == "file") {
+            bufferPath = uri->uri.fspath();
+        } else if (uri->uri.scheme().empty()) {
+            bufferPath = m_path.parent_path() / uri->uri.fspath();
+        } else {
+            spdlog::warn("Unsupported URI scheme: {} for buffer index {}", uri->uri.scheme(), i);
+            continue;
+        }
+
+        try {
+            m_bufferFiles[i] = std::make_unique<AssetFile>(bufferPath);
+            m_bufferFiles[i]->advise(MappedFile::Access::Sequential);
+        } catch (const std::exception& e) {
+            spdlog::error("{}", e.what());
+            return fastgltf::Error::MissingExternalBuffer;
+        }
+    }
+
+    if (!decodeCompressedViews()) {
+        return fastgltf::Error::InvalidGltf;
+    }
+    return fastgltf::Error::None;
+}
+
+bool GltfSource::decodeCompressedViews() {
+    m_decodedViews.resize(m_asset.bufferViews.size());
+    for (size_t i = 0; i < m_asset.bufferViews.size(); ++i) {
+        const auto& compression = m_asset.bufferViews[i].meshoptCompression;
+        if (!compression) {
+            continue;
+        }
+
+        auto source = getBufferBytes(compression->bufferIndex);
+        if (compression->byteOffset + compression->byteLength > source.size()) {
+            spdlog::error("Compressed buffer view {} lies outside its buffer", i);
+            return false;
+        }
+        const auto* encoded = reinterpret_cast<const uint8_t*>(source.data() + compression->byteOffset);
+        size_t encodedSize = compression->byteLength;
+        size_t count = compression->count;
+        size_t stride = compression->byteStride;
+
+        auto& decoded = m_decodedViews[i];
+        decoded.resize(count * stride);
+
+        bool ok = false;
+        switch (compression->mode) {
+        case fastgltf::MeshoptCompressionMode::Attributes:
+            ok = decodeMeshoptVertexBuffer(decoded.data(), count, stride, encoded, encodedSize);
+            break;
+        case fastgltf::MeshoptCompressionMode::Triangles:
+            ok = decodeMeshoptIndexBuffer(decoded.data(), count, stride, encoded, encodedSize);
+            break;
+        case fastgltf::MeshoptCompressionMode::Indices:
+            ok = decodeMeshoptIndexSequence(decoded.data(), count, stride, encoded, encodedSize);
+            break;
+        default:
+            break;
+        }
+        if (!ok) {
+            spdlog::error("Failed to decode EXT_meshopt_compression buffer view {}", i);
+            return false;
+        }
+
+        switch (compression->filter) {
+        case fastgltf::MeshoptCompressionFilter::Octahedral:
+            decodeMeshoptFilterOctahedral(decoded.data(), count, stride);
+            break;
+        case fastgltf::MeshoptCompressionFilter::Quaternion:
+            decodeMeshoptFilterQuaternion(decoded.data(), count, stride);
+            break;
+        case fastgltf::MeshoptCompressionFilter::Exponential:
+            decodeMeshoptFilterExponential(decoded.data(), count, stride);
+            break;
+        default:
+            break;
+        }
+    }
+    return true;
+}
+
+fastgltf::span<const std::byte> GltfSource::getBufferBytes(size_t bufferIndex) const {
+    const auto& buffer = m_asset.buffers[bufferIndex];
+    return std::visit(fastgltf::visitor {
+        [](const fastgltf::sources::Array& array) {
+            return fastgltf::span<const std::byte>(array.bytes.data(), array.bytes.size());
+        },
+        [](const fastgltf::sources::Vector& vector) {
+            return fastgltf::span<const std::byte>(vector.bytes.data(), vector.bytes.size());
+        },
+        [](const fastgltf::sources::ByteView& view) {
+            return fastgltf::span<const std::byte>(view.bytes.data(), view.bytes.size());
+        },
+        [&](const fastgltf::sources::CustomBuffer& custom) {
+            if (custom.id == GLB_BUFFER_ID && m_glbBinaryClaimed) {
+                return fastgltf::span<const std::byte>(m_file->data() + m_glbBinaryOffset, m_glbBinaryLength);
+            }
+            size_t heapIndex = static_cast<size_t>(custom.id) - 1;
+            return fastgltf::span<const std::byte>(m_heapBuffers[heapIndex].get(), m_heapBufferSizes[heapIndex]);
+        },
+        [&](const fastgltf::sources::URI& uri) {
+            const AssetFile* file = m_bufferFiles[bufferIndex].get();
+            if (!file || uri.fileByteOffset >= file->size()) {
+                return fastgltf::span<const std::byte>();
+            }
+            size_t length = std::min<size_t>(buffer.byteLength, file->size() - uri.fileByteOffset);
+            return fastgltf::span<const std::byte>(file->data() + uri.fileByteOffset, length);
+        },
+        [](const auto&) {
+            return fastgltf::span<const std::byte>();
+        }
+    }, buffer.data);
+}
+
+fastgltf::span<const std::byte> GltfSource::getBufferViewBytes(size_t bufferViewIndex) const {
+    if (bufferViewIndex < m_decodedViews.size() && !m_decodedViews[bufferViewIndex].empty()) {
+        const auto& decoded = m_decodedViews[bufferViewIndex];
+        return fastgltf::span<const std::byte>(decoded.data(), decoded.size());
+    }
+
+    const auto& bufferView = m_asset.bufferViews[bufferViewIndex];
+    auto bytes = getBufferBytes(bufferView.bufferIndex);
+    if (bufferView.byteOffset + bufferView.byteLength > bytes.size()) {
+        spdlog::warn("Buffer view {} lies outside its buffer", bufferViewIndex);
+        return {};
+    }
+    return fastgltf::span<const std::byte>(bytes.data() + bufferView.byteOffset, bufferView.byteLength);
+}
+
+} // namespace astral
@@ -0,0 +1,159 @@
+#include "astral/renderer/ibl_cache.hpp"
+#include <spdlog/spdlog.h>
+#include <fstream>
+
+namespace astral {
+
+namespace {
+
+constexpr uint32_t IBL_CACHE_MAGIC = 0x4C424941; // "AIBL"
+constexpr uint32_t IBL_CACHE_VERSION = 2;
+constexpr uint32_t IBL_CACHE_IMAGE_COUNT = 3;
+
+struct IblCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t imageCount;
+    uint32_t padding;
+};
+
+struct IblImageHeader {
+    uint32_t format; // VkFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t layers;
+    uint32_t mipLevels;
+    uint32_t padding;
+    uint64_t size; // Bytes of pixel data that follow
+};
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(file);
+}
+
+// remaining is the number of bytes left in the file. Sizes are checked
+// against it, so a corrupt header cannot cause a huge allocation.
+bool readImage(std::ifstream& file, uint64_t& remaining, IblCacheImage& image) {
+    IblImageHeader header{};
+    if (remaining < sizeof(header) || !readValue(file, header)) {
+        return false;
+    }
+    remaining -= sizeof(header);
+    if (header.size > remaining) {
+        return false;
+    }
+    remaining -= header.size;
+    image.format = static_cast<VkFormat>(header.format);
+    image.width = header.width;
+    image.height = header.height;
+    image.layers = header.layers;
+    image.mipLevels = header.mipLevels;
+    image.data.resize(header.size);
+    file.read(reinterpret_cast<char*>(image.data.data()), static_cast<std::streamsize>(header.size));
+    return static_cast<bool>(file);
+}
+
+void writeImage(std::ofstream& file, const IblCacheImage& image) {
+    IblImageHeader header{};
+    header.format = static_cast<uint32_t>(image.format);
+    header.width = image.width;
+    header.height = image.height;
+    header.layers = image.layers;
+    header.mipLevels = image.mipLevels;
+    header.size = image.data.size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(image.data.data()), static_cast<std::streamsize>(image.data.size()));
+}
+
+} // namespace
+
+IblCache::IblCache(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+std::filesystem::path IblCache::entryPath(uint64_t key) const {
+    return m_directory / fmt::format("{:016x}.aibl", key);
+}
+
+bool IblCache::load(uint64_t key, IblCacheData& data) const {
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::error_code ec;
+    uint64_t remaining = std::filesystem::file_size(entryPath(key), ec);
+    if (ec || remaining < sizeof(IblCacheHeader)) {
+        spdlog::warn("Truncated IBL cache entry: {}", entryPath(key).string());
+        return false;
+    }
+    remaining -= sizeof(IblCacheHeader);
+
+    IblCacheHeader header{};
+    if (!readValue(file, header) || header.magic != IBL_CACHE_MAGIC || header.version != IBL_CACHE_VERSION ||
+        header.key != key || header.imageCount != IBL_CACHE_IMAGE_COUNT) {
+        spdlog::warn("Ignoring stale IBL cache entry: {}", entryPath(key).string());
+        return false;
+    }
+
+    IblCacheData result;
+    for (IblCacheImage* image : {&result.skybox, &result.prefiltered, &result.brdfLut}) {
+        if (!readImage(file, remaining, *image)) {
+            spdlog::warn("Truncated IBL cache entry: {}", entryPath(key).string());
+            return false;
+        }
+    }
+    if (!readValue(file, result.irradianceSH)) {
+        spdlog::warn("Truncated IBL cache entry: {}", entryPath(key).string());
+        return false;
+    }
+
+    data = std::move(result);
+    return true;
+}
+
+bool IblCache::store(uint64_t key, const IblCacheData& data) const {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    // Write to a temporary file first so a crash never leaves a torn entry
+    auto path = entryPath(key);
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            spdlog::warn("Failed to write IBL cache entry: {}", path.string());
+            return false;
+        }
+
+        IblCacheHeader header{};
+        header.magic = IBL_CACHE_MAGIC;
+        header.version = IBL_CACHE_VERSION;
+        header.key = key;
+        header.imageCount = IBL_CACHE_IMAGE_COUNT;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const IblCacheImage* image : {&data.skybox, &data.prefiltered, &data.brdfLut}) {
+            writeImage(file, *image);
+        }
+        // The SH coefficients follow the images
+        file.write(reinterpret_cast<const char*>(data.irradianceSH.data()), sizeof(data.irradianceSH));
+
+        if (!file) {
+            spdlog::warn("Failed to write IBL cache entry: {}", path.string());
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        spdlog::warn("Failed to finalize IBL cache entry {}: {}", path.string(), ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace astral
@@ -0,0 +1,217 @@
+#include "astral/renderer/mesh_attributes.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace astral {
+
+namespace {
+
+// Some unit vector perpendicular to n
+glm::vec3 anyPerpendicular(const glm::vec3& n) {
+    glm::vec3 axis = std::fabs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    return glm::normalize(glm::cross(n, axis));
+}
+
+float cornerAngle(const glm::vec3& p, const glm::vec3& a, const glm::vec3& b) {
+    glm::vec3 ea = a - p;
+    glm::vec3 eb = b - p;
+    float la = glm::length(ea);
+    float lb = glm::length(eb);
+    if (la <= 0.0f || lb <= 0.0f) {
+        return 0.0f;
+    }
+    return std::acos(std::clamp(glm::dot(ea, eb) / (la * lb), -1.0f, 1.0f));
+}
+
+} // namespace
+
+void generateFlatNormals(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<Vertex> result;
+    result.reserve(triangleCount * 3);
+
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const Vertex& v0 = vertices[indices[t * 3 + 0]];
+        const Vertex& v1 = vertices[indices[t * 3 + 1]];
+        const Vertex& v2 = vertices[indices[t * 3 + 2]];
+
+        glm::vec3 n = glm::cross(v1.position - v0.position, v2.position - v0.position);
+        float length = glm::length(n);
+        // Degenerate triangles produce no fragments; any unit normal will do
+        n = length > 0.0f ? n / length : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        for (const Vertex* source : {&v0, &v1, &v2}) {
+            result.push_back(*source);
+            result.back().normal = n;
+        }
+    }
+
+    vertices.swap(result);
+    indices.resize(triangleCount * 3);
+    std::iota(indices.begin(), indices.end(), 0u);
+}
+
+void generateTangents(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    const size_t triangleCount = indices.size() / 3;
+
+    // Face tangents from the UV gradients. The sign is the handedness of the
+    // UV mapping: bitangent = sign * cross(normal, tangent).
+    std::vector<glm::vec3> faceTangents(triangleCount, glm::vec3(0.0f));
+    std::vector<float> faceSigns(triangleCount, 0.0f); // 0 = no usable UVs
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const Vertex& v0 = vertices[indices[t * 3 + 0]];
+        const Vertex& v1 = vertices[indices[t * 3 + 1]];
+        const Vertex& v2 = vertices[indices[t * 3 + 2]];
+
+        glm::vec3 e1 = v1.position - v0.position;
+        glm::vec3 e2 = v2.position - v0.position;
+        glm::vec2 d1 = v1.uv - v0.uv;
+        glm::vec2 d2 = v2.uv - v0.uv;
+        float det = d1.x * d2.y - d2.x * d1.y;
+        if (std::fabs(det) <= std::numeric_limits<float>::min()) {
+            continue;
+        }
+
+        glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) / det;
+        glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) / det;
+        glm::vec3 faceNormal = glm::cross(e1, e2);
+        if (glm::length(tangent) <= 0.0f || glm::length(faceNormal) <= 0.0f) {
+            continue;
+        }
+        faceTangents[t] = tangent;
+        faceSigns[t] = glm::dot(glm::cross(faceNormal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+    }
+
+    // Split vertices used with both handednesses; the negative side gets a copy
+    const size_t originalCount = vertices.size();
+    std::vector<uint8_t> signMask(originalCount, 0);
+    for (size_t c = 0; c < triangleCount * 3; ++c) {
+        float sign = faceSigns[c / 3];
+        if (sign != 0.0f) {
+            signMask[indices[c]] |= sign > 0.0f ? 1 : 2;
+        }
+    }
+
+    constexpr uint32_t noCopy = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> negativeCopies(originalCount, noCopy);
+    for (size_t v = 0; v < originalCount; ++v) {
+        if (signMask[v] == 3) {
+            negativeCopies[v] = static_cast<uint32_t>(vertices.size());
+            vertices.push_back(vertices[v]);
+        }
+    }
+    for (size_t c = 0; c < triangleCount * 3; ++c) {
+        if (faceSigns[c / 3] < 0.0f && negativeCopies[indices[c]] != noCopy) {
+            indices[c] = negativeCopies[indices[c]];
+        }
+    }
+
+    // Accumulate face tangents projected into each vertex's normal plane,
+    // weighted by the corner angle
+    std::vector<glm::vec3> tangentSums(vertices.size(), glm::vec3(0.0f));
+    std::vector<float> signs(vertices.size(), 1.0f);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (faceSigns[t] == 0.0f) {
+            continue;
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            const uint32_t v = indices[t * 3 + k];
+            const glm::vec3& p = vertices[v].position;
+            const glm::vec3& a = vertices[indices[t * 3 + (k + 1) % 3]].position;
+            const glm::vec3& b = vertices[indices[t * 3 + (k + 2) % 3]].position;
+
+            glm::vec3 n = vertices[v].normal;
+            glm::vec3 projected = faceTangents[t] - n * glm::dot(n, faceTangents[t]);
+            float length = glm::length(projected);
+            if (length > 0.0f) {
+                tangentSums[v] += projected / length * cornerAngle(p, a, b);
+            }
+            signs[v] = faceSigns[t];
+        }
+    }
+
+    for (size_t v = 0; v < vertices.size(); ++v) {
+        glm::vec3 n = vertices[v].normal;
+        float normalLength = glm::length(n);
+        n = normalLength > 0.0f ? n / normalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        glm::vec3 t = tangentSums[v] - n * glm::dot(n, tangentSums[v]);
+        float length = glm::length(t);
+        t = length > 1e-6f ? t / length : anyPerpendicular(n);
+        vertices[v].tangent = glm::vec4(t, signs[v]);
+    }
+}
+
+void computeBoundingSphere(const std::vector<Vertex>& vertices, glm::vec3& center, float& radius) {
+    center = glm::vec3(0.0f);
+    radius = 0.0f;
+    if (vertices.empty()) {
+        return;
+    }
+
+    // Box centered sphere
+    glm::vec3 minPos(std::numeric_limits<float>::max());
+    glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+    size_t minIndex[3] = {};
+    size_t maxIndex[3] = {};
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const glm::vec3& p = vertices[i].position;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (p[axis] < minPos[axis]) {
+                minPos[axis] = p[axis];
+                minIndex[axis] = i;
+            }
+            if (p[axis] > maxPos[axis]) {
+                maxPos[axis] = p[axis];
+                maxIndex[axis] = i;
+            }
+        }
+    }
+
+    glm::vec3 boxCenter = (minPos + maxPos) * 0.5f;
+    float boxRadius = 0.0f;
+    for (const auto& vertex : vertices) {
+        boxRadius = std::max(boxRadius, glm::distance(boxCenter, vertex.position));
+    }
+
+    // Ritter: start from the most distant pair of axis extremes and grow
+    // the sphere to include every outside point
+    int seedAxis = 0;
+    float seedDistance = -1.0f;
+    for (int axis = 0; axis < 3; ++axis) {
+        float d = glm::distance(vertices[minIndex[axis]].position, vertices[maxIndex[axis]].position);
+        if (d > seedDistance) {
+            seedDistance = d;
+            seedAxis = axis;
+        }
+    }
+
+    glm::vec3 ritterCenter =
+        (vertices[minIndex[seedAxis]].position + vertices[maxIndex[seedAxis]].position) * 0.5f;
+    float ritterRadius = seedDistance * 0.5f;
+    for (const auto& vertex : vertices) {
+        float d = glm::distance(ritterCenter, vertex.position);
+        if (d > ritterRadius) {
+            float grownRadius = (ritterRadius + d) * 0.5f;
+            ritterCenter += (vertex.position - ritterCenter) * ((grownRadius - ritterRadius) / d);
+            ritterRadius = grownRadius;
+        }
+    }
+    // Re-measure so that float rounding while growing never leaves a point outside
+    ritterRadius = 0.0f;
+    for (const auto& vertex : vertices) {
+        ritterRadius = std::max(ritterRadius, glm::distance(ritterCenter, vertex.position));
+    }
+
+    if (ritterRadius < boxRadius) {
+        center = ritterCenter;
+        radius = ritterRadius;
+    } else {
+        center = boxCenter;
+        radius = boxRadius;
+    }
+}
+
+} // namespace astral
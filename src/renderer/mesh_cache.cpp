@@ -0,0 +1,150 @@
+#include "astral/renderer/mesh_cache.hpp"
+#include <spdlog/spdlog.h>
+#include <fstream>
+#include <type_traits>
+
+namespace astral {
+
+namespace {
+
+constexpr uint32_t MESH_CACHE_MAGIC = 0x48534D41; // "AMSH"
+constexpr uint32_t MESH_CACHE_VERSION = 4;
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t vertexStride;    // sizeof(Vertex), rejects entries after layout changes
+    uint32_t primitiveStride; // sizeof(Primitive)
+    uint32_t meshCount;
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t meshletCount;
+};
+
+static_assert(std::is_trivially_copyable_v<Vertex>, "Vertex is written to the mesh cache as raw bytes");
+static_assert(std::is_trivially_copyable_v<Primitive>, "Primitive is written to the mesh cache as raw bytes");
+static_assert(std::is_trivially_copyable_v<Meshlet>, "Meshlet is written to the mesh cache as raw bytes");
+
+template <typename T>
+bool readValue(std::ifstream& file, T& value) {
+    file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    return static_cast<bool>(file);
+}
+
+template <typename T>
+bool readArray(std::ifstream& file, std::vector<T>& values, size_t count) {
+    values.resize(count);
+    file.read(reinterpret_cast<char*>(values.data()), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+MeshCache::MeshCache(std::filesystem::path directory) : m_directory(std::move(directory)) {}
+
+std::filesystem::path MeshCache::entryPath(uint64_t key) const {
+    return m_directory / fmt::format("{:016x}.amesh", key);
+}
+
+bool MeshCache::load(uint64_t key, MeshCacheData& data) const {
+    std::ifstream file(entryPath(key), std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    MeshCacheHeader header{};
+    if (!readValue(file, header) || header.magic != MESH_CACHE_MAGIC ||
+        header.version != MESH_CACHE_VERSION || header.key != key ||
+        header.vertexStride != sizeof(Vertex) || header.primitiveStride != sizeof(Primitive)) {
+        spdlog::warn("Ignoring stale mesh cache entry: {}", entryPath(key).string());
+        return false;
+    }
+
+    MeshCacheData result;
+    result.meshes.resize(header.meshCount);
+    for (auto& mesh : result.meshes) {
+        uint32_t nameLength = 0;
+        uint32_t primitiveCount = 0;
+        if (!readValue(file, nameLength)) {
+            return false;
+        }
+        mesh.name.resize(nameLength);
+        file.read(mesh.name.data(), nameLength);
+        if (!readValue(file, primitiveCount) || !readArray(file, mesh.primitives, primitiveCount)) {
+            return false;
+        }
+    }
+
+    if (!readArray(file, result.vertices, header.vertexCount) ||
+        !readArray(file, result.indices, header.indexCount) ||
+        !readArray(file, result.meshlets, header.meshletCount)) {
+        spdlog::warn("Truncated mesh cache entry: {}", entryPath(key).string());
+        return false;
+    }
+
+    data = std::move(result);
+    return true;
+}
+
+bool MeshCache::store(uint64_t key, const MeshCacheData& data) const {
+    std::error_code ec;
+    std::filesystem::create_directories(m_directory, ec);
+
+    // Write to a temporary file first so a crash never leaves a torn entry
+    auto path = entryPath(key);
+    auto tempPath = path;
+    tempPath += ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            spdlog::warn("Failed to write mesh cache entry: {}", path.string());
+            return false;
+        }
+
+        MeshCacheHeader header{};
+        header.magic = MESH_CACHE_MAGIC;
+        header.version = MESH_CACHE_VERSION;
+        header.key = key;
+        header.vertexStride = sizeof(Vertex);
+        header.primitiveStride = sizeof(Primitive);
+        header.meshCount = static_cast<uint32_t>(data.meshes.size());
+        header.vertexCount = static_cast<uint32_t>(data.vertices.size());
+        header.indexCount = static_cast<uint32_t>(data.indices.size());
+        header.meshletCount = static_cast<uint32_t>(data.meshlets.size());
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        for (const auto& mesh : data.meshes) {
+            uint32_t nameLength = static_cast<uint32_t>(mesh.name.size());
+            uint32_t primitiveCount = static_cast<uint32_t>(mesh.primitives.size());
+            file.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+            file.write(mesh.name.data(), nameLength);
+            file.write(reinterpret_cast<const char*>(&primitiveCount), sizeof(primitiveCount));
+            file.write(reinterpret_cast<const char*>(mesh.primitives.data()),
+                       static_cast<std::streamsize>(primitiveCount * sizeof(Primitive)));
+        }
+
+        file.write(reinterpret_cast<const char*>(data.vertices.data()),
+                   static_cast<std::streamsize>(data.vertices.size() * sizeof(Vertex)));
+        file.write(reinterpret_cast<const char*>(data.indices.data()),
+                   static_cast<std::streamsize>(data.indices.size() * sizeof(uint32_t)));
+        file.write(reinterpret_cast<const char*>(data.meshlets.data()),
+                   static_cast<std::streamsize>(data.meshlets.size() * sizeof(Meshlet)));
+
+        if (!file) {
+            spdlog::warn("Failed to write mesh cache entry: {}", path.string());
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        spdlog::warn("Failed to finalize mesh cache entry {}: {}", path.string(), ec.message());
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+} // namespace astral
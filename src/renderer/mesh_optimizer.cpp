@@ -0,0 +1,703 @@
+#include "astral/renderer/mesh_optimizer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace astral {
+
+namespace {
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation" scoring parameters
+constexpr uint32_t kCacheSize = 32;
+constexpr float kCacheDecayPower = 1.5f;
+constexpr float kLastTriangleScore = 0.75f;
+constexpr float kValenceBoostScale = 2.0f;
+constexpr float kValenceBoostPower = 0.5f;
+
+// FIFO cache size used for ACMR estimates during overdraw clustering
+constexpr uint32_t kFifoCacheSize = 16;
+
+float vertexScore(int32_t cachePosition, uint32_t liveTriangles) {
+    if (liveTriangles == 0) {
+        return -1.0f; // No triangles left, never pick
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // Vertices of the last emitted triangle get a fixed score so that
+            // strips do not simply continue in the same direction
+            score = kLastTriangleScore;
+        } else {
+            const float scaler = 1.0f / static_cast<float>(kCacheSize - 3);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scaler, kCacheDecayPower);
+        }
+    }
+
+    // Boost vertices with few remaining triangles to finish them off early
+    score += kValenceBoostScale * std::pow(static_cast<float>(liveTriangles), -kValenceBoostPower);
+    return score;
+}
+
+// Simulates a FIFO cache using per-vertex timestamps. Returns true on a miss.
+bool fifoAccess(std::vector<uint32_t>& timestamps, uint32_t& time, uint32_t vertex) {
+    if (time - timestamps[vertex] > kFifoCacheSize) {
+        timestamps[vertex] = time++;
+        return true;
+    }
+    return false;
+}
+
+// Area weighted sum of squared plane distances (Garland-Heckbert), stored as
+// the upper triangle of the symmetric 4x4 plane matrix
+struct Quadric {
+    double a00 = 0, a01 = 0, a02 = 0, a03 = 0;
+    double a11 = 0, a12 = 0, a13 = 0;
+    double a22 = 0, a23 = 0;
+    double a33 = 0;
+    double weight = 0;
+
+    void addPlane(const glm::dvec3& n, double d, double w) {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z; a03 += w * n.x * d;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a13 += w * n.y * d;
+        a22 += w * n.z * n.z; a23 += w * n.z * d;
+        a33 += w * d * d;
+        weight += w;
+    }
+
+    Quadric& operator+=(const Quadric& o) {
+        a00 += o.a00; a01 += o.a01; a02 += o.a02; a03 += o.a03;
+        a11 += o.a11; a12 += o.a12; a13 += o.a13;
+        a22 += o.a22; a23 += o.a23;
+        a33 += o.a33;
+        weight += o.weight;
+        return *this;
+    }
+
+    // Weighted sum of squared distances from p to the accumulated planes
+    double evaluate(const glm::vec3& p) const {
+        const double x = p.x, y = p.y, z = p.z;
+        double r = a00 * x * x + a11 * y * y + a22 * z * z + a33 +
+                   2.0 * (a01 * x * y + a02 * x * z + a03 * x + a12 * y * z + a13 * y + a23 * z);
+        return std::max(r, 0.0);
+    }
+};
+
+struct Collapse {
+    uint32_t from; // Position-unique vertex that is removed
+    uint32_t to;   // Vertex index it is replaced with
+    float error;   // Mesh units
+};
+
+// Maps every vertex to the lowest index vertex with a bitwise equal position,
+// so that attribute seams do not look like open borders.
+std::vector<uint32_t> buildPositionRemap(const std::vector<Vertex>& vertices) {
+    std::vector<uint32_t> order(vertices.size());
+    std::iota(order.begin(), order.end(), 0u);
+    auto less = [&](uint32_t a, uint32_t b) {
+        const glm::vec3& pa = vertices[a].position;
+        const glm::vec3& pb = vertices[b].position;
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    };
+    std::sort(order.begin(), order.end(), less);
+
+    std::vector<uint32_t> remap(vertices.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        const bool sameAsPrevious = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+        remap[order[i]] = sameAsPrevious ? remap[order[i - 1]] : order[i];
+    }
+    return remap;
+}
+
+} // namespace
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertexCount == 0) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency in CSR form. Emitted triangles are removed
+    // by swapping them past the live range of each vertex.
+    std::vector<uint32_t> liveTriangles(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        liveTriangles[indices[i]]++;
+    }
+
+    std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+    }
+
+    std::vector<uint32_t> adjacency(triangleCount * 3);
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (size_t t = 0; t < triangleCount; ++t) {
+        for (size_t k = 0; k < 3; ++k) {
+            adjacency[fill[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<int32_t> cachePositions(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScores[v] = vertexScore(-1, liveTriangles[v]);
+    }
+
+    std::vector<float> triangleScores(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int64_t bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScores[t] = vertexScores[indices[t * 3 + 0]] +
+                            vertexScores[indices[t * 3 + 1]] +
+                            vertexScores[indices[t * 3 + 2]];
+        if (triangleScores[t] > triangleScores[bestTriangle]) {
+            bestTriangle = static_cast<int64_t>(t);
+        }
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(triangleCount * 3);
+
+    uint32_t cache[kCacheSize + 3];
+    uint32_t cacheCount = 0;
+    size_t deadEndCursor = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+        if (bestTriangle < 0) {
+            // No scored candidate around the cache; continue in input order
+            while (emitted[deadEndCursor]) {
+                ++deadEndCursor;
+            }
+            bestTriangle = static_cast<int64_t>(deadEndCursor);
+        }
+
+        const uint32_t triangle = static_cast<uint32_t>(bestTriangle);
+        const uint32_t* tri = &indices[triangle * 3];
+        emitted[triangle] = true;
+        result.insert(result.end(), tri, tri + 3);
+
+        // New cache state: triangle vertices in front, then the old cache
+        uint32_t newCache[kCacheSize + 3];
+        uint32_t newCacheCount = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            if (std::find(newCache, newCache + newCacheCount, tri[k]) == newCache + newCacheCount) {
+                newCache[newCacheCount++] = tri[k];
+            }
+        }
+        for (uint32_t i = 0; i < cacheCount; ++i) {
+            uint32_t v = cache[i];
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                newCache[newCacheCount++] = v;
+            }
+        }
+
+        for (size_t k = 0; k < 3; ++k) {
+            uint32_t v = tri[k];
+            uint32_t* begin = &adjacency[adjacencyOffsets[v]];
+            uint32_t* end = begin + liveTriangles[v];
+            uint32_t* it = std::find(begin, end, triangle);
+            if (it != end) {
+                std::swap(*it, *(end - 1));
+                liveTriangles[v]--;
+            }
+        }
+
+        // Rescore everything that was in the cache, including evicted entries
+        for (uint32_t i = 0; i < newCacheCount; ++i) {
+            uint32_t v = newCache[i];
+            cachePositions[v] = i < kCacheSize ? static_cast<int32_t>(i) : -1;
+            vertexScores[v] = vertexScore(cachePositions[v], liveTriangles[v]);
+        }
+
+        bestTriangle = -1;
+        float bestScore = -1.0f;
+        for (uint32_t i = 0; i < newCacheCount; ++i) {
+            uint32_t v = newCache[i];
+            const uint32_t* adj = &adjacency[adjacencyOffsets[v]];
+            for (uint32_t j = 0; j < liveTriangles[v]; ++j) {
+                uint32_t t = adj[j];
+                float score = vertexScores[indices[t * 3 + 0]] +
+                              vertexScores[indices[t * 3 + 1]] +
+                              vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCacheCount, kCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, float threshold) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertices.empty()) {
+        return;
+    }
+
+    std::vector<uint32_t> timestamps(vertices.size(), 0);
+    uint32_t time = kFifoCacheSize + 1;
+    auto triangleMisses = [&](size_t t) {
+        uint32_t misses = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            misses += fifoAccess(timestamps, time, indices[t * 3 + k]) ? 1 : 0;
+        }
+        return misses;
+    };
+    auto resetCache = [&]() { time += kFifoCacheSize + 1; };
+
+    // Hard boundaries: the cache-optimized order restarts wherever a triangle
+    // misses on all three vertices. Reordering at these points is free.
+    std::vector<uint32_t> hardBoundaries;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        if (triangleMisses(t) == 3 || t == 0) {
+            hardBoundaries.push_back(static_cast<uint32_t>(t));
+        }
+    }
+    hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+    // Soft boundaries: split hard clusters further as long as each piece
+    // keeps its ACMR within threshold of the whole cluster.
+    std::vector<uint32_t> clusters;
+    for (size_t c = 0; c + 1 < hardBoundaries.size(); ++c) {
+        const uint32_t start = hardBoundaries[c];
+        const uint32_t end = hardBoundaries[c + 1];
+
+        resetCache();
+        uint32_t clusterMisses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            clusterMisses += triangleMisses(t);
+        }
+        const float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+        resetCache();
+        clusters.push_back(start);
+        uint32_t subStart = start;
+        uint32_t subMisses = 0;
+        for (uint32_t t = start; t < end; ++t) {
+            subMisses += triangleMisses(t);
+            float acmr = static_cast<float>(subMisses) / static_cast<float>(t - subStart + 1);
+            if (acmr <= clusterThreshold && t + 1 < end) {
+                clusters.push_back(t + 1);
+                subStart = t + 1;
+                subMisses = 0;
+                resetCache();
+            }
+        }
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    glm::vec3 meshCentroid(0.0f);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        meshCentroid += vertices[indices[i]].position;
+    }
+    meshCentroid /= static_cast<float>(triangleCount * 3);
+
+    // Clusters that face away from the mesh center are likely occluders of the
+    // rest of the mesh, so they are drawn first.
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float areaSum = 0.0f;
+
+        for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(n);
+            centroid += (p0 + p1 + p2) * (area / 3.0f);
+            normal += n;
+            areaSum += area;
+        }
+
+        centroid = areaSum > 0.0f ? centroid / areaSum : vertices[indices[clusters[c] * 3]].position;
+        float normalLength = glm::length(normal);
+        normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f);
+        sortKeys[c] = glm::dot(centroid - meshCentroid, normal);
+    }
+
+    std::vector<uint32_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0u);
+    std::stable_sort(order.begin(), order.end(),
+                     [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (uint32_t c : order) {
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+size_t optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    constexpr uint32_t unassigned = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> remap(vertices.size(), unassigned);
+
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (uint32_t& index : indices) {
+        if (remap[index] == unassigned) {
+            remap[index] = static_cast<uint32_t>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(result);
+    return vertices.size();
+}
+
+float computeACMR(const std::vector<uint32_t>& indices, size_t vertexCount, uint32_t cacheSize) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    std::vector<uint32_t> timestamps(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+        if (time - timestamps[index] > cacheSize) {
+            timestamps[index] = time++;
+            misses++;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+std::vector<uint32_t> simplifyMesh(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                   size_t targetIndexCount, float targetError, float* resultError) {
+    std::vector<uint32_t> result = indices;
+    float maxError = 0.0f;
+    const size_t vertexCount = vertices.size();
+    if (result.size() < 3 || vertexCount == 0) {
+        if (resultError) *resultError = 0.0f;
+        return result;
+    }
+
+    const std::vector<uint32_t> remap = buildPositionRemap(vertices);
+    auto position = [&](uint32_t v) -> const glm::vec3& { return vertices[v].position; };
+
+    // Lock border, non-manifold and seam positions. Every directed edge of a
+    // closed manifold surface appears exactly once in each direction.
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::vector<uint64_t> edges;
+        edges.reserve(result.size());
+        for (size_t t = 0; t + 2 < result.size(); t += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint64_t a = remap[result[t + k]];
+                uint64_t b = remap[result[t + (k + 1) % 3]];
+                edges.push_back((a << 32) | b);
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size(); ++i) {
+            const uint32_t a = static_cast<uint32_t>(edges[i] >> 32);
+            const uint32_t b = static_cast<uint32_t>(edges[i] & 0xffffffffu);
+            const uint64_t reverse = (static_cast<uint64_t>(b) << 32) | a;
+            auto range = std::equal_range(edges.begin(), edges.end(), reverse);
+            const bool duplicate = (i > 0 && edges[i - 1] == edges[i]) ||
+                                   (i + 1 < edges.size() && edges[i + 1] == edges[i]);
+            if (duplicate || range.second - range.first != 1) {
+                locked[a] = true;
+                locked[b] = true;
+            }
+        }
+
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (remap[v] != v) {
+                locked[v] = true;
+                locked[remap[v]] = true;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t t = 0; t + 2 < result.size(); t += 3) {
+        const glm::dvec3 p0 = position(result[t + 0]);
+        const glm::dvec3 p1 = position(result[t + 1]);
+        const glm::dvec3 p2 = position(result[t + 2]);
+        glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+        const double area = glm::length(n);
+        if (area <= 0.0) {
+            continue;
+        }
+        n /= area;
+        for (size_t k = 0; k < 3; ++k) {
+            quadrics[remap[result[t + k]]].addPlane(n, -glm::dot(n, p0), area);
+        }
+    }
+
+    auto collapseError = [&](uint32_t from, uint32_t to) {
+        Quadric q = quadrics[from];
+        q += quadrics[remap[to]];
+        const double squared = q.weight > 0.0 ? q.evaluate(position(to)) / q.weight : 0.0;
+        return static_cast<float>(std::sqrt(squared));
+    };
+
+    std::vector<uint32_t> adjacencyOffsets;
+    std::vector<uint32_t> adjacency;
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> collapseTarget(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<uint32_t> ringFrom;
+    std::vector<uint32_t> ringTo;
+
+    // Unique positions around v, taken from the triangle adjacency
+    auto gatherRing = [&](uint32_t v, std::vector<uint32_t>& ring) {
+        ring.clear();
+        for (uint32_t i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; ++i) {
+            const uint32_t t = adjacency[i];
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t w = remap[result[t * 3 + k]];
+                if (w != v && std::find(ring.begin(), ring.end(), w) == ring.end()) {
+                    ring.push_back(w);
+                }
+            }
+        }
+    };
+
+    // Rejects collapses that flip or degenerate a remaining triangle around from
+    auto preservesOrientation = [&](uint32_t from, uint32_t to) {
+        const uint32_t toPosition = remap[to];
+        for (uint32_t i = adjacencyOffsets[from]; i < adjacencyOffsets[from + 1]; ++i) {
+            const uint32_t t = adjacency[i];
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+            bool removed = false;
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t v = remap[result[t * 3 + k]];
+                removed |= v == toPosition;
+                before[k] = position(v);
+                after[k] = v == from ? position(to) : before[k];
+            }
+            if (removed) {
+                continue; // Degenerates into an edge and is dropped
+            }
+
+            const glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+            const float l0 = glm::length(n0);
+            const float l1 = glm::length(n1);
+            if (l1 <= 0.0f || glm::dot(n0, n1) < 0.25f * l0 * l1) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    // Each pass collapses an independent set of the cheapest edges: no two
+    // collapses share a triangle, so their validity checks do not interact.
+    while (result.size() > targetIndexCount) {
+        const size_t triangleCount = result.size() / 3;
+
+        adjacencyOffsets.assign(vertexCount + 1, 0);
+        for (uint32_t index : result) {
+            adjacencyOffsets[remap[index] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (size_t k = 0; k < 3; ++k) {
+                adjacency[fill[remap[result[t * 3 + k]]]++] = static_cast<uint32_t>(t);
+            }
+        }
+
+        collapses.clear();
+        for (size_t t = 0; t < triangleCount; ++t) {
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t a = result[t * 3 + k];
+                const uint32_t b = result[t * 3 + (k + 1) % 3];
+                if (!locked[a] && remap[a] == a) {
+                    collapses.push_back({a, b, collapseError(a, b)});
+                }
+                if (!locked[b] && remap[b] == b) {
+                    collapses.push_back({b, a, collapseError(b, a)});
+                }
+            }
+        }
+        if (collapses.empty()) {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        // Only the cheaper part of the queue is used per pass so that costs
+        // are refreshed before more expensive regions get collapsed
+        const float passLimit = std::min(targetError, collapses[collapses.size() / 4].error);
+        const size_t targetTriangles = targetIndexCount / 3;
+        size_t remainingTriangles = triangleCount;
+
+        std::iota(collapseTarget.begin(), collapseTarget.end(), 0u);
+        std::fill(touched.begin(), touched.end(), false);
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (remainingTriangles <= targetTriangles || collapse.error > targetError) {
+                break;
+            }
+            if (applied > 0 && collapse.error > passLimit) {
+                break;
+            }
+            if (touched[collapse.from] || touched[remap[collapse.to]]) {
+                continue;
+            }
+
+            // Link condition: an interior edge shares exactly two neighbours,
+            // more would pinch the surface into a non-manifold fan
+            gatherRing(collapse.from, ringFrom);
+            gatherRing(remap[collapse.to], ringTo);
+            size_t shared = 0;
+            for (uint32_t w : ringFrom) {
+                shared += std::find(ringTo.begin(), ringTo.end(), w) != ringTo.end() ? 1 : 0;
+            }
+            if (shared != 2 || !preservesOrientation(collapse.from, collapse.to)) {
+                continue;
+            }
+
+            collapseTarget[collapse.from] = collapse.to;
+            quadrics[remap[collapse.to]] += quadrics[collapse.from];
+            touched[collapse.from] = true;
+            for (uint32_t w : ringFrom) {
+                touched[w] = true;
+            }
+            maxError = std::max(maxError, collapse.error);
+            remainingTriangles -= std::min<size_t>(remainingTriangles, 2);
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        size_t write = 0;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32_t tri[3];
+            for (size_t k = 0; k < 3; ++k) {
+                tri[k] = collapseTarget[result[t * 3 + k]];
+            }
+            if (remap[tri[0]] == remap[tri[1]] || remap[tri[1]] == remap[tri[2]] || remap[tri[0]] == remap[tri[2]]) {
+                continue;
+            }
+            std::copy(tri, tri + 3, result.begin() + write);
+            write += 3;
+        }
+        result.resize(write);
+    }
+
+    if (resultError) {
+        *resultError = maxError;
+    }
+    return result;
+}
+
+std::vector<Meshlet> buildMeshlets(const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices,
+                                   size_t maxVertices, size_t maxTriangles) {
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount == 0 || vertices.empty()) {
+        return meshlets;
+    }
+
+    // Stamp of the meshlet that last referenced each vertex
+    constexpr uint32_t unused = std::numeric_limits<uint32_t>::max();
+    std::vector<uint32_t> stamps(vertices.size(), unused);
+    std::vector<uint32_t> meshletVertices;
+    std::vector<glm::vec3> normals;
+    meshletVertices.reserve(maxVertices);
+
+    auto finish = [&](size_t firstTriangle, size_t endTriangle) {
+        Meshlet meshlet{};
+        meshlet.firstIndex = static_cast<uint32_t>(firstTriangle * 3);
+        meshlet.indexCount = static_cast<uint32_t>((endTriangle - firstTriangle) * 3);
+
+        glm::vec3 minPos(std::numeric_limits<float>::max());
+        glm::vec3 maxPos(std::numeric_limits<float>::lowest());
+        for (uint32_t v : meshletVertices) {
+            minPos = glm::min(minPos, vertices[v].position);
+            maxPos = glm::max(maxPos, vertices[v].position);
+        }
+        meshlet.center = (minPos + maxPos) * 0.5f;
+        for (uint32_t v : meshletVertices) {
+            meshlet.radius = std::max(meshlet.radius, glm::distance(meshlet.center, vertices[v].position));
+        }
+
+        // Normal cone: every triangle normal lies within the cone half angle
+        // of the average normal. Wide cones cannot be culled and are disabled.
+        normals.clear();
+        glm::vec3 axis(0.0f);
+        for (size_t t = firstTriangle; t < endTriangle; ++t) {
+            const glm::vec3& p0 = vertices[indices[t * 3 + 0]].position;
+            const glm::vec3& p1 = vertices[indices[t * 3 + 1]].position;
+            const glm::vec3& p2 = vertices[indices[t * 3 + 2]].position;
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length > 0.0f) {
+                normals.push_back(n / length);
+                axis += n / length;
+            }
+        }
+
+        meshlet.coneCutoff = 1.0f;
+        float axisLength = glm::length(axis);
+        if (axisLength > 0.0f) {
+            // Degenerate triangles produce no fragments and are ignored
+            meshlet.coneAxis = axis / axisLength;
+            float minDot = 1.0f;
+            for (const glm::vec3& n : normals) {
+                minDot = std::min(minDot, glm::dot(n, meshlet.coneAxis));
+            }
+            if (minDot > 0.1f) {
+                meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+            }
+        }
+
+        meshlets.push_back(meshlet);
+        meshletVertices.clear();
+    };
+
+    size_t firstTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32_t* tri = &indices[t * 3];
+        const uint32_t stamp = static_cast<uint32_t>(meshlets.size());
+        size_t newVertices = 0;
+        for (size_t k = 0; k < 3; ++k) {
+            bool repeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            newVertices += stamps[tri[k]] != stamp && !repeated ? 1 : 0;
+        }
+
+        if (t > firstTriangle &&
+            (meshletVertices.size() + newVertices > maxVertices || t - firstTriangle >= maxTriangles)) {
+            finish(firstTriangle, t);
+            firstTriangle = t;
+        }
+
+        const uint32_t current = static_cast<uint32_t>(meshlets.size());
+        for (size_t k = 0; k < 3; ++k) {
+            if (stamps[tri[k]] != current) {
+                stamps[tri[k]] = current;
+                meshletVertices.push_back(tri[k]);
+            }
+        }
+    }
+    finish(firstTriangle, triangleCount);
+
+    return meshlets;
+}
+
+} // namespace astral
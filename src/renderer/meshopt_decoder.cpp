@@ -0,0 +1,455 @@
+#include "astral/renderer/meshopt_decoder.hpp"
+#include <cmath>
+#include <cstring>
+
+namespace astral {
+
+namespace {
+
+// Vertex codec
+constexpr uint8_t kVertexHeader = 0xa0;
+constexpr size_t kVertexBlockSizeBytes = 8192;
+constexpr size_t kVertexBlockMaxSize = 256;
+constexpr size_t kByteGroupSize = 16;
+constexpr size_t kByteGroupDecodeLimit = 24;
+constexpr size_t kTailMaxSize = 32;
+
+// Index codecs
+constexpr uint8_t kIndexHeader = 0xe0;
+constexpr uint8_t kSequenceHeader = 0xd0;
+
+size_t getVertexBlockSize(size_t vertexSize) {
+    // Blocks hold up to 8 KB of vertex data, in whole byte groups
+    size_t result = kVertexBlockSizeBytes / vertexSize;
+    result &= ~(kByteGroupSize - 1);
+    return result < kVertexBlockMaxSize ? result : kVertexBlockMaxSize;
+}
+
+uint8_t unzigzag8(uint8_t v) {
+    return static_cast<uint8_t>(-(v & 1) ^ (v >> 1));
+}
+
+// One group of 16 deltas, each 0, 2, 4 or 8 bits wide. Values equal to the
+// all-ones sentinel are escaped and stored as full bytes after the group.
+const uint8_t* decodeBytesGroup(const uint8_t* data, uint8_t* buffer, int bitslog2) {
+    switch (bitslog2) {
+    case 0:
+        std::memset(buffer, 0, kByteGroupSize);
+        return data;
+    case 1:
+    case 2: {
+        const int bits = 1 << bitslog2;
+        const uint8_t sentinel = static_cast<uint8_t>((1 << bits) - 1);
+        const size_t packedBytes = kByteGroupSize * bits / 8;
+        const uint8_t* escaped = data + packedBytes;
+
+        for (size_t i = 0; i < kByteGroupSize; ++i) {
+            size_t bitOffset = i * bits;
+            uint8_t byte = data[bitOffset / 8];
+            uint8_t enc = static_cast<uint8_t>((byte >> (8 - bits - bitOffset % 8)) & sentinel);
+            if (enc == sentinel) {
+                buffer[i] = *escaped++;
+            } else {
+                buffer[i] = enc;
+            }
+        }
+        return escaped;
+    }
+    case 3:
+    default:
+        std::memcpy(buffer, data, kByteGroupSize);
+        return data + kByteGroupSize;
+    }
+}
+
+const uint8_t* decodeBytes(const uint8_t* data, const uint8_t* dataEnd, uint8_t* buffer, size_t bufferSize) {
+    // 2-bit group widths, four per header byte
+    const uint8_t* header = data;
+    size_t headerSize = (bufferSize / kByteGroupSize + 3) / 4;
+    if (static_cast<size_t>(dataEnd - data) < headerSize) {
+        return nullptr;
+    }
+    data += headerSize;
+
+    for (size_t i = 0; i < bufferSize; i += kByteGroupSize) {
+        if (static_cast<size_t>(dataEnd - data) < kByteGroupDecodeLimit) {
+            return nullptr;
+        }
+        size_t headerOffset = i / kByteGroupSize;
+        int bitslog2 = (header[headerOffset / 4] >> ((headerOffset % 4) * 2)) & 3;
+        data = decodeBytesGroup(data, buffer + i, bitslog2);
+    }
+    return data;
+}
+
+// Byte k of every vertex is stored as a separate stream of zigzag deltas
+// against the same byte of the previous vertex.
+const uint8_t* decodeVertexBlock(const uint8_t* data, const uint8_t* dataEnd, uint8_t* vertexData,
+                                 size_t vertexCount, size_t vertexSize, uint8_t lastVertex[256]) {
+    uint8_t buffer[kVertexBlockMaxSize];
+    size_t vertexCountAligned = (vertexCount + kByteGroupSize - 1) & ~(kByteGroupSize - 1);
+
+    for (size_t k = 0; k < vertexSize; ++k) {
+        data = decodeBytes(data, dataEnd, buffer, vertexCountAligned);
+        if (!data) {
+            return nullptr;
+        }
+
+        size_t vertexOffset = k;
+        uint8_t p = lastVertex[k];
+        for (size_t i = 0; i < vertexCount; ++i) {
+            uint8_t v = static_cast<uint8_t>(unzigzag8(buffer[i]) + p);
+            vertexData[vertexOffset] = v;
+            p = v;
+            vertexOffset += vertexSize;
+        }
+    }
+
+    std::memcpy(lastVertex, &vertexData[vertexSize * (vertexCount - 1)], vertexSize);
+    return data;
+}
+
+uint32_t decodeVByte(const uint8_t*& data) {
+    uint8_t lead = *data++;
+    if (lead < 128) {
+        return lead;
+    }
+
+    // Up to five 7-bit groups, little endian, high bit = continue
+    uint32_t result = lead & 127;
+    uint32_t shift = 7;
+    for (int i = 0; i < 4; ++i) {
+        uint8_t group = *data++;
+        result |= static_cast<uint32_t>(group & 127) << shift;
+        shift += 7;
+        if (group < 128) {
+            break;
+        }
+    }
+    return result;
+}
+
+uint32_t decodeIndex(const uint8_t*& data, uint32_t last) {
+    uint32_t v = decodeVByte(data);
+    uint32_t d = (v >> 1) ^ static_cast<uint32_t>(-static_cast<int32_t>(v & 1));
+    return last + d;
+}
+
+void writeIndex(void* destination, size_t offset, size_t indexSize, uint32_t value) {
+    if (indexSize == 2) {
+        static_cast<uint16_t*>(destination)[offset] = static_cast<uint16_t>(value);
+    } else {
+        static_cast<uint32_t*>(destination)[offset] = value;
+    }
+}
+
+void writeTriangle(void* destination, size_t offset, size_t indexSize, uint32_t a, uint32_t b, uint32_t c) {
+    writeIndex(destination, offset + 0, indexSize, a);
+    writeIndex(destination, offset + 1, indexSize, b);
+    writeIndex(destination, offset + 2, indexSize, c);
+}
+
+using EdgeFifo = uint32_t[16][2];
+using VertexFifo = uint32_t[16];
+
+void pushEdgeFifo(EdgeFifo fifo, uint32_t a, uint32_t b, size_t& offset) {
+    fifo[offset][0] = a;
+    fifo[offset][1] = b;
+    offset = (offset + 1) & 15;
+}
+
+void pushVertexFifo(VertexFifo fifo, uint32_t v, size_t& offset, int cond = 1) {
+    fifo[offset] = v;
+    offset = (offset + cond) & 15;
+}
+
+int32_t roundToInt(float value) {
+    return static_cast<int32_t>(value + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+template <typename T>
+void decodeFilterOct(T* data, size_t count) {
+    const float maxValue = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+    for (size_t i = 0; i < count; ++i) {
+        // z is stored so that |x| + |y| + |z| == 1 in the encoded scale
+        float x = static_cast<float>(data[i * 4 + 0]);
+        float y = static_cast<float>(data[i * 4 + 1]);
+        float z = static_cast<float>(data[i * 4 + 2]) - std::fabs(x) - std::fabs(y);
+
+        // Unfold the lower hemisphere
+        float t = z < 0.0f ? z : 0.0f;
+        x += x >= 0.0f ? t : -t;
+        y += y >= 0.0f ? t : -t;
+
+        float length = std::sqrt(x * x + y * y + z * z);
+        float scale = maxValue / length;
+
+        data[i * 4 + 0] = static_cast<T>(roundToInt(x * scale));
+        data[i * 4 + 1] = static_cast<T>(roundToInt(y * scale));
+        data[i * 4 + 2] = static_cast<T>(roundToInt(z * scale));
+    }
+}
+
+} // namespace
+
+bool decodeMeshoptVertexBuffer(void* destination, size_t vertexCount, size_t vertexSize,
+                               const uint8_t* buffer, size_t bufferSize) {
+    if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0) {
+        return false;
+    }
+
+    const uint8_t* data = buffer;
+    const uint8_t* dataEnd = buffer + bufferSize;
+    if (bufferSize < 1 + vertexSize) {
+        return false;
+    }
+
+    uint8_t header = *data++;
+    if ((header & 0xf0) != kVertexHeader || (header & 0x0f) != 0) {
+        return false;
+    }
+
+    // The tail stores the first vertex's delta base
+    uint8_t lastVertex[256];
+    std::memcpy(lastVertex, dataEnd - vertexSize, vertexSize);
+
+    auto* vertexData = static_cast<uint8_t*>(destination);
+    size_t vertexBlockSize = getVertexBlockSize(vertexSize);
+    for (size_t vertexOffset = 0; vertexOffset < vertexCount;) {
+        size_t blockSize = vertexOffset + vertexBlockSize < vertexCount ? vertexBlockSize : vertexCount - vertexOffset;
+        data = decodeVertexBlock(data, dataEnd, vertexData + vertexOffset * vertexSize, blockSize, vertexSize,
+                                 lastVertex);
+        if (!data) {
+            return false;
+        }
+        vertexOffset += blockSize;
+    }
+
+    size_t tailSize = vertexSize < kTailMaxSize ? kTailMaxSize : vertexSize;
+    return static_cast<size_t>(dataEnd - data) == tailSize;
+}
+
+bool decodeMeshoptIndexBuffer(void* destination, size_t indexCount, size_t indexSize,
+                              const uint8_t* buffer, size_t bufferSize) {
+    if (indexCount % 3 != 0 || (indexSize != 2 && indexSize != 4)) {
+        return false;
+    }
+    // Smallest valid stream: header, one code byte per triangle, 16-byte codeaux table
+    if (bufferSize < 1 + indexCount / 3 + 16) {
+        return false;
+    }
+    if ((buffer[0] & 0xf0) != kIndexHeader) {
+        return false;
+    }
+    int version = buffer[0] & 0x0f;
+    if (version > 1) {
+        return false;
+    }
+
+    EdgeFifo edgeFifo;
+    VertexFifo vertexFifo;
+    std::memset(edgeFifo, -1, sizeof(edgeFifo));
+    std::memset(vertexFifo, -1, sizeof(vertexFifo));
+    size_t edgeFifoOffset = 0;
+    size_t vertexFifoOffset = 0;
+
+    uint32_t next = 0;
+    uint32_t last = 0;
+    // Version 1 uses codes 13/14 for free indices at last -/+ 1
+    int fecMax = version >= 1 ? 13 : 15;
+
+    const uint8_t* code = buffer + 1;
+    const uint8_t* data = code + indexCount / 3;
+    const uint8_t* dataSafeEnd = buffer + bufferSize - 16;
+    const uint8_t* codeauxTable = dataSafeEnd;
+
+    for (size_t i = 0; i < indexCount; i += 3) {
+        // A triangle reads at most 16 bytes, the codeaux table guards the tail
+        if (data > dataSafeEnd) {
+            return false;
+        }
+
+        uint8_t codetri = *code++;
+
+        if (codetri < 0xf0) {
+            // Triangle shares an edge from the edge FIFO
+            int fe = codetri >> 4;
+            uint32_t a = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][0];
+            uint32_t b = edgeFifo[(edgeFifoOffset - 1 - fe) & 15][1];
+            int fec = codetri & 15;
+
+            if (fec < fecMax) {
+                uint32_t cf = vertexFifo[(vertexFifoOffset - 1 - fec) & 15];
+                uint32_t c = fec == 0 ? next : cf;
+                int fec0 = fec == 0;
+                next += fec0;
+
+                writeTriangle(destination, i, indexSize, a, b, c);
+                pushVertexFifo(vertexFifo, c, vertexFifoOffset, fec0);
+                pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+                pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+            } else {
+                // fec - (fec ^ 3) maps 13, 14 to -1, +1
+                uint32_t c = fec != 15 ? last + static_cast<uint32_t>(fec - (fec ^ 3)) : decodeIndex(data, last);
+                last = c;
+
+                writeTriangle(destination, i, indexSize, a, b, c);
+                pushVertexFifo(vertexFifo, c, vertexFifoOffset);
+                pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+                pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+            }
+        } else if (codetri < 0xfe) {
+            // New triangle, vertex references from the codeaux table
+            uint8_t codeaux = codeauxTable[codetri & 15];
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+
+            // next is advanced for all three vertices before b and c are resolved
+            uint32_t a = next++;
+
+            uint32_t bf = vertexFifo[(vertexFifoOffset - feb) & 15];
+            uint32_t b = feb == 0 ? next : bf;
+            int feb0 = feb == 0;
+            next += feb0;
+
+            uint32_t cf = vertexFifo[(vertexFifoOffset - fec) & 15];
+            uint32_t c = fec == 0 ? next : cf;
+            int fec0 = fec == 0;
+            next += fec0;
+
+            writeTriangle(destination, i, indexSize, a, b, c);
+            pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+            pushVertexFifo(vertexFifo, b, vertexFifoOffset, feb0);
+            pushVertexFifo(vertexFifo, c, vertexFifoOffset, fec0);
+            pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+        } else {
+            // New triangle with an explicit codeaux byte and free indices
+            uint8_t codeaux = *data++;
+            int fea = codetri == 0xfe ? 0 : 15;
+            int feb = codeaux >> 4;
+            int fec = codeaux & 15;
+
+            // Restart marker
+            if (codeaux == 0) {
+                next = 0;
+            }
+
+            uint32_t a = fea == 0 ? next++ : 0;
+            uint32_t b = feb == 0 ? next++ : vertexFifo[(vertexFifoOffset - feb) & 15];
+            uint32_t c = fec == 0 ? next++ : vertexFifo[(vertexFifoOffset - fec) & 15];
+
+            if (fea == 15) {
+                last = a = decodeIndex(data, last);
+            }
+            if (feb == 15) {
+                last = b = decodeIndex(data, last);
+            }
+            if (fec == 15) {
+                last = c = decodeIndex(data, last);
+            }
+
+            writeTriangle(destination, i, indexSize, a, b, c);
+            pushVertexFifo(vertexFifo, a, vertexFifoOffset);
+            pushVertexFifo(vertexFifo, b, vertexFifoOffset, (feb == 0) | (feb == 15));
+            pushVertexFifo(vertexFifo, c, vertexFifoOffset, (fec == 0) | (fec == 15));
+            pushEdgeFifo(edgeFifo, b, a, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, c, b, edgeFifoOffset);
+            pushEdgeFifo(edgeFifo, a, c, edgeFifoOffset);
+        }
+    }
+
+    // All triangle data consumed, stopping right at the codeaux table
+    return data == dataSafeEnd;
+}
+
+bool decodeMeshoptIndexSequence(void* destination, size_t indexCount, size_t indexSize,
+                                const uint8_t* buffer, size_t bufferSize) {
+    if (indexSize != 2 && indexSize != 4) {
+        return false;
+    }
+    // Smallest valid stream: header, one byte per index, 4-byte tail
+    if (bufferSize < 1 + indexCount + 4) {
+        return false;
+    }
+    if ((buffer[0] & 0xf0) != kSequenceHeader || (buffer[0] & 0x0f) > 1) {
+        return false;
+    }
+
+    const uint8_t* data = buffer + 1;
+    const uint8_t* dataSafeEnd = buffer + bufferSize - 4;
+
+    // Two delta baselines; the low bit of each code selects one
+    uint32_t last[2] = {};
+    for (size_t i = 0; i < indexCount; ++i) {
+        if (data >= dataSafeEnd) {
+            return false;
+        }
+
+        uint32_t v = decodeVByte(data);
+        uint32_t current = v & 1;
+        v >>= 1;
+        uint32_t d = (v >> 1) ^ static_cast<uint32_t>(-static_cast<int32_t>(v & 1));
+        uint32_t index = last[current] + d;
+        last[current] = index;
+
+        writeIndex(destination, i, indexSize, index);
+    }
+
+    return data == dataSafeEnd;
+}
+
+void decodeMeshoptFilterOctahedral(void* data, size_t count, size_t stride) {
+    if (stride == 4) {
+        decodeFilterOct(static_cast<int8_t*>(data), count);
+    } else if (stride == 8) {
+        decodeFilterOct(static_cast<int16_t*>(data), count);
+    }
+}
+
+void decodeMeshoptFilterQuaternion(void* data, size_t count, size_t stride) {
+    if (stride != 8) {
+        return;
+    }
+
+    auto* values = static_cast<int16_t*>(data);
+    const float scale = 1.0f / std::sqrt(2.0f);
+    for (size_t i = 0; i < count; ++i) {
+        // The fourth component holds the scale and the index of the dropped component
+        int sf = values[i * 4 + 3] | 3;
+        float ss = scale / static_cast<float>(sf);
+
+        float x = static_cast<float>(values[i * 4 + 0]) * ss;
+        float y = static_cast<float>(values[i * 4 + 1]) * ss;
+        float z = static_cast<float>(values[i * 4 + 2]) * ss;
+
+        float ww = 1.0f - x * x - y * y - z * z;
+        float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+        int qc = values[i * 4 + 3] & 3;
+        values[i * 4 + ((qc + 1) & 3)] = static_cast<int16_t>(roundToInt(x * 32767.0f));
+        values[i * 4 + ((qc + 2) & 3)] = static_cast<int16_t>(roundToInt(y * 32767.0f));
+        values[i * 4 + ((qc + 3) & 3)] = static_cast<int16_t>(roundToInt(z * 32767.0f));
+        values[i * 4 + ((qc + 0) & 3)] = static_cast<int16_t>(roundToInt(w * 32767.0f));
+    }
+}
+
+void decodeMeshoptFilterExponential(void* data, size_t count, size_t stride) {
+    auto* values = static_cast<uint32_t*>(data);
+    size_t valueCount = count * (stride / 4);
+    for (size_t i = 0; i < valueCount; ++i) {
+        // 24-bit signed mantissa, 8-bit signed exponent: ldexp(m, e)
+        uint32_t v = values[i];
+        int32_t m = static_cast<int32_t>(v << 8) >> 8;
+        int32_t e = static_cast<int32_t>(v) >> 24;
+
+        float scale;
+        uint32_t scaleBits = static_cast<uint32_t>(e + 127) << 23;
+        std::memcpy(&scale, &scaleBits, sizeof(scale));
+        float result = scale * static_cast<float>(m);
+        std::memcpy(&values[i], &result, sizeof(result));
+    }
+}
+
+} // namespace astral
@@ -1,4 +1,8 @@
 #include "astral/renderer/model.hpp"
+#include "astral/renderer/geometry_pool.hpp"
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace astral {
 
@@ -11,7 +15,8 @@ VkVertexInputBindingDescription Vertex::getBindingDescription() {
 }
 
 std::vector<VkVertexInputAttributeDescription> Vertex::getAttributeDescriptions() {
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(5);
+    // Color is never written by the loader, so it is not fed to the shaders.
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
 
     attributeDescriptions[0].binding = 0;
     attributeDescriptions[0].location = 0;
@@ -33,12 +38,101 @@ std::vector<VkVertexInputAttributeDescription> Vertex::getAttributeDescriptions(
     attributeDescriptions[3].format = VK_FORMAT_R32G32B32A32_SFLOAT;
     attributeDescriptions[3].offset = offsetof(Vertex, tangent);
 
-    attributeDescriptions[4].binding = 0;
-    attributeDescriptions[4].location = 4;
-    attributeDescriptions[4].format = VK_FORMAT_R32G32B32A32_SFLOAT;
-    attributeDescriptions[4].offset = offsetof(Vertex, color);
+    return attributeDescriptions;
+}
+
+static int16_t packSnorm16(float value) {
+    return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static uint16_t packUnorm16(float value) {
+    return static_cast<uint16_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+// Octahedral encoding, decoded by octDecode() in pbr.vert
+static glm::vec2 octEncode(glm::vec3 n) {
+    float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (sum < 1e-8f) {
+        return glm::vec2(0.0f, 0.0f); // Degenerate vector decodes to +Z
+    }
+    n /= sum;
+    if (n.z < 0.0f) {
+        glm::vec2 wrapped((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                          (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+        return wrapped;
+    }
+    return glm::vec2(n.x, n.y);
+}
+
+PackedVertex PackedVertex::pack(const Vertex& vertex, const glm::vec3& quantOffset, const glm::vec3& quantScale) {
+    PackedVertex packed{};
+
+    for (int i = 0; i < 3; ++i) {
+        float extent = quantScale[i];
+        float normalized = extent > 0.0f ? (vertex.position[i] - quantOffset[i]) / extent : 0.0f;
+        packed.position[i] = packUnorm16(normalized);
+    }
+    packed.position[3] = vertex.tangent.w < 0.0f ? 0 : 65535;
+
+    glm::vec2 n = octEncode(vertex.normal);
+    packed.normal[0] = packSnorm16(n.x);
+    packed.normal[1] = packSnorm16(n.y);
+
+    glm::vec2 t = octEncode(glm::vec3(vertex.tangent));
+    packed.tangent[0] = packSnorm16(t.x);
+    packed.tangent[1] = packSnorm16(t.y);
+
+    packed.uv[0] = glm::packHalf1x16(vertex.uv.x);
+    packed.uv[1] = glm::packHalf1x16(vertex.uv.y);
+
+    return packed;
+}
+
+VkVertexInputBindingDescription PackedVertex::getBindingDescription() {
+    VkVertexInputBindingDescription bindingDescription{};
+    bindingDescription.binding = 0;
+    bindingDescription.stride = sizeof(PackedVertex);
+    bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    return bindingDescription;
+}
+
+std::vector<VkVertexInputAttributeDescription> PackedVertex::getAttributeDescriptions() {
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions(4);
+
+    attributeDescriptions[0].binding = 0;
+    attributeDescriptions[0].location = 0;
+    attributeDescriptions[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+    attributeDescriptions[0].offset = offsetof(PackedVertex, position);
+
+    attributeDescriptions[1].binding = 0;
+    attributeDescriptions[1].location = 1;
+    attributeDescriptions[1].format = VK_FORMAT_R16G16_SNORM;
+    attributeDescriptions[1].offset = offsetof(PackedVertex, normal);
+
+    attributeDescriptions[2].binding = 0;
+    attributeDescriptions[2].location = 2;
+    attributeDescriptions[2].format = VK_FORMAT_R16G16_SFLOAT;
+    attributeDescriptions[2].offset = offsetof(PackedVertex, uv);
+
+    attributeDescriptions[3].binding = 0;
+    attributeDescriptions[3].location = 3;
+    attributeDescriptions[3].format = VK_FORMAT_R16G16_SNORM;
+    attributeDescriptions[3].offset = offsetof(PackedVertex, tangent);
 
     return attributeDescriptions;
 }
 
+void Model::updateWorldMatrices() {
+    // linearNodes is ordered parents first, so one pass is enough
+    for (Node* node : linearNodes) {
+        node->worldMatrix = node->parent ? node->parent->worldMatrix * node->matrix : node->matrix;
+    }
+}
+
+Model::~Model() {
+    if (geometryPool) {
+        geometryPool->free(geometry);
+    }
+}
+
 } // namespace astral
@@ -1,4 +1,5 @@
 #include "astral/renderer/pipeline.hpp"
+#include "astral/renderer/descriptor_manager.hpp"
 #include <stdexcept>
 
 namespace astral {
@@ -31,7 +32,7 @@ GraphicsPipeline::GraphicsPipeline(Context* context, const PipelineSpecs& specs)
     rasterizer.polygonMode = specs.polygonMode;
     rasterizer.lineWidth = 1.0f;
     rasterizer.cullMode = specs.cullMode;
-    rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterizer.frontFace = specs.frontFace;
 
     VkPipelineMultisampleStateCreateInfo multisampling = {};
     multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
@@ -83,6 +84,7 @@ GraphicsPipeline::GraphicsPipeline(Context* context, const PipelineSpecs& specs)
     pipelineInfo.pColorBlendState = &colorBlending;
     pipelineInfo.pDynamicState = &dynamicState;
     pipelineInfo.layout = specs.layout;
+    pipelineInfo.flags = m_context->getDescriptorManager().getPipelineCreateFlags();
 
     if (vkCreateGraphicsPipelines(m_context->getDevice(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_pipeline) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create graphics pipeline!");
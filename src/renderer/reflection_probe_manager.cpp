@@ -0,0 +1,411 @@
+#include "astral/renderer/reflection_probe_manager.hpp"
+#include "astral/core/asset_file.hpp"
+#include "astral/core/sampler_cache.hpp"
+#include "astral/renderer/descriptor_manager.hpp"
+
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <stdexcept>
+
+namespace astral {
+
+constexpr VkFormat PROBE_FORMAT = VK_FORMAT_R16G16B16A16_SFLOAT;
+constexpr float CAPTURE_NEAR = 0.05f;
+
+// Face views in cube map order. Rendered without the Y flip so the texels
+// land where hardware cube sampling looks them up.
+static const glm::vec3 FACE_DIRECTIONS[6] = {
+    {1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f},
+    {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, {0.0f, 0.0f, -1.0f}};
+static const glm::vec3 FACE_UPS[6] = {
+    {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+    {0.0f, 0.0f, -1.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}};
+
+ReflectionProbeManager::ReflectionProbeManager(Context *context)
+    : m_context(context) {
+  auto &descriptors = m_context->getDescriptorManager();
+
+  VkSamplerCreateInfo samplerInfo = {VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+  samplerInfo.magFilter = VK_FILTER_LINEAR;
+  samplerInfo.minFilter = VK_FILTER_LINEAR;
+  samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+  samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  samplerInfo.maxLod = static_cast<float>(PROBE_MIPS);
+  VkSampler sampler = m_context->getSamplerCache().getSampler(samplerInfo);
+
+  ImageSpecs atlasSpecs;
+  atlasSpecs.width = PROBE_SIZE;
+  atlasSpecs.height = PROBE_SIZE;
+  atlasSpecs.format = PROBE_FORMAT;
+  atlasSpecs.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+  atlasSpecs.mipLevels = PROBE_MIPS;
+  atlasSpecs.arrayLayers = MAX_PROBES * 6;
+  atlasSpecs.viewType = VK_IMAGE_VIEW_TYPE_CUBE_ARRAY;
+  m_atlas = std::make_unique<Image>(m_context, atlasSpecs);
+  m_atlasIndex = descriptors.registerImageCubeArray(
+      m_atlas->getView(), sampler, VK_IMAGE_LAYOUT_GENERAL);
+
+  createTargets();
+  m_captureColorIndex =
+      descriptors.registerImageCube(m_captureColor->getView(), sampler);
+
+  for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame) {
+    for (uint32_t step = 0; step < MAX_STEPS_PER_FRAME; ++step) {
+      m_captureSceneBuffers.push_back(std::make_unique<Buffer>(
+          m_context, sizeof(SceneData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+          VMA_MEMORY_USAGE_AUTO,
+          VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+      m_captureSceneIndices.push_back(descriptors.registerBuffer(
+          m_captureSceneBuffers.back()->getHandle(), 0, sizeof(SceneData)));
+    }
+
+    const VkDeviceSize probesSize = sizeof(ReflectionProbe) * MAX_PROBES;
+    m_probeBuffers.push_back(std::make_unique<Buffer>(
+        m_context, probesSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VMA_MEMORY_USAGE_AUTO,
+        VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT));
+    m_probeBufferIndices.push_back(descriptors.registerBuffer(
+        m_probeBuffers.back()->getHandle(), 0, probesSize));
+  }
+
+  VkPushConstantRange pushRange = {};
+  pushRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  pushRange.size = sizeof(uint32_t) * 2 + sizeof(float);
+  VkDescriptorSetLayout setLayout = descriptors.getLayout();
+  VkPipelineLayoutCreateInfo layoutInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  layoutInfo.pushConstantRangeCount = 1;
+  layoutInfo.pPushConstantRanges = &pushRange;
+  layoutInfo.setLayoutCount = 1;
+  layoutInfo.pSetLayouts = &setLayout;
+  if (vkCreatePipelineLayout(m_context->getDevice(), &layoutInfo, nullptr,
+                             &m_filterLayout) != VK_SUCCESS) {
+    throw std::runtime_error("Failed to create probe filter pipeline layout!");
+  }
+
+  ComputePipelineSpecs filterSpecs;
+  filterSpecs.computeShader = std::make_shared<Shader>(
+      m_context, readAssetFile("assets/shaders/prefilter.comp"),
+      ShaderStage::Compute, "ProbePrefilter");
+  filterSpecs.layout = m_filterLayout;
+  m_filterPipeline = std::make_unique<ComputePipeline>(m_context, filterSpecs);
+}
+
+ReflectionProbeManager::~ReflectionProbeManager() {
+  VkDevice device = m_context->getDevice();
+  for (const Probe &probe : m_probes) {
+    for (VkImageView view : probe.mipViews) {
+      vkDestroyImageView(device, view, nullptr);
+    }
+  }
+  for (const auto &views : m_faceViews) {
+    for (VkImageView view : views) {
+      vkDestroyImageView(device, view, nullptr);
+    }
+  }
+  vkDestroyPipelineLayout(device, m_filterLayout, nullptr);
+}
+
+void ReflectionProbeManager::createTargets() {
+  ImageSpecs colorSpecs;
+  colorSpecs.width = PROBE_SIZE;
+  colorSpecs.height = PROBE_SIZE;
+  colorSpecs.format = PROBE_FORMAT;
+  colorSpecs.usage =
+      VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+  colorSpecs.arrayLayers = 6;
+  colorSpecs.viewType = VK_IMAGE_VIEW_TYPE_CUBE;
+  m_captureColor = std::make_unique<Image>(m_context, colorSpecs);
+
+  // The PBR pipeline also writes normals and velocity; nothing reads them
+  ImageSpecs normalSpecs = colorSpecs;
+  normalSpecs.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+  normalSpecs.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+  m_captureNormal = std::make_unique<Image>(m_context, normalSpecs);
+
+  ImageSpecs velocitySpecs = normalSpecs;
+  velocitySpecs.format = VK_FORMAT_R16G16_SFLOAT;
+  m_captureVelocity = std::make_unique<Image>(m_context, velocitySpecs);
+
+  ImageSpecs depthSpecs = normalSpecs;
+  depthSpecs.format = VK_FORMAT_D32_SFLOAT;
+  depthSpecs.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+  depthSpecs.aspectFlags = VK_IMAGE_ASPECT_DEPTH_BIT;
+  m_captureDepth = std::make_unique<Image>(m_context, depthSpecs);
+
+  const Image *targets[] = {m_captureColor.get(), m_captureNormal.get(),
+                            m_captureVelocity.get(), m_captureDepth.get()};
+  for (uint32_t face = 0; face < 6; ++face) {
+    for (uint32_t i = 0; i < 4; ++i) {
+      m_faceViews[face][i] =
+          createView(*targets[i], VK_IMAGE_VIEW_TYPE_2D, face, 1, 0);
+    }
+  }
+}
+
+VkImageView ReflectionProbeManager::createView(const Image &image,
+                                               VkImageViewType type,
+                                               uint32_t baseLayer,
+                                               uint32_t layerCount,
+                                               uint32_t mipLevel) {
+  VkImageViewCreateInfo viewInfo = {VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+  viewInfo.image = image.getHandle();
+  viewInfo.viewType = type;
+  viewInfo.format = image.getSpecs().format;
+  viewInfo.subresourceRange.aspectMask = image.getSpecs().aspectFlags;
+  viewInfo.subresourceRange.baseMipLevel = mipLevel;
+  viewInfo.subresourceRange.levelCount = 1;
+  viewInfo.subresourceRange.baseArrayLayer = baseLayer;
+  viewInfo.subresourceRange.layerCount = layerCount;
+
+  VkImageView view;
+  if (vkCreateImageView(m_context->getDevice(), &viewInfo, nullptr, &view) !=
+      VK_SUCCESS) {
+    throw std::runtime_error("Failed to create reflection probe view!");
+  }
+  return view;
+}
+
+int ReflectionProbeManager::addProbe(const glm::vec3 &position,
+                                     const glm::vec3 &boxMin,
+                                     const glm::vec3 &boxMax,
+                                     float blendDistance) {
+  if (m_probes.size() >= MAX_PROBES) {
+    spdlog::warn("Reflection probe limit ({}) reached.", MAX_PROBES);
+    return -1;
+  }
+
+  const uint32_t index = static_cast<uint32_t>(m_probes.size());
+  Probe probe;
+  probe.gpu.position = glm::vec4(position, static_cast<float>(index));
+  probe.gpu.boxMin = glm::vec4(glm::min(boxMin, boxMax), blendDistance);
+  probe.gpu.boxMax = glm::vec4(glm::max(boxMin, boxMax), 0.0f);
+
+  // The prefilter writes one mip of the probe's six layers at a time
+  auto &descriptors = m_context->getDescriptorManager();
+  for (uint32_t mip = 0; mip < PROBE_MIPS; ++mip) {
+    probe.mipViews[mip] =
+        createView(*m_atlas, VK_IMAGE_VIEW_TYPE_CUBE, index * 6, 6, mip);
+    probe.mipIndices[mip] =
+        descriptors.registerStorageImage(probe.mipViews[mip]);
+  }
+  m_probes.push_back(probe);
+  return static_cast<int>(index);
+}
+
+void ReflectionProbeManager::invalidateAll() {
+  for (Probe &probe : m_probes) {
+    probe.dirty = true;
+  }
+  // Faces captured so far saw the old scene
+  m_captureProbe = -1;
+  m_nextFace = 0;
+}
+
+void ReflectionProbeManager::beginFrame(uint32_t frameIndex,
+                                        const SceneData &sceneData,
+                                        uint32_t stepBudget) {
+  // Probes filtered by an earlier frame; one filtered this frame is only
+  // complete after the main pass has sampled the list
+  std::vector<ReflectionProbe> active;
+  for (const Probe &probe : m_probes) {
+    if (probe.filtered) {
+      active.push_back(probe.gpu);
+    }
+  }
+  m_activeProbeCount = static_cast<uint32_t>(active.size());
+  if (!active.empty()) {
+    m_probeBuffers[frameIndex]->upload(
+        active.data(), active.size() * sizeof(ReflectionProbe));
+  }
+
+  m_faceCaptures.clear();
+  m_filterPending = false;
+  m_targetLayoutsValid = m_targetsWritten;
+
+  stepBudget = std::min(stepBudget, MAX_STEPS_PER_FRAME);
+  for (uint32_t step = 0; step < stepBudget; ++step) {
+    if (m_captureProbe < 0) {
+      // Next dirty probe, round robin so one busy probe cannot starve others
+      for (size_t i = 0; i < m_probes.size(); ++i) {
+        uint32_t candidate = (m_nextProbe + i) % m_probes.size();
+        if (m_probes[candidate].dirty) {
+          m_captureProbe = static_cast<int>(candidate);
+          m_nextProbe = candidate + 1;
+          m_probes[candidate].dirty = false;
+          m_nextFace = 0;
+          break;
+        }
+      }
+      if (m_captureProbe < 0) {
+        break;
+      }
+    }
+
+    if (m_nextFace < 6) {
+      const uint32_t face = m_nextFace++;
+      const uint32_t slot = frameIndex * MAX_STEPS_PER_FRAME + step;
+      const glm::vec3 origin =
+          glm::vec3(m_probes[m_captureProbe].gpu.position);
+
+      SceneData capture = sceneData;
+      capture.view =
+          glm::lookAt(origin, origin + FACE_DIRECTIONS[face], FACE_UPS[face]);
+      capture.proj = glm::perspective(glm::radians(90.0f), 1.0f, CAPTURE_NEAR,
+                                      sceneData.farClip);
+      capture.viewProj = capture.proj * capture.view;
+      capture.invView = glm::inverse(capture.view);
+      capture.invProj = glm::inverse(capture.proj);
+      capture.prevViewProj = capture.viewProj;
+      capture.cameraPos = glm::vec4(origin, 1.0f);
+      capture.jitter = glm::vec2(0.0f);
+      capture.headlampEnabled = 0;
+      capture.visualizeCascades = 0;
+      capture.nearClip = CAPTURE_NEAR;
+      capture.screenWidth = static_cast<float>(PROBE_SIZE);
+      capture.screenHeight = static_cast<float>(PROBE_SIZE);
+      capture.probeCount = 0;
+      capture.probeCapture = 1;
+      m_captureSceneBuffers[slot]->upload(&capture, sizeof(SceneData));
+      m_faceCaptures.push_back({face, m_captureSceneIndices[slot],
+                                m_captureSceneBuffers[slot]->getDeviceAddress()});
+      continue;
+    }
+
+    // The filter reads all six faces, so it ends the frame's captures
+    m_filterPending = true;
+    m_filterProbe = m_captureProbe;
+    m_probes[m_captureProbe].filtered = true;
+    m_captureProbe = -1;
+    break;
+  }
+
+  if (!m_faceCaptures.empty()) {
+    m_targetsWritten = true;
+  }
+}
+
+std::vector<std::string>
+ReflectionProbeManager::addCaptureTargets(RenderGraph &graph,
+                                          uint32_t face) const {
+  const Image *targets[] = {m_captureColor.get(), m_captureNormal.get(),
+                            m_captureVelocity.get(), m_captureDepth.get()};
+  const char *names[] = {"ProbeColor_", "ProbeNormal_", "ProbeVelocity_",
+                         "ProbeDepth_"};
+
+  std::vector<std::string> outputs;
+  for (uint32_t i = 0; i < 4; ++i) {
+    const bool isDepth = targets[i] == m_captureDepth.get();
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (m_targetLayoutsValid) {
+      layout = isDepth ? VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL
+                       : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    }
+
+    std::string name = names[i] + std::to_string(face);
+    graph.addExternalResource(name, targets[i]->getHandle(),
+                              m_faceViews[face][i],
+                              targets[i]->getSpecs().format, PROBE_SIZE,
+                              PROBE_SIZE, layout);
+    if (isDepth) {
+      VkClearValue depthClear;
+      depthClear.depthStencil = {1.0f, 0};
+      graph.setResourceClearValue(name, depthClear);
+    }
+    outputs.push_back(name);
+  }
+  return outputs;
+}
+
+void ReflectionProbeManager::recordFilter(VkCommandBuffer cb) {
+  const Probe &probe = m_probes[m_filterProbe];
+
+  VkImageMemoryBarrier barriers[2] = {};
+  for (auto &barrier : barriers) {
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+  }
+
+  // Captured faces become the filter input
+  barriers[0].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+  barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[0].image = m_captureColor->getHandle();
+  barriers[0].subresourceRange.layerCount = 6;
+
+  // Earlier frames may still sample the probe's previous result
+  barriers[1].srcAccessMask = 0;
+  barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barriers[1].oldLayout = m_atlasInitialized ? VK_IMAGE_LAYOUT_GENERAL
+                                             : VK_IMAGE_LAYOUT_UNDEFINED;
+  barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barriers[1].image = m_atlas->getHandle();
+  barriers[1].subresourceRange.baseArrayLayer =
+      m_atlasInitialized ? m_filterProbe * 6 : 0;
+  barriers[1].subresourceRange.layerCount =
+      m_atlasInitialized ? 6 : VK_REMAINING_ARRAY_LAYERS;
+  m_atlasInitialized = true;
+
+  // Also orders the normal, velocity and depth writes of this probe's faces
+  // before the next probe's
+  VkMemoryBarrier targetBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  targetBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  vkCmdPipelineBarrier(cb,
+                       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                           VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                           VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                       VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1,
+                       &targetBarrier, 0, nullptr, 2, barriers);
+
+  vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                    m_filterPipeline->getHandle());
+  m_context->getDescriptorManager().bind(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                         m_filterLayout);
+
+  for (uint32_t mip = 0; mip < PROBE_MIPS; ++mip) {
+    struct {
+      uint32_t inputIdx;
+      uint32_t outputIdx;
+      float roughness;
+    } pc;
+    pc.inputIdx = m_captureColorIndex;
+    pc.outputIdx = probe.mipIndices[mip];
+    pc.roughness = static_cast<float>(mip) / static_cast<float>(PROBE_MIPS - 1);
+    vkCmdPushConstants(cb, m_filterLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(pc), &pc);
+    const uint32_t groups = std::max(1u, (PROBE_SIZE >> mip) / 16);
+    vkCmdDispatch(cb, groups, groups, 6);
+  }
+
+  // The probe is sampled from the next frame on; the faces are rendered to
+  // again by the next capture
+  barriers[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+  barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+  barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+  barriers[1].srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+  barriers[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+  barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+  barriers[1].subresourceRange.baseArrayLayer = m_filterProbe * 6;
+  barriers[1].subresourceRange.layerCount = 6;
+
+  targetBarrier.srcAccessMask = 0;
+  targetBarrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+  vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                           VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT |
+                           VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
+                       0, 1, &targetBarrier, 0, nullptr, 2, barriers);
+}
+
+} // namespace astral
@@ -1,25 +1,34 @@
 #include "astral/renderer/renderer_system.hpp"
+#include "astral/core/asset_file.hpp"
+#include "astral/core/sampler_cache.hpp"
 #include "astral/renderer/scene_manager.hpp"
 #include "astral/renderer/sync.hpp"
 
 #include <filesystem>
-#include <fstream>
 #include <random>
 #include <spdlog/spdlog.h>
 #include <sstream>
 
 namespace astral {
 
+// Push constants of the PBR, shadow and probe capture pipelines; matches
+// PushConstants in pbr.vert, pbr.frag and shadow.vert. The buffers are read
+// through buffer_reference pointers instead of bindless indices.
+struct DrawPushConstants {
+  VkDeviceAddress scene;
+  VkDeviceAddress instances;
+  VkDeviceAddress materials;
+  VkDeviceAddress lights;
+  uint32_t cascadeIndex; // Shadow passes only
+  uint32_t padding;
+};
+
 RendererSystem::RendererSystem(Context *context, Swapchain *swapchain,
                                uint32_t width, uint32_t height)
     : m_context(context), m_swapchainFormat(swapchain->getImageFormat()),
       m_width(width), m_height(height) {}
 
 RendererSystem::~RendererSystem() {
-  vkDestroySampler(m_context->getDevice(), m_hdrSampler, nullptr);
-  vkDestroySampler(m_context->getDevice(), m_noiseSampler, nullptr);
-  vkDestroySampler(m_context->getDevice(), m_shadowSampler, nullptr);
-
   vkDestroyPipelineLayout(m_context->getDevice(), m_pipelineLayout, nullptr);
   vkDestroyPipelineLayout(m_context->getDevice(), m_taaLayout, nullptr);
   vkDestroyPipelineLayout(m_context->getDevice(), m_ssaoLayout, nullptr);
@@ -28,6 +37,8 @@ RendererSystem::~RendererSystem() {
   vkDestroyPipelineLayout(m_context->getDevice(), m_bloomLayout, nullptr);
   vkDestroyPipelineLayout(m_context->getDevice(), m_fxaaLayout, nullptr);
   vkDestroyPipelineLayout(m_context->getDevice(), m_cullLayout, nullptr);
+  vkDestroyPipelineLayout(m_context->getDevice(), m_meshletCullLayout,
+                          nullptr);
   vkDestroyPipelineLayout(m_context->getDevice(), m_clusterBuildLayout,
                           nullptr);
   vkDestroyPipelineLayout(m_context->getDevice(), m_clusterCullLayout, nullptr);
@@ -35,16 +46,7 @@ RendererSystem::~RendererSystem() {
 }
 
 std::string RendererSystem::readFile(const std::string &filename) {
-  std::ifstream file(filename, std::ios::ate | std::ios::binary);
-  if (!file.is_open()) {
-    throw std::runtime_error("Failed to open file: " + filename);
-  }
-  size_t fileSize = (size_t)file.tellg();
-  std::string buffer;
-  buffer.resize(fileSize);
-  file.seekg(0);
-  file.read(buffer.data(), fileSize);
-  return buffer;
+  return readAssetFile(filename);
 }
 
 void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
@@ -59,8 +61,7 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   hdrSamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
   hdrSamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
   hdrSamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-  vkCreateSampler(m_context->getDevice(), &hdrSamplerInfo, nullptr,
-                  &m_hdrSampler);
+  m_hdrSampler = m_context->getSamplerCache().getSampler(hdrSamplerInfo);
 
   ImageSpecs hdrSpecs;
   hdrSpecs.width = m_width;
@@ -159,8 +160,7 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   noiseSamplerInfo.minFilter = VK_FILTER_NEAREST;
   noiseSamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
   noiseSamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-  vkCreateSampler(m_context->getDevice(), &noiseSamplerInfo, nullptr,
-                  &m_noiseSampler);
+  m_noiseSampler = m_context->getSamplerCache().getSampler(noiseSamplerInfo);
   m_noiseTextureIndex = m_context->getDescriptorManager().registerImage(
       m_resources.noiseImage->getView(), m_noiseSampler);
 
@@ -204,8 +204,8 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   shadowSamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
   shadowSamplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
   shadowSamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-  vkCreateSampler(m_context->getDevice(), &shadowSamplerInfo, nullptr,
-                  &m_shadowSampler);
+  m_shadowSampler =
+      m_context->getSamplerCache().getSampler(shadowSamplerInfo);
   m_shadowMapIndex = m_context->getDescriptorManager().registerImageArray(
       m_resources.shadowImage->getView(), m_shadowSampler);
 
@@ -240,7 +240,7 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
       m_resources.clusterBuffer->getHandle(), 0,
       m_resources.clusterBuffer->getSize(), 8);
 
-  for (int i = 0; i < 2; i++) {
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
     m_resources.clusterGridBuffers.push_back(std::make_unique<Buffer>(
         m_context, totalClusters * sizeof(ClusterGrid),
         VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_AUTO));
@@ -268,59 +268,62 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
 
   spdlog::info("Loading PBR Shaders...");
   m_vertShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/pbr.vert.spv"), ShaderStage::Vertex,
+      m_context, readFile("assets/shaders/pbr.vert"), ShaderStage::Vertex,
       "PBRVert");
   m_fragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/pbr.frag.spv"), ShaderStage::Fragment,
+      m_context, readFile("assets/shaders/pbr.frag"), ShaderStage::Fragment,
       "PBRFrag");
   m_postVertShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/post_process.vert.spv"),
+      m_context, readFile("assets/shaders/post_process.vert"),
       ShaderStage::Vertex, "PostVert");
   m_taaFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/taa.frag.spv"), ShaderStage::Fragment,
+      m_context, readFile("assets/shaders/taa.frag"), ShaderStage::Fragment,
       "TAAFrag");
   m_ssaoFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/ssao.frag.spv"),
+      m_context, readFile("assets/shaders/ssao.frag"),
       ShaderStage::Fragment, "SSAOFrag");
   m_ssaoBlurFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/ssao_blur.frag.spv"),
+      m_context, readFile("assets/shaders/ssao_blur.frag"),
       ShaderStage::Fragment, "SSAOBlurFrag");
   m_compositeFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/composite.frag.spv"),
+      m_context, readFile("assets/shaders/composite.frag"),
       ShaderStage::Fragment, "CompositeFrag");
   m_bloomFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/bloom.frag.spv"),
+      m_context, readFile("assets/shaders/bloom.frag"),
       ShaderStage::Fragment, "BloomFrag");
   m_fxaaFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/fxaa.frag.spv"),
+      m_context, readFile("assets/shaders/fxaa.frag"),
       ShaderStage::Fragment, "FXAAFrag");
   m_shadowVertShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/shadow.vert.spv"),
+      m_context, readFile("assets/shaders/shadow.vert"),
       ShaderStage::Vertex, "ShadowVert");
   m_shadowFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/shadow.frag.spv"),
+      m_context, readFile("assets/shaders/shadow.frag"),
       ShaderStage::Fragment, "ShadowFrag");
   m_cullShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/cull.comp.spv"), ShaderStage::Compute,
+      m_context, readFile("assets/shaders/cull.comp"), ShaderStage::Compute,
       "CullShader");
+  m_meshletCullShader = std::make_shared<Shader>(
+      m_context, readFile("assets/shaders/meshlet_cull.comp"),
+      ShaderStage::Compute, "MeshletCullShader");
   m_clusterBuildShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/cluster_build.comp.spv"),
+      m_context, readFile("assets/shaders/cluster_build.comp"),
       ShaderStage::Compute, "ClusterBuildShader");
   m_clusterCullShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/cluster_cull.comp.spv"),
+      m_context, readFile("assets/shaders/cluster_cull.comp"),
       ShaderStage::Compute, "ClusterCullShader");
   m_skyboxVertShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/skybox.vert.spv"),
+      m_context, readFile("assets/shaders/skybox.vert"),
       ShaderStage::Vertex, "SkyboxVert");
   m_skyboxFragShader = std::make_shared<Shader>(
-      m_context, readFile("assets/shaders/skybox.frag.spv"),
+      m_context, readFile("assets/shaders/skybox.frag"),
       ShaderStage::Fragment, "SkyboxFrag");
 
   VkPushConstantRange pushConstantRange = {};
   pushConstantRange.stageFlags =
       VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
   pushConstantRange.offset = 0;
-  pushConstantRange.size = 16;
+  pushConstantRange.size = sizeof(DrawPushConstants);
 
   VkPipelineLayoutCreateInfo pipelineLayoutInfo = {
       VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
@@ -346,6 +349,19 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   pbrSpecs.vertexAttributes = Vertex::getAttributeDescriptions();
   m_pbrPipeline = std::make_unique<GraphicsPipeline>(m_context, pbrSpecs);
 
+  // Same shaders, quantized vertex input (decoded in pbr.vert)
+  pbrSpecs.vertexBindings = {PackedVertex::getBindingDescription()};
+  pbrSpecs.vertexAttributes = PackedVertex::getAttributeDescriptions();
+  m_pbrPackedPipeline = std::make_unique<GraphicsPipeline>(m_context, pbrSpecs);
+
+  // Probe faces keep the GL-style projection, which flips the winding
+  pbrSpecs.frontFace = VK_FRONT_FACE_CLOCKWISE;
+  m_probePackedPipeline =
+      std::make_unique<GraphicsPipeline>(m_context, pbrSpecs);
+  pbrSpecs.vertexBindings = {Vertex::getBindingDescription()};
+  pbrSpecs.vertexAttributes = Vertex::getAttributeDescriptions();
+  m_probePipeline = std::make_unique<GraphicsPipeline>(m_context, pbrSpecs);
+
   PipelineSpecs shadowSpecsP;
   shadowSpecsP.vertexShader = m_shadowVertShader;
   shadowSpecsP.fragmentShader = m_shadowFragShader;
@@ -365,6 +381,13 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   m_shadowPipeline =
       std::make_unique<GraphicsPipeline>(m_context, shadowSpecsP);
 
+  shadowSpecsP.vertexBindings = {PackedVertex::getBindingDescription()};
+  shadowVertexAttrs[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+  shadowVertexAttrs[0].offset = offsetof(PackedVertex, position);
+  shadowSpecsP.vertexAttributes = shadowVertexAttrs;
+  m_shadowPackedPipeline =
+      std::make_unique<GraphicsPipeline>(m_context, shadowSpecsP);
+
   VkPushConstantRange taaPushRange = {};
   taaPushRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
   taaPushRange.size = 16;
@@ -495,7 +518,7 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
 
   VkPushConstantRange cullPush = {};
   cullPush.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
-  cullPush.size = 16;
+  cullPush.size = 32;
   VkPipelineLayoutCreateInfo cullLayoutInfo = {
       VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
   cullLayoutInfo.pushConstantRangeCount = 1;
@@ -509,6 +532,23 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   cullSpecs.layout = m_cullLayout;
   m_cullPipeline = std::make_unique<ComputePipeline>(m_context, cullSpecs);
 
+  VkPushConstantRange meshletCullPush = {};
+  meshletCullPush.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+  meshletCullPush.size = 40;
+  VkPipelineLayoutCreateInfo meshletCullLayoutInfo = {
+      VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+  meshletCullLayoutInfo.pushConstantRangeCount = 1;
+  meshletCullLayoutInfo.pPushConstantRanges = &meshletCullPush;
+  meshletCullLayoutInfo.setLayoutCount = layoutCount;
+  meshletCullLayoutInfo.pSetLayouts = setLayouts;
+  vkCreatePipelineLayout(m_context->getDevice(), &meshletCullLayoutInfo,
+                         nullptr, &m_meshletCullLayout);
+  ComputePipelineSpecs meshletCullSpecs;
+  meshletCullSpecs.computeShader = m_meshletCullShader;
+  meshletCullSpecs.layout = m_meshletCullLayout;
+  m_meshletCullPipeline =
+      std::make_unique<ComputePipeline>(m_context, meshletCullSpecs);
+
   VkPushConstantRange cbPush = {};
   cbPush.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
   cbPush.size = 96;
@@ -569,6 +609,8 @@ void RendererSystem::initializePipelines(VkDescriptorSetLayout *setLayouts,
   skySpecs.cullMode = VK_CULL_MODE_NONE;
   m_skyboxPipeline = std::make_unique<GraphicsPipeline>(m_context, skySpecs);
 
+  m_probes = std::make_unique<ReflectionProbeManager>(m_context);
+
   spdlog::info("Renderer System Initialized.");
 }
 
@@ -576,8 +618,7 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
                             SceneManager &sceneManager, uint32_t currentFrame,
                             uint32_t imageIndex, const SceneData &sceneData,
                             Swapchain *swapchain, FrameSync *sync,
-                            const UIParams &uiParams, const Model *model,
-                            uint32_t skyboxIndex) {
+                            const UIParams &uiParams, uint32_t skyboxIndex) {
 
   SceneData sd = sceneData;
   sd.shadowMapIndex = m_shadowMapIndex;
@@ -594,6 +635,13 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
   sd.headlampEnabled = uiParams.enableHeadlamp ? 1 : 0;
   sd.visualizeCascades = uiParams.visualizeCascades ? 1 : 0;
 
+  m_probes->beginFrame(currentFrame, sd,
+                       static_cast<uint32_t>(uiParams.probeFacesPerFrame));
+  sd.probeBufferIndex = m_probes->getProbeBufferIndex(currentFrame);
+  sd.probeCount = m_probes->getActiveProbeCount();
+  sd.probeAtlasIndex = m_probes->getAtlasIndex();
+  sd.probeCapture = 0;
+
   sceneManager.updateSceneData(currentFrame, sd);
 
   VkExtent2D ext = swapchain->getExtent();
@@ -643,42 +691,116 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
                             m_resources.shadowImage->getSpecs().format, 4096,
                             4096, VK_IMAGE_LAYOUT_UNDEFINED);
 
-  graph.addPass("CullingPass", {}, {}, [this, &sceneManager, currentFrame](VkCommandBuffer cb) {
+  const float lodErrorThreshold = uiParams.lodErrorThreshold;
+  graph.addPass("CullingPass", {}, {}, [this, &sceneManager, currentFrame, lodErrorThreshold](VkCommandBuffer cb) {
+    uint32_t instanceCount =
+        static_cast<uint32_t>(sceneManager.getMeshInstanceCount(currentFrame));
+    VkBuffer meshletDrawBuffer = sceneManager.getMeshletDrawBuffer(currentFrame);
+    VkBuffer meshletCountBuffer =
+        sceneManager.getMeshletCountBuffer(currentFrame);
+
+    // Reset the compacted draw counts before the cluster cull appends to them
+    vkCmdFillBuffer(cb, meshletCountBuffer, 0, VK_WHOLE_SIZE, 0);
+    VkBufferMemoryBarrier resetBarrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
+    resetBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    resetBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+    resetBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    resetBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    resetBarrier.buffer = meshletCountBuffer;
+    resetBarrier.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 1,
+                         &resetBarrier, 0, nullptr);
+
     vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
                       m_cullPipeline->getHandle());
-    VkDescriptorSet globalSet =
-        m_context->getDescriptorManager().getDescriptorSet();
-    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE, m_cullLayout, 0,
-                            1, &globalSet, 0, nullptr);
+    m_context->getDescriptorManager().bind(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                           m_cullLayout);
 
     struct CullPushConstants {
-      uint32_t sceneDataIndex;
-      uint32_t instanceBufferIndex;
+      VkDeviceAddress scene;
+      VkDeviceAddress instances;
       uint32_t indirectBufferIndex;
       uint32_t instanceCount;
-    } cpc;
-    cpc.sceneDataIndex = sceneManager.getSceneBufferIndex(currentFrame);
-    cpc.instanceBufferIndex =
-        sceneManager.getMeshInstanceBufferIndex(currentFrame);
+      float lodErrorThreshold;
+      uint32_t padding;
+    } cpc = {};
+    cpc.scene = sceneManager.getSceneBufferAddress(currentFrame);
+    cpc.instances = sceneManager.getMeshInstanceBufferAddress(currentFrame);
     cpc.indirectBufferIndex = sceneManager.getIndirectBufferIndex(currentFrame);
-    cpc.instanceCount =
-        static_cast<uint32_t>(sceneManager.getMeshInstanceCount(currentFrame));
+    cpc.instanceCount = instanceCount;
+    cpc.lodErrorThreshold = lodErrorThreshold;
 
     vkCmdPushConstants(cb, m_cullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
                        sizeof(CullPushConstants), &cpc);
     uint32_t groupCount = (cpc.instanceCount + 63) / 64;
-    // vkCmdDispatch(cb, groupCount, 1, 1); // DEBUG: Disabled culling dispatch
-    
+    // Writes the LOD range of every command, so it always runs
+    if (groupCount > 0) {
+      vkCmdDispatch(cb, groupCount, 1, 1);
+    }
+
+    // Per-instance commands feed the shadow pass and the cluster cull
     VkBufferMemoryBarrier barrier = {VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER};
     barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
     barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+    barrier.dstAccessMask =
+        VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
     barrier.buffer = sceneManager.getIndirectBuffer(currentFrame);
     barrier.offset = 0;
     barrier.size = VK_WHOLE_SIZE;
     vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
-                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 1,
-                         &barrier, 0, nullptr);
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+                             VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+    // Cluster cull: one workgroup per instance, compacted main view draws
+    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                      m_meshletCullPipeline->getHandle());
+    m_context->getDescriptorManager().bind(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                           m_meshletCullLayout);
+
+    struct MeshletCullPushConstants {
+      VkDeviceAddress scene;
+      VkDeviceAddress instances;
+      uint32_t indirectBufferIndex;
+      uint32_t drawBufferIndex;
+      uint32_t drawCountBufferIndex;
+      uint32_t meshletBufferIndex;
+      uint32_t maxDraws;
+      uint32_t padding;
+    } mpc = {};
+    mpc.scene = cpc.scene;
+    mpc.instances = cpc.instances;
+    mpc.indirectBufferIndex = cpc.indirectBufferIndex;
+    mpc.drawBufferIndex = sceneManager.getMeshletDrawBufferIndex(currentFrame);
+    mpc.drawCountBufferIndex =
+        sceneManager.getMeshletCountBufferIndex(currentFrame);
+    mpc.meshletBufferIndex =
+        sceneManager.getGeometryPool().getMeshletBufferIndex();
+    mpc.maxDraws = SceneManager::MAX_MESHLET_DRAWS;
+
+    vkCmdPushConstants(cb, m_meshletCullLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0,
+                       sizeof(MeshletCullPushConstants), &mpc);
+    if (instanceCount > 0) {
+      vkCmdDispatch(cb, instanceCount, 1, 1);
+    }
+
+    VkBufferMemoryBarrier drawBarriers[2] = {};
+    for (auto &drawBarrier : drawBarriers) {
+      drawBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+      drawBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+      drawBarrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+      drawBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      drawBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      drawBarrier.size = VK_WHOLE_SIZE;
+    }
+    drawBarriers[0].buffer = meshletDrawBuffer;
+    drawBarriers[1].buffer = meshletCountBuffer;
+    vkCmdPipelineBarrier(cb, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 0, nullptr, 2,
+                         drawBarriers, 0, nullptr);
   });
 
   if (!m_clustersBuilt) {
@@ -700,10 +822,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
         vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
                           m_clusterBuildPipeline->getHandle());
-        VkDescriptorSet globalSet =
-            m_context->getDescriptorManager().getDescriptorSet();
-        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
-                                m_clusterBuildLayout, 0, 1, &globalSet, 0, nullptr);
+        m_context->getDescriptorManager().bind(
+            cb, VK_PIPELINE_BIND_POINT_COMPUTE, m_clusterBuildLayout);
 
         struct {
           uint32_t cbIdx;
@@ -746,10 +866,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
     vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
                       m_clusterCullPipeline->getHandle());
-    VkDescriptorSet globalSet =
-        m_context->getDescriptorManager().getDescriptorSet();
-    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
-                            m_clusterCullLayout, 0, 1, &globalSet, 0, nullptr);
+    m_context->getDescriptorManager().bind(cb, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                           m_clusterCullLayout);
 
     struct {
       uint32_t cbIdx, cgbIdx, libIdx, lbIdx, abIdx, lc;
@@ -786,44 +904,49 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
     graph.setResourceClearValue(resName, shadowClear);
 
     graph.addPass("ShadowPass_" + std::to_string(i), {}, {resName},
-                  [this, &sceneManager, currentFrame, i, model](VkCommandBuffer cb) {
-                    vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                      m_shadowPipeline->getHandle());
-                    VkDescriptorSet globalSet =
-                        m_context->getDescriptorManager().getDescriptorSet();
-                    vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                            m_pipelineLayout, 0, 1, &globalSet,
-                                            0, nullptr);
-
+                  [this, &sceneManager, currentFrame, i](VkCommandBuffer cb) {
                     VkViewport viewport = {0, 0, 4096, 4096, 0, 1};
                     vkCmdSetViewport(cb, 0, 1, &viewport);
                     VkRect2D scissor = {{0, 0}, {4096, 4096}};
                     vkCmdSetScissor(cb, 0, 1, &scissor);
 
-                    if (model) {
+                    DrawPushConstants spc = {};
+                    spc.scene =
+                        sceneManager.getSceneBufferAddress(currentFrame);
+                    spc.instances =
+                        sceneManager.getMeshInstanceBufferAddress(currentFrame);
+                    spc.materials = sceneManager.getMaterialBufferAddress();
+                    spc.lights =
+                        sceneManager.getLightBufferAddress(currentFrame);
+                    spc.cascadeIndex = i;
+
+                    GeometryPool &geometryPool = sceneManager.getGeometryPool();
+                    for (const auto &batch :
+                         sceneManager.getDrawBatches(currentFrame)) {
+                      bool packed = batch.vertexFormat == VertexFormat::Packed;
+                      vkCmdBindPipeline(
+                          cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                          packed ? m_shadowPackedPipeline->getHandle()
+                                 : m_shadowPipeline->getHandle());
+                      m_context->getDescriptorManager().bind(
+                          cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout);
+
                       VkDeviceSize offsets[] = {0};
-                      VkBuffer vBuffer = model->vertexBuffer->getHandle();
+                      VkBuffer vBuffer =
+                          geometryPool.getVertexBuffer(batch.vertexFormat);
                       vkCmdBindVertexBuffers(cb, 0, 1, &vBuffer, offsets);
-                      vkCmdBindIndexBuffer(cb, model->indexBuffer->getHandle(),
-                                           0, VK_INDEX_TYPE_UINT32);
-
-                      struct {
-                        uint32_t sIdx, iIdx, mIdx, cIdx;
-                      } spc;
-                      spc.sIdx = sceneManager.getSceneBufferIndex(currentFrame);
-                      spc.iIdx =
-                          sceneManager.getMeshInstanceBufferIndex(currentFrame);
-                      spc.mIdx = sceneManager.getMaterialBufferIndex();
-                      spc.cIdx = i;
+                      vkCmdBindIndexBuffer(cb, geometryPool.getIndexBuffer(), 0,
+                                           VK_INDEX_TYPE_UINT32);
 
                       vkCmdPushConstants(cb, m_pipelineLayout,
                                          VK_SHADER_STAGE_VERTEX_BIT |
                                              VK_SHADER_STAGE_FRAGMENT_BIT,
                                          0, sizeof(spc), &spc);
                       vkCmdDrawIndexedIndirect(
-                          cb, sceneManager.getIndirectBuffer(currentFrame), 0,
-                          static_cast<uint32_t>(
-                              sceneManager.getMeshInstanceCount(currentFrame)),
+                          cb, sceneManager.getIndirectBuffer(currentFrame),
+                          batch.firstCommand *
+                              sizeof(VkDrawIndexedIndirectCommand),
+                          batch.commandCount,
                           sizeof(VkDrawIndexedIndirectCommand));
                     }
                   });
@@ -877,7 +1000,7 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
   // Geometry Pass
   graph.addPass(
       "GeometryPass", {}, {"HDR_Color", "Normal", "Velocity", "Depth"},
-      [this, &sceneManager, currentFrame, ext, uiParams, skyboxIndex, model](VkCommandBuffer cb) {
+      [this, &sceneManager, currentFrame, ext, uiParams, skyboxIndex](VkCommandBuffer cb) {
         VkViewport viewport = {0.0f, 0.0f, (float)ext.width, (float)ext.height, 0.0f, 1.0f};
         vkCmdSetViewport(cb, 0, 1, &viewport);
         VkRect2D scissor = {{0, 0}, {ext.width, ext.height}};
@@ -886,10 +1009,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
         if (uiParams.showSkybox) {
           vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             m_skyboxPipeline->getHandle());
-          VkDescriptorSet globalSet =
-              m_context->getDescriptorManager().getDescriptorSet();
-          vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                  m_skyboxLayout, 0, 1, &globalSet, 0, nullptr);
+          m_context->getDescriptorManager().bind(
+              cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_skyboxLayout);
           struct {
             uint32_t sIdx, skIdx;
           } skySPC;
@@ -902,40 +1023,121 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
           vkCmdDraw(cb, 36, 1, 0, 0); 
         }
 
-        vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                          m_pbrPipeline->getHandle());
-        VkDescriptorSet globalSet =
-            m_context->getDescriptorManager().getDescriptorSet();
-        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                m_pipelineLayout, 0, 1, &globalSet, 0, nullptr);
+        DrawPushConstants pbrSPC = {};
+        pbrSPC.scene = sceneManager.getSceneBufferAddress(currentFrame);
+        pbrSPC.instances =
+            sceneManager.getMeshInstanceBufferAddress(currentFrame);
+        pbrSPC.materials = sceneManager.getMaterialBufferAddress();
+        pbrSPC.lights = sceneManager.getLightBufferAddress(currentFrame);
+
+        // One bind + one indirect draw per vertex format
+        GeometryPool &geometryPool = sceneManager.getGeometryPool();
+        for (const auto &batch : sceneManager.getDrawBatches(currentFrame)) {
+          bool packed = batch.vertexFormat == VertexFormat::Packed;
+          vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                            packed ? m_pbrPackedPipeline->getHandle()
+                                   : m_pbrPipeline->getHandle());
+          m_context->getDescriptorManager().bind(
+              cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout);
 
-        if (model) {
           VkDeviceSize offsets[] = {0};
-          VkBuffer vBuffer = model->vertexBuffer->getHandle();
+          VkBuffer vBuffer = geometryPool.getVertexBuffer(batch.vertexFormat);
           vkCmdBindVertexBuffers(cb, 0, 1, &vBuffer, offsets);
-          vkCmdBindIndexBuffer(cb, model->indexBuffer->getHandle(), 0,
+          vkCmdBindIndexBuffer(cb, geometryPool.getIndexBuffer(), 0,
                                VK_INDEX_TYPE_UINT32);
 
-          struct {
-            uint32_t sIdx, iIdx, mIdx, pad;
-          } pbrSPC;
-          pbrSPC.sIdx = sceneManager.getSceneBufferIndex(currentFrame);
-          pbrSPC.iIdx = sceneManager.getMeshInstanceBufferIndex(currentFrame);
-          pbrSPC.mIdx = sceneManager.getMaterialBufferIndex();
-
           vkCmdPushConstants(cb, m_pipelineLayout,
                              VK_SHADER_STAGE_VERTEX_BIT |
                                  VK_SHADER_STAGE_FRAGMENT_BIT,
-                             0, 16, &pbrSPC);
-
-          vkCmdDrawIndexedIndirect(
-             cb, sceneManager.getIndirectBuffer(currentFrame), 0,
-             static_cast<uint32_t>(
-                 sceneManager.getMeshInstanceCount(currentFrame)),
-             sizeof(VkDrawIndexedIndirectCommand));
+                             0, sizeof(pbrSPC), &pbrSPC);
+
+          // Cluster culled draws, compacted per vertex format on the GPU
+          uint32_t format = static_cast<uint32_t>(batch.vertexFormat);
+          vkCmdDrawIndexedIndirectCount(
+              cb, sceneManager.getMeshletDrawBuffer(currentFrame),
+              static_cast<VkDeviceSize>(format) *
+                  SceneManager::MAX_MESHLET_DRAWS *
+                  sizeof(VkDrawIndexedIndirectCommand),
+              sceneManager.getMeshletCountBuffer(currentFrame),
+              format * sizeof(uint32_t), SceneManager::MAX_MESHLET_DRAWS,
+              sizeof(VkDrawIndexedIndirectCommand));
         }
       });
 
+  // Reflection probe faces scheduled for this frame, through the PBR path.
+  // The main pass's meshlet culling is camera dependent, so these draw every
+  // instance from the per-instance indirect buffer like the shadow passes.
+  for (const auto &capture : m_probes->getFaceCaptures()) {
+    std::string face = std::to_string(capture.face);
+    graph.addPass(
+        "ProbeCapturePass_" + face, {},
+        m_probes->addCaptureTargets(graph, capture.face),
+        [this, &sceneManager, currentFrame, uiParams, skyboxIndex,
+         capture](VkCommandBuffer cb) {
+          const float size = (float)ReflectionProbeManager::PROBE_SIZE;
+          VkViewport viewport = {0.0f, 0.0f, size, size, 0.0f, 1.0f};
+          vkCmdSetViewport(cb, 0, 1, &viewport);
+          VkRect2D scissor = {{0, 0},
+                              {ReflectionProbeManager::PROBE_SIZE,
+                               ReflectionProbeManager::PROBE_SIZE}};
+          vkCmdSetScissor(cb, 0, 1, &scissor);
+
+          if (uiParams.showSkybox && skyboxIndex != (uint32_t)-1) {
+            vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              m_skyboxPipeline->getHandle());
+            m_context->getDescriptorManager().bind(
+                cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_skyboxLayout);
+            struct {
+              uint32_t sIdx, skIdx;
+            } skySPC;
+            skySPC.sIdx = capture.sceneBufferIndex;
+            skySPC.skIdx = skyboxIndex;
+            vkCmdPushConstants(cb, m_skyboxLayout,
+                               VK_SHADER_STAGE_VERTEX_BIT |
+                                   VK_SHADER_STAGE_FRAGMENT_BIT,
+                               0, 8, &skySPC);
+            vkCmdDraw(cb, 36, 1, 0, 0);
+          }
+
+          DrawPushConstants pbrSPC = {};
+          pbrSPC.scene = capture.sceneBufferAddress;
+          pbrSPC.instances =
+              sceneManager.getMeshInstanceBufferAddress(currentFrame);
+          pbrSPC.materials = sceneManager.getMaterialBufferAddress();
+          pbrSPC.lights = sceneManager.getLightBufferAddress(currentFrame);
+
+          GeometryPool &geometryPool = sceneManager.getGeometryPool();
+          for (const auto &batch : sceneManager.getDrawBatches(currentFrame)) {
+            bool packed = batch.vertexFormat == VertexFormat::Packed;
+            vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
+                              packed ? m_probePackedPipeline->getHandle()
+                                     : m_probePipeline->getHandle());
+            m_context->getDescriptorManager().bind(
+                cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout);
+
+            VkDeviceSize offsets[] = {0};
+            VkBuffer vBuffer = geometryPool.getVertexBuffer(batch.vertexFormat);
+            vkCmdBindVertexBuffers(cb, 0, 1, &vBuffer, offsets);
+            vkCmdBindIndexBuffer(cb, geometryPool.getIndexBuffer(), 0,
+                                 VK_INDEX_TYPE_UINT32);
+
+            vkCmdPushConstants(cb, m_pipelineLayout,
+                               VK_SHADER_STAGE_VERTEX_BIT |
+                                   VK_SHADER_STAGE_FRAGMENT_BIT,
+                               0, sizeof(pbrSPC), &pbrSPC);
+            vkCmdDrawIndexedIndirect(
+                cb, sceneManager.getIndirectBuffer(currentFrame),
+                batch.firstCommand * sizeof(VkDrawIndexedIndirectCommand),
+                batch.commandCount, sizeof(VkDrawIndexedIndirectCommand));
+          }
+        });
+  }
+
+  if (m_probes->isFilterPending()) {
+    graph.addPass("ProbeFilterPass", {}, {},
+                  [this](VkCommandBuffer cb) { m_probes->recordFilter(cb); });
+  }
+
   if (uiParams.enableSSAO) {
     graph.addPass(
         "SSAOPass", {"Normal", "Depth"}, {"SSAO_Base"},
@@ -947,10 +1149,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
           vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             m_ssaoPipeline->getHandle());
-          VkDescriptorSet globalSet =
-              m_context->getDescriptorManager().getDescriptorSet();
-          vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                  m_ssaoLayout, 0, 1, &globalSet, 0, nullptr);
+          m_context->getDescriptorManager().bind(
+              cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ssaoLayout);
           struct {
             uint32_t nI, dI, nsI, kI;
             float r, b;
@@ -974,11 +1174,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
           vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             m_ssaoBlurPipeline->getHandle());
-          VkDescriptorSet globalSet =
-              m_context->getDescriptorManager().getDescriptorSet();
-          vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                  m_ssaoBlurLayout, 0, 1, &globalSet, 0,
-                                  nullptr);
+          m_context->getDescriptorManager().bind(
+              cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ssaoBlurLayout);
           int mode = 0; // vertical/horizontal? Or just single pass? No, just push const size=4.
           vkCmdPushConstants(cb, m_ssaoBlurLayout, VK_SHADER_STAGE_FRAGMENT_BIT,
                              0, 4, &mode);
@@ -996,10 +1193,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
         vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                           m_bloomPipeline->getHandle());
-        VkDescriptorSet set =
-            m_context->getDescriptorManager().getDescriptorSet();
-        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                m_bloomLayout, 0, 1, &set, 0, nullptr);
+        m_context->getDescriptorManager().bind(
+            cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_bloomLayout);
         struct {
           uint32_t idx;
           uint32_t mode;
@@ -1022,10 +1217,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
         vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                           m_bloomPipeline->getHandle());
-        VkDescriptorSet set =
-            m_context->getDescriptorManager().getDescriptorSet();
-        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                m_bloomLayout, 0, 1, &set, 0, nullptr);
+        m_context->getDescriptorManager().bind(
+            cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_bloomLayout);
         struct {
           uint32_t idx;
           uint32_t mode;
@@ -1051,10 +1244,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
         vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                           m_compositePipeline->getHandle());
-        VkDescriptorSet set =
-            m_context->getDescriptorManager().getDescriptorSet();
-        vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                m_compositeLayout, 0, 1, &set, 0, nullptr);
+        m_context->getDescriptorManager().bind(
+            cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_compositeLayout);
         struct {
           uint32_t h, b, s;
           float exp, bs;
@@ -1113,10 +1304,8 @@ void RendererSystem::render(CommandBuffer &cmd, RenderGraph &graph,
 
           vkCmdBindPipeline(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
                             m_fxaaPipeline->getHandle());
-          VkDescriptorSet set =
-              m_context->getDescriptorManager().getDescriptorSet();
-          vkCmdBindDescriptorSets(cb, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                  m_fxaaLayout, 0, 1, &set, 0, nullptr);
+          m_context->getDescriptorManager().bind(
+              cb, VK_PIPELINE_BIND_POINT_GRAPHICS, m_fxaaLayout);
           struct {
             int32_t inputTextureIndex;
             int32_t padding;
@@ -1,6 +1,7 @@
 #include "astral/renderer/scene_manager.hpp"
 #include "astral/renderer/descriptor_manager.hpp"
 #include <spdlog/spdlog.h>
+#include <algorithm>
 #include <stdexcept>
 
 namespace astral {
@@ -13,15 +14,23 @@ SceneManager::SceneManager(Context *context) : m_context(context) {
   m_meshInstanceBuffers.resize(MAX_FRAMES_IN_FLIGHT);
   m_indirectBuffers.resize(MAX_FRAMES_IN_FLIGHT);
   m_lightBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+  m_meshletDrawBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+  m_meshletCountBuffers.resize(MAX_FRAMES_IN_FLIGHT);
 
   m_sceneBufferIndices.resize(MAX_FRAMES_IN_FLIGHT);
   m_meshInstanceBufferIndices.resize(MAX_FRAMES_IN_FLIGHT);
   m_indirectBufferIndices.resize(MAX_FRAMES_IN_FLIGHT);
   m_lightBufferIndices.resize(MAX_FRAMES_IN_FLIGHT);
+  m_meshletDrawBufferIndices.resize(MAX_FRAMES_IN_FLIGHT);
+  m_meshletCountBufferIndices.resize(MAX_FRAMES_IN_FLIGHT);
 
   m_meshInstancesPerFrame.resize(MAX_FRAMES_IN_FLIGHT);
+  m_indirectCommandsPerFrame.resize(MAX_FRAMES_IN_FLIGHT);
+  m_drawBatchesPerFrame.resize(MAX_FRAMES_IN_FLIGHT);
 
-  for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+  m_geometryPool = std::make_unique<GeometryPool>(m_context);
+
+  for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
     // Scene Data Buffer
     m_sceneBuffers[i] = std::make_unique<Buffer>(
         m_context, sizeof(SceneData), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
@@ -56,7 +65,31 @@ SceneManager::SceneManager(Context *context) : m_context(context) {
         sizeof(VkDrawIndexedIndirectCommand) * MAX_MESH_INSTANCES,
         7); // Binding 7
 
+    // Cluster cull output, written and consumed on the GPU only
+    constexpr uint32_t formatCount = 2;
+    VkDeviceSize meshletDrawSize = sizeof(VkDrawIndexedIndirectCommand) *
+                                   MAX_MESHLET_DRAWS * formatCount;
+    m_meshletDrawBuffers[i] = std::make_unique<Buffer>(
+        m_context, meshletDrawSize,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY);
+    m_meshletDrawBufferIndices[i] = descriptorManager.registerBuffer(
+        m_meshletDrawBuffers[i]->getHandle(), 0, meshletDrawSize,
+        7); // Binding 7
+
+    m_meshletCountBuffers[i] = std::make_unique<Buffer>(
+        m_context, sizeof(uint32_t) * formatCount,
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+            VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        VMA_MEMORY_USAGE_GPU_ONLY);
+    m_meshletCountBufferIndices[i] = descriptorManager.registerBuffer(
+        m_meshletCountBuffers[i]->getHandle(), 0,
+        sizeof(uint32_t) * formatCount, 11); // Binding 11
+
     m_meshInstancesPerFrame[i].reserve(MAX_MESH_INSTANCES);
+    m_indirectCommandsPerFrame[i].reserve(MAX_MESH_INSTANCES);
   }
 
   // Material Metadata Buffer (Static/Shared)
@@ -75,7 +108,10 @@ void SceneManager::addMeshInstance(uint32_t frameIndex,
                                    const glm::mat4 &transform,
                                    uint32_t materialIndex, uint32_t indexCount,
                                    uint32_t firstIndex, int vertexOffset,
-                                   const glm::vec3 &center, float radius) {
+                                   const glm::vec3 &center, float radius,
+                                   VertexFormat vertexFormat,
+                                   const glm::vec3 &positionOffset,
+                                   const glm::vec3 &positionScale) {
   auto &instances = m_meshInstancesPerFrame[frameIndex];
   if (instances.size() >= MAX_MESH_INSTANCES) {
     spdlog::warn("Maximum mesh instances reached for frame {}!", frameIndex);
@@ -87,32 +123,132 @@ void SceneManager::addMeshInstance(uint32_t frameIndex,
   instance.sphereCenter = center;
   instance.sphereRadius = radius;
   instance.materialIndex = materialIndex;
+  instance.vertexFormat = static_cast<uint32_t>(vertexFormat);
+  instance.positionOffset = glm::vec4(positionOffset, 0.0f);
+  instance.positionScale = glm::vec4(positionScale, 0.0f);
+  instance.lodCount = 1;
+  instance.lodFirstIndex = glm::uvec4(firstIndex);
+  instance.lodIndexCount = glm::uvec4(indexCount);
   instances.push_back(instance);
 
-  // Upload instance data to current frame's buffer
-  m_meshInstanceBuffers[frameIndex]->upload(&instance, sizeof(MeshInstance),
-                                            sizeof(MeshInstance) *
-                                                (instances.size() - 1));
-
   VkDrawIndexedIndirectCommand cmd = {};
   cmd.indexCount = indexCount;
   cmd.instanceCount = 1; // Initially visible
   cmd.firstIndex = firstIndex;
   cmd.vertexOffset = vertexOffset;
-  cmd.firstInstance = static_cast<uint32_t>(instances.size() - 1);
+  m_indirectCommandsPerFrame[frameIndex].push_back(cmd);
+}
 
-  // Upload indirect command to current frame's buffer
-  m_indirectBuffers[frameIndex]->upload(
-      &cmd, sizeof(VkDrawIndexedIndirectCommand),
-      sizeof(VkDrawIndexedIndirectCommand) * (instances.size() - 1));
+void SceneManager::addMeshInstance(uint32_t frameIndex, const Model &model,
+                                   const Primitive &primitive,
+                                   const glm::mat4 &transform) {
+  auto &instances = m_meshInstancesPerFrame[frameIndex];
+  const size_t instanceCount = instances.size();
+  addMeshInstance(frameIndex, transform,
+                  static_cast<uint32_t>(primitive.materialIndex),
+                  primitive.indexCount,
+                  model.geometry.firstIndex + primitive.firstIndex,
+                  static_cast<int>(model.geometry.vertexOffset),
+                  primitive.boundingCenter, primitive.boundingRadius,
+                  model.vertexFormat, primitive.quantOffset,
+                  primitive.quantScale);
+  if (instances.size() == instanceCount) {
+    return;
+  }
+
+  MeshInstance &instance = instances.back();
+  instance.firstMeshlet = model.geometry.firstMeshlet + primitive.firstMeshlet;
+  instance.meshletCount = primitive.meshletCount;
+  if (primitive.lodCount <= 1) {
+    return;
+  }
+
+  // Unused slots repeat the coarsest level
+  instance.lodCount = primitive.lodCount;
+  for (uint32_t i = 0; i < MAX_PRIMITIVE_LODS; ++i) {
+    const PrimitiveLod &lod = primitive.lods[std::min(i, primitive.lodCount - 1)];
+    instance.lodFirstIndex[i] = model.geometry.firstIndex + lod.firstIndex;
+    instance.lodIndexCount[i] = lod.indexCount;
+    instance.lodError[i] = lod.error;
+  }
+}
+
+void SceneManager::addModelInstances(uint32_t frameIndex, const Model &model,
+                                     const glm::mat4 &transform) {
+  for (const Model::Node *node : model.linearNodes) {
+    if (node->meshIndex < 0 ||
+        static_cast<size_t>(node->meshIndex) >= model.meshes.size()) {
+      continue;
+    }
+
+    glm::mat4 nodeTransform = transform * node->worldMatrix;
+    for (const auto &primitive : model.meshes[node->meshIndex].primitives) {
+      addMeshInstance(frameIndex, model, primitive, nodeTransform);
+    }
+  }
+}
+
+void SceneManager::addModel(std::shared_ptr<Model> model) {
+  if (model) {
+    m_models.push_back(std::move(model));
+  }
+}
+
+void SceneManager::removeModel(const Model *model) {
+  // Pool ranges are freed with the last reference, deferred past in-flight frames
+  m_models.erase(std::remove_if(m_models.begin(), m_models.end(),
+                                [model](const std::shared_ptr<Model> &entry) {
+                                  return entry.get() == model;
+                                }),
+                 m_models.end());
 }
 
 void SceneManager::clearMeshInstances(uint32_t frameIndex) {
   m_meshInstancesPerFrame[frameIndex].clear();
+  m_indirectCommandsPerFrame[frameIndex].clear();
+  m_drawBatchesPerFrame[frameIndex].clear();
 }
 
-void SceneManager::prepareIndirectCommands() {
-  // Already handled in addMeshInstance
+void SceneManager::prepareIndirectCommands(uint32_t frameIndex) {
+  auto &instances = m_meshInstancesPerFrame[frameIndex];
+  auto &commands = m_indirectCommandsPerFrame[frameIndex];
+  auto &batches = m_drawBatchesPerFrame[frameIndex];
+  batches.clear();
+  if (instances.empty()) {
+    return;
+  }
+
+  // Counting sort by vertex format so every format is one contiguous range
+  constexpr uint32_t formatCount = 2;
+  uint32_t counts[formatCount] = {};
+  for (const auto &instance : instances) {
+    counts[instance.vertexFormat]++;
+  }
+
+  uint32_t offsets[formatCount] = {};
+  for (uint32_t f = 0, offset = 0; f < formatCount; ++f) {
+    offsets[f] = offset;
+    if (counts[f] > 0) {
+      batches.push_back({static_cast<VertexFormat>(f), offset, counts[f]});
+    }
+    offset += counts[f];
+  }
+
+  std::vector<MeshInstance> sortedInstances(instances.size());
+  std::vector<VkDrawIndexedIndirectCommand> sortedCommands(commands.size());
+  for (size_t i = 0; i < instances.size(); ++i) {
+    uint32_t dst = offsets[instances[i].vertexFormat]++;
+    sortedInstances[dst] = instances[i];
+    sortedCommands[dst] = commands[i];
+    sortedCommands[dst].firstInstance = dst;
+  }
+  instances.swap(sortedInstances);
+  commands.swap(sortedCommands);
+
+  m_meshInstanceBuffers[frameIndex]->upload(
+      instances.data(), sizeof(MeshInstance) * instances.size());
+  m_indirectBuffers[frameIndex]->upload(
+      commands.data(), sizeof(VkDrawIndexedIndirectCommand) * commands.size());
 }
 
 void SceneManager::updateSceneData(uint32_t frameIndex, const SceneData &data) {
@@ -172,4 +308,29 @@ void SceneManager::updateMaterial(uint32_t index,
                            sizeof(MaterialMetadata) * index);
 }
 
+void SceneManager::remapTexture(uint32_t from, uint32_t to) {
+  const int oldSlot = static_cast<int>(from);
+  for (uint32_t i = 0; i < m_materials.size(); ++i) {
+    MaterialMetadata material = m_materials[i];
+    bool changed = false;
+    for (int *slot :
+         {&material.baseColorTextureIndex,
+          &material.metallicRoughnessTextureIndex, &material.normalTextureIndex,
+          &material.occlusionTextureIndex, &material.emissiveTextureIndex}) {
+      if (*slot == oldSlot) {
+        *slot = static_cast<int>(to);
+        changed = true;
+      }
+    }
+    if (changed) {
+      updateMaterial(i, material);
+    }
+  }
+
+  for (const auto &model : m_models) {
+    std::replace(model->textureIndices.begin(), model->textureIndices.end(),
+                 from, to);
+  }
+}
+
 } // namespace astral
@@ -0,0 +1,71 @@
+#include "astral/renderer/texture_cache.hpp"
+#include "astral/core/hash.hpp"
+#include "astral/renderer/descriptor_manager.hpp"
+#include <iterator>
+
+namespace astral {
+
+CachedImage::~CachedImage() {
+    if (!context) {
+        return; // Never registered, so no frame can have sampled it
+    }
+    // The slots are recycled only once frames in flight are done with them,
+    // and the image has to live exactly as long
+    auto& descriptors = context->getDescriptorManager();
+    for (const auto& [sampler, index] : bindlessIndices) {
+        descriptors.unregisterImage(index);
+    }
+    descriptors.retire(std::shared_ptr<Image>(std::move(image)));
+}
+
+TextureCache::TextureCache(Context* context) : m_context(context) {}
+
+uint64_t TextureCache::computeKey(const void* data, size_t size, VkFormat format) {
+    uint64_t key = hashBytes(data, size);
+    key = hashCombine(key, static_cast<uint64_t>(size));
+    return hashCombine(key, static_cast<uint64_t>(format));
+}
+
+std::shared_ptr<CachedImage> TextureCache::find(uint64_t key) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_images.find(key);
+    return it != m_images.end() ? it->second.lock() : nullptr;
+}
+
+std::shared_ptr<CachedImage> TextureCache::insert(uint64_t key, std::unique_ptr<Image> image) {
+    auto entry = std::make_shared<CachedImage>();
+    entry->key = key;
+    entry->image = std::move(image);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Drop entries whose last model has been unloaded
+    for (auto it = m_images.begin(); it != m_images.end();) {
+        it = it->second.expired() ? m_images.erase(it) : std::next(it);
+    }
+    m_images[key] = entry;
+    return entry;
+}
+
+uint32_t TextureCache::getBindlessIndex(CachedImage& entry, VkSampler sampler) {
+    for (const auto& [entrySampler, index] : entry.bindlessIndices) {
+        if (entrySampler == sampler) {
+            return index;
+        }
+    }
+
+    uint32_t index = m_context->getDescriptorManager().registerImage(entry.image->getView(), sampler);
+    entry.bindlessIndices.emplace_back(sampler, index);
+    entry.context = m_context;
+    return index;
+}
+
+size_t TextureCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t live = 0;
+    for (const auto& [key, entry] : m_images) {
+        live += entry.expired() ? 0 : 1;
+    }
+    return live;
+}
+
+} // namespace astral
@@ -0,0 +1,352 @@
+#include "astral/renderer/texture_streamer.hpp"
+#include "astral/core/upload_manager.hpp"
+#include "astral/renderer/descriptor_manager.hpp"
+#include "astral/renderer/scene_manager.hpp"
+#include "astral/renderer/texture_cache.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace astral {
+
+namespace {
+
+float srgbToLinear(float c) {
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float c) {
+    return c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+}
+
+struct SrgbTables {
+    static constexpr size_t ENCODE_SIZE = 4096;
+    std::array<float, 256> decode;
+    std::array<uint8_t, ENCODE_SIZE> encode;
+
+    SrgbTables() {
+        for (size_t i = 0; i < decode.size(); ++i) {
+            decode[i] = srgbToLinear(static_cast<float>(i) / 255.0f);
+        }
+        for (size_t i = 0; i < encode.size(); ++i) {
+            float c = linearToSrgb(static_cast<float>(i) / (ENCODE_SIZE - 1));
+            encode[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+    }
+
+    uint8_t toSrgb(float linear) const {
+        size_t i = static_cast<size_t>(std::clamp(linear, 0.0f, 1.0f) * (ENCODE_SIZE - 1) + 0.5f);
+        return encode[i];
+    }
+};
+
+const SrgbTables& srgbTables() {
+    static const SrgbTables tables;
+    return tables;
+}
+
+void downsample(const uint8_t* src, uint32_t srcWidth, uint32_t srcHeight, uint8_t* dst, uint32_t dstWidth,
+                uint32_t dstHeight, bool srgb) {
+    const SrgbTables& tables = srgbTables();
+    for (uint32_t y = 0; y < dstHeight; ++y) {
+        // Odd source sizes repeat the last row/column
+        const uint32_t y0 = std::min(y * 2, srcHeight - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, srcHeight - 1);
+        for (uint32_t x = 0; x < dstWidth; ++x) {
+            const uint32_t x0 = std::min(x * 2, srcWidth - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, srcWidth - 1);
+            const uint8_t* texels[4] = {
+                src + (static_cast<size_t>(y0) * srcWidth + x0) * 4, src + (static_cast<size_t>(y0) * srcWidth + x1) * 4,
+                src + (static_cast<size_t>(y1) * srcWidth + x0) * 4, src + (static_cast<size_t>(y1) * srcWidth + x1) * 4};
+            uint8_t* out = dst + (static_cast<size_t>(y) * dstWidth + x) * 4;
+
+            for (int c = 0; c < 3; ++c) {
+                if (srgb) {
+                    float sum = 0.0f;
+                    for (const uint8_t* t : texels) {
+                        sum += tables.decode[t[c]];
+                    }
+                    out[c] = tables.toSrgb(sum * 0.25f);
+                } else {
+                    out[c] = static_cast<uint8_t>((texels[0][c] + texels[1][c] + texels[2][c] + texels[3][c] + 2) / 4);
+                }
+            }
+            out[3] = static_cast<uint8_t>((texels[0][3] + texels[1][3] + texels[2][3] + texels[3][3] + 2) / 4);
+        }
+    }
+}
+
+} // namespace
+
+MipChain generateMipChain(const uint8_t* rgba, uint32_t width, uint32_t height, bool srgb) {
+    MipChain chain;
+    size_t total = 0;
+    for (uint32_t w = width, h = height;; w = std::max(w / 2, 1u), h = std::max(h / 2, 1u)) {
+        size_t size = static_cast<size_t>(w) * h * 4;
+        chain.levels.push_back({w, h, total, size});
+        total += size;
+        if (w == 1 && h == 1) {
+            break;
+        }
+    }
+
+    chain.data.resize(total);
+    std::copy(rgba, rgba + chain.levels[0].size, chain.data.begin());
+    for (size_t i = 1; i < chain.levels.size(); ++i) {
+        const MipChain::Level& src = chain.levels[i - 1];
+        const MipChain::Level& dst = chain.levels[i];
+        downsample(chain.data.data() + src.offset, src.width, src.height, chain.data.data() + dst.offset,
+                   dst.width, dst.height, srgb);
+    }
+    return chain;
+}
+
+TextureStreamer::TextureStreamer(Context* context) : m_context(context) {}
+
+TextureStreamer::~TextureStreamer() {
+    // Pending upload callbacks refer to the streamed textures
+    m_context->getUploadManager().waitIdle();
+    for (const auto& retired : m_retiredViews) {
+        vkDestroyImageView(m_context->getDevice(), retired.view, nullptr);
+    }
+    auto& descriptors = m_context->getDescriptorManager();
+    for (const auto& promotion : m_promotions) {
+        for (const auto& [oldIndex, newIndex] : promotion.slots) {
+            descriptors.unregisterImage(oldIndex);
+        }
+        vkDestroyImageView(m_context->getDevice(), promotion.oldView, nullptr);
+    }
+}
+
+VkDeviceSize TextureStreamer::add(const std::shared_ptr<CachedImage>& entry, MipChain mips) {
+    Image& image = *entry->image;
+    const uint32_t levelCount = static_cast<uint32_t>(mips.levels.size());
+    if (levelCount != image.getSpecs().mipLevels) {
+        throw std::runtime_error("Streamed image mip count does not match its mip chain!");
+    }
+
+    uint32_t tailMip = 0;
+    while (tailMip + 1 < levelCount &&
+           std::max(mips.levels[tailMip].width, mips.levels[tailMip].height) > TAIL_SIZE) {
+        tailMip++;
+    }
+
+    const MipChain::Level& first = mips.levels[tailMip];
+    VkDeviceSize size = static_cast<VkDeviceSize>(mips.data.size() - first.offset);
+    m_context->getUploadManager().uploadImageLevels(image, tailMip, levelCount - tailMip,
+                                                    mips.data.data() + first.offset, size);
+
+    // Nothing has sampled the image yet, so the full view can go right away
+    vkDestroyImageView(m_context->getDevice(), image.replaceView(tailMip), nullptr);
+
+    if (tailMip > 0) {
+        auto texture = std::make_unique<StreamedTexture>();
+        texture->entry = entry;
+        texture->residentMip = tailMip;
+        mips.data.resize(first.offset); // Only the levels still to stream
+        mips.data.shrink_to_fit();
+        mips.levels.resize(tailMip);
+        texture->mips = std::move(mips);
+        m_textures.push_back(std::move(texture));
+    }
+    return size;
+}
+
+void TextureStreamer::assignPriorities(const SceneManager& scene, uint32_t frameIndex,
+                                       const glm::vec3& cameraPosition, const glm::mat4& projection,
+                                       float viewportHeight) {
+    // Bindless index -> texture, through the images' registered slots
+    std::unordered_map<uint32_t, StreamedTexture*> bySlot;
+    for (auto& texture : m_textures) {
+        texture->screenSize = 0.0f;
+        if (auto entry = texture->entry.lock()) {
+            for (const auto& [sampler, index] : entry->bindlessIndices) {
+                bySlot[index] = texture.get();
+            }
+        }
+    }
+    if (bySlot.empty()) {
+        return;
+    }
+
+    // Pixels per world unit at distance 1
+    const float pixelScale = std::fabs(projection[1][1]) * viewportHeight * 0.5f;
+    const auto& materials = scene.getMaterials();
+
+    for (const MeshInstance& instance : scene.getMeshInstances(frameIndex)) {
+        if (instance.materialIndex >= materials.size()) {
+            continue;
+        }
+
+        glm::vec3 center = glm::vec3(instance.transform * glm::vec4(instance.sphereCenter, 1.0f));
+        float scale = std::max({glm::length(glm::vec3(instance.transform[0])),
+                                glm::length(glm::vec3(instance.transform[1])),
+                                glm::length(glm::vec3(instance.transform[2]))});
+        float radius = instance.sphereRadius * scale;
+        float distance = glm::distance(center, cameraPosition);
+        // Inside the bounds the object can cover the whole viewport
+        float diameter = distance > radius ? 2.0f * radius * pixelScale / distance : viewportHeight;
+        diameter = std::max(diameter, 1.0f);
+
+        const MaterialMetadata& material = materials[instance.materialIndex];
+        for (int32_t slot : {material.baseColorTextureIndex, material.metallicRoughnessTextureIndex,
+                             material.normalTextureIndex, material.occlusionTextureIndex,
+                             material.emissiveTextureIndex}) {
+            if (slot < 0) {
+                continue;
+            }
+            auto it = bySlot.find(static_cast<uint32_t>(slot));
+            if (it == bySlot.end() || diameter <= it->second->screenSize) {
+                continue;
+            }
+
+            // The texture is assumed to span the object once, so one texel per
+            // pixel needs the level whose size matches the projected diameter
+            StreamedTexture& texture = *it->second;
+            const MipChain::Level& top = texture.mips.levels[0];
+            float ratio = static_cast<float>(std::max(top.width, top.height)) / diameter;
+            texture.screenSize = diameter;
+            texture.wantedMip = ratio > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(ratio))) : 0;
+        }
+    }
+}
+
+void TextureStreamer::makeResident(StreamedTexture& texture, const std::shared_ptr<CachedImage>& entry,
+                                   uint32_t mip) {
+    Image& image = *entry->image;
+    Promotion promotion{entry, image.replaceView(mip), {}};
+    texture.residentMip = mip;
+
+    // Frames in flight may still sample the old slots, so they are never
+    // rewritten; update() moves the scene over to the new ones
+    auto& descriptors = m_context->getDescriptorManager();
+    for (auto& [sampler, index] : entry->bindlessIndices) {
+        uint32_t fresh = descriptors.registerImage(image.getView(), sampler);
+        promotion.slots.emplace_back(index, fresh);
+        index = fresh;
+    }
+    m_promotions.push_back(std::move(promotion));
+    if (mip == 0) {
+        texture.mips = {};
+    }
+}
+
+void TextureStreamer::update(SceneManager& scene, uint32_t frameIndex, const glm::vec3& cameraPosition,
+                             const glm::mat4& projection, float viewportHeight) {
+    m_frame++;
+    m_retiredViews.erase(std::remove_if(m_retiredViews.begin(), m_retiredViews.end(), [this](const RetiredView& r) {
+        // Frames recorded before the view was replaced may still use it
+        if (m_frame - r.frame < MAX_FRAMES_IN_FLIGHT) {
+            return false;
+        }
+        vkDestroyImageView(m_context->getDevice(), r.view, nullptr);
+        return true;
+    }), m_retiredViews.end());
+
+    // Frames recorded from here on use the new slots. The old slots go through
+    // the descriptor manager's deferred free list and the old view is kept
+    // for as long as those frames may still read it.
+    auto& descriptors = m_context->getDescriptorManager();
+    for (Promotion& promotion : m_promotions) {
+        for (const auto& [oldIndex, newIndex] : promotion.slots) {
+            scene.remapTexture(oldIndex, newIndex);
+            descriptors.unregisterImage(oldIndex);
+        }
+        m_retiredViews.push_back({promotion.oldView, std::move(promotion.entry), m_frame});
+    }
+    m_promotions.clear();
+
+    // Fully resident textures and those whose models were unloaded are done
+    m_textures.erase(std::remove_if(m_textures.begin(), m_textures.end(), [](const std::unique_ptr<StreamedTexture>& t) {
+        return !t->uploading && (t->residentMip == 0 || t->entry.expired());
+    }), m_textures.end());
+    if (m_textures.empty()) {
+        return;
+    }
+
+    assignPriorities(scene, frameIndex, cameraPosition, projection, viewportHeight);
+
+    // Visible textures short of their wanted level first, largest deficit and
+    // then largest on screen; everything else coarsest first
+    std::vector<StreamedTexture*> order;
+    for (auto& texture : m_textures) {
+        if (!texture->uploading) {
+            order.push_back(texture.get());
+        }
+    }
+    auto deficit = [](const StreamedTexture* t) {
+        return t->screenSize > 0.0f && t->residentMip > t->wantedMip ? t->residentMip - t->wantedMip : 0u;
+    };
+    std::sort(order.begin(), order.end(), [&deficit](const StreamedTexture* a, const StreamedTexture* b) {
+        uint32_t da = deficit(a), db = deficit(b);
+        if (da != db) {
+            return da > db;
+        }
+        if (a->screenSize != b->screenSize) {
+            return a->screenSize > b->screenSize;
+        }
+        return a->residentMip > b->residentMip;
+    });
+
+    auto& uploads = m_context->getUploadManager();
+    struct Streamed {
+        StreamedTexture* texture;
+        std::shared_ptr<CachedImage> entry; // Keeps the image alive until the upload completes
+        uint32_t mip;
+    };
+    std::vector<Streamed> streamed;
+    VkDeviceSize staged = 0;
+
+    for (StreamedTexture* texture : order) {
+        if (staged >= m_uploadBudget) {
+            break;
+        }
+        auto entry = texture->entry.lock();
+        if (!entry) {
+            continue;
+        }
+
+        // Background textures advance one level per update
+        uint32_t target = deficit(texture) > 0 ? texture->wantedMip : texture->residentMip - 1;
+
+        // Finer levels are only taken while they fit; the budget is exceeded
+        // only by the first level of the update
+        uint32_t first = texture->residentMip;
+        VkDeviceSize size = 0;
+        while (first > target) {
+            VkDeviceSize levelSize = texture->mips.levels[first - 1].size;
+            if (staged + size > 0 && staged + size + levelSize > m_uploadBudget) {
+                break;
+            }
+            size += levelSize;
+            first--;
+        }
+        if (first == texture->residentMip) {
+            continue;
+        }
+
+        // Levels are packed finest first, so [first, residentMip) is contiguous
+        uploads.uploadImageLevels(*entry->image, first, texture->residentMip - first,
+                                  texture->mips.data.data() + texture->mips.levels[first].offset, size);
+        texture->uploading = true;
+        streamed.push_back({texture, std::move(entry), first});
+        staged += size;
+    }
+
+    if (streamed.empty()) {
+        return;
+    }
+
+    spdlog::debug("Streaming {} texture(s), {} KiB", streamed.size(), staged / 1024);
+    uploads.submit([this, streamed = std::move(streamed)]() {
+        for (const Streamed& s : streamed) {
+            s.texture->uploading = false;
+            makeResident(*s.texture, s.entry, s.mip);
+        }
+    });
+}
+
+} // namespace astral
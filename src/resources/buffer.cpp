@@ -11,6 +11,11 @@ Buffer::Buffer(Context* context, VkDeviceSize size, VkBufferUsageFlags usage, Vm
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = size;
     bufferInfo.usage = usage;
+    // Storage buffers are addressable: shaders reach them through pointers,
+    // and descriptor buffers write their descriptors from the address
+    if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT) {
+        bufferInfo.usage |= VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    }
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     VmaAllocationCreateInfo allocInfo = {};
@@ -20,6 +25,12 @@ Buffer::Buffer(Context* context, VkDeviceSize size, VkBufferUsageFlags usage, Vm
     if (vmaCreateBuffer(m_context->getAllocator(), &bufferInfo, &allocInfo, &m_buffer, &m_allocation, nullptr) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create buffer!");
     }
+
+    if (bufferInfo.usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+        VkBufferDeviceAddressInfo addressInfo = {VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO};
+        addressInfo.buffer = m_buffer;
+        m_deviceAddress = vkGetBufferDeviceAddress(m_context->getDevice(), &addressInfo);
+    }
 }
 
 Buffer::~Buffer() {
@@ -0,0 +1,323 @@
+#include "astral/resources/hdr_decoder.hpp"
+#include "astral/core/thread_pool.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace astral {
+
+namespace {
+
+// Rows per decode chunk; two chunks of RGBE are in flight at a time
+constexpr uint32_t HDR_CHUNK_ROWS = 64;
+
+// Largest shared exponent value: (2^9 - 1) / 2^9 * 2^16
+constexpr float E5B9G9R9_MAX = 65408.0f;
+
+// Reads one header line without its newline. Returns false at end of data.
+bool readLine(const uint8_t*& cursor, const uint8_t* end, std::string_view& line) {
+    if (cursor == end) {
+        return false;
+    }
+    const uint8_t* newline = std::find(cursor, end, '\n');
+    line = std::string_view(reinterpret_cast<const char*>(cursor), static_cast<size_t>(newline - cursor));
+    cursor = newline == end ? end : newline + 1;
+    return true;
+}
+
+// One scanline of RGBE texels: either new-style RLE (each channel as runs)
+// or flat texels with the old (1, 1, 1, n) repeat encoding
+bool decodeScanline(const uint8_t*& cursor, const uint8_t* end, uint32_t width, uint8_t* rgbe) {
+    const bool newRle = width >= 8 && width < 0x8000 && end - cursor >= 4 && cursor[0] == 2 && cursor[1] == 2 &&
+                        !(cursor[2] & 0x80);
+    if (newRle) {
+        if (((static_cast<uint32_t>(cursor[2]) << 8) | cursor[3]) != width) {
+            return false;
+        }
+        cursor += 4;
+        for (uint32_t c = 0; c < 4; ++c) {
+            for (uint32_t x = 0; x < width;) {
+                if (cursor == end) {
+                    return false;
+                }
+                uint32_t count = *cursor++;
+                if (count > 128) {
+                    count -= 128;
+                    if (count > width - x || cursor == end) {
+                        return false;
+                    }
+                    const uint8_t value = *cursor++;
+                    for (; count > 0; --count, ++x) {
+                        rgbe[x * 4 + c] = value;
+                    }
+                } else {
+                    if (count == 0 || count > width - x || static_cast<size_t>(end - cursor) < count) {
+                        return false;
+                    }
+                    for (; count > 0; --count, ++x) {
+                        rgbe[x * 4 + c] = *cursor++;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+
+    uint32_t shift = 0;
+    for (uint32_t x = 0; x < width;) {
+        if (end - cursor < 4) {
+            return false;
+        }
+        if (cursor[0] == 1 && cursor[1] == 1 && cursor[2] == 1) {
+            // Consecutive repeat records form one count, low byte first
+            const size_t count = static_cast<size_t>(cursor[3]) << shift;
+            if (x == 0 || shift > 16 || count > width - x) {
+                return false;
+            }
+            for (size_t i = 0; i < count; ++i, ++x) {
+                std::memcpy(rgbe + x * 4, rgbe + (x - 1) * 4, 4);
+            }
+            shift += 8;
+        } else {
+            std::memcpy(rgbe + x * 4, cursor, 4);
+            ++x;
+            shift = 0;
+        }
+        cursor += 4;
+    }
+    return true;
+}
+
+// Shared exponent encoding as in the Vulkan spec, for values outside the
+// range of the direct RGBE repack
+uint32_t packE5B9G9R9(float r, float g, float b) {
+    constexpr int MANTISSA_BITS = 9;
+    constexpr int EXPONENT_BIAS = 15;
+
+    // NaN and negatives become 0
+    auto clampChannel = [](float v) { return v > 0.0f ? std::min(v, E5B9G9R9_MAX) : 0.0f; };
+    r = clampChannel(r);
+    g = clampChannel(g);
+    b = clampChannel(b);
+
+    const float maxChannel = std::max({r, g, b});
+    if (maxChannel == 0.0f) {
+        return 0;
+    }
+    int floorLog2;
+    std::frexp(maxChannel, &floorLog2);
+    int exponent = std::max(-EXPONENT_BIAS - 1, floorLog2 - 1) + 1 + EXPONENT_BIAS;
+    if (std::floor(maxChannel / std::ldexp(1.0f, exponent - EXPONENT_BIAS - MANTISSA_BITS) + 0.5f) ==
+        static_cast<float>(1 << MANTISSA_BITS)) {
+        ++exponent;
+    }
+
+    const float scale = std::ldexp(1.0f, exponent - EXPONENT_BIAS - MANTISSA_BITS);
+    auto mantissa = [scale](float v) { return static_cast<uint32_t>(std::floor(v / scale + 0.5f)); };
+    return mantissa(r) | mantissa(g) << 9 | mantissa(b) << 18 | static_cast<uint32_t>(exponent) << 27;
+}
+
+// RGBE is m * 2^(e - 136) (the stb_image convention). That equals
+// (2m) * 2^(e5 - 24) with e5 = e - 113, so in-range exponents repack
+// without touching floats.
+uint32_t rgbeToE5B9G9R9(const uint8_t* rgbe) {
+    const int e = rgbe[3];
+    if (e == 0) {
+        return 0;
+    }
+    int e5 = e - 113;
+    if (e5 > 31) {
+        const float scale = std::ldexp(1.0f, e - 136);
+        return packE5B9G9R9(rgbe[0] * scale, rgbe[1] * scale, rgbe[2] * scale);
+    }
+    uint32_t r = static_cast<uint32_t>(rgbe[0]) << 1;
+    uint32_t g = static_cast<uint32_t>(rgbe[1]) << 1;
+    uint32_t b = static_cast<uint32_t>(rgbe[2]) << 1;
+    if (e5 < 0) {
+        // Below the smallest exponent the mantissas shift out
+        const int shift = std::min(-e5, 10);
+        r >>= shift;
+        g >>= shift;
+        b >>= shift;
+        e5 = 0;
+    }
+    return r | g << 9 | b << 18 | static_cast<uint32_t>(e5) << 27;
+}
+
+void convertRgbeRow(const uint8_t* rgbe, uint32_t width, VkFormat format, uint8_t* output) {
+    if (format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32) {
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint32_t texel = rgbeToE5B9G9R9(rgbe + x * 4);
+            std::memcpy(output + x * 4, &texel, 4);
+        }
+    } else {
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint8_t* p = rgbe + x * 4;
+            const float scale = p[3] == 0 ? 0.0f : std::ldexp(1.0f, p[3] - 136);
+            const uint64_t texel = glm::packHalf4x16(glm::vec4(p[0] * scale, p[1] * scale, p[2] * scale, 1.0f));
+            std::memcpy(output + x * 8, &texel, 8);
+        }
+    }
+}
+
+void checkFormat(VkFormat format) {
+    if (getHdrTexelSize(format) == 0) {
+        throw std::runtime_error("Unsupported HDR output format!");
+    }
+}
+
+} // namespace
+
+bool readHdrInfo(const void* data, size_t size, HdrInfo& info) {
+    const auto* begin = static_cast<const uint8_t*>(data);
+    const uint8_t* cursor = begin;
+    const uint8_t* end = begin + size;
+
+    std::string_view line;
+    if (!readLine(cursor, end, line) || (line.rfind("#?RADIANCE", 0) != 0 && line.rfind("#?RGBE", 0) != 0)) {
+        return false;
+    }
+    // Header variables up to an empty line; only the pixel format matters
+    while (true) {
+        if (!readLine(cursor, end, line)) {
+            return false;
+        }
+        if (line.empty()) {
+            break;
+        }
+        if (line.rfind("FORMAT=", 0) == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+            return false;
+        }
+    }
+
+    if (!readLine(cursor, end, line)) {
+        return false;
+    }
+    unsigned height = 0;
+    unsigned width = 0;
+    if (std::sscanf(std::string(line).c_str(), "-Y %u +X %u", &height, &width) != 2 || width == 0 ||
+        height == 0) {
+        return false;
+    }
+
+    info.width = width;
+    info.height = height;
+    info.dataOffset = static_cast<size_t>(cursor - begin);
+    return true;
+}
+
+size_t getHdrTexelSize(VkFormat format) {
+    switch (format) {
+    case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+        return 4;
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+        return 8;
+    default:
+        return 0;
+    }
+}
+
+bool decodeHdr(const void* data, size_t size, const HdrInfo& info, VkFormat format, bool flipVertically,
+               void* output, ThreadPool* pool) {
+    checkFormat(format);
+    const auto* begin = static_cast<const uint8_t*>(data);
+    const uint8_t* cursor = begin + info.dataOffset;
+    const uint8_t* end = begin + size;
+    const size_t rowSize = static_cast<size_t>(info.width) * getHdrTexelSize(format);
+    const size_t chunkSize = static_cast<size_t>(info.width) * 4 * HDR_CHUNK_ROWS;
+    auto* outputBytes = static_cast<uint8_t*>(output);
+
+    std::vector<uint8_t> chunks[2] = {std::vector<uint8_t>(chunkSize), std::vector<uint8_t>(chunkSize)};
+    auto decodeChunk = [&](uint32_t chunk) {
+        const uint32_t firstRow = chunk * HDR_CHUNK_ROWS;
+        const uint32_t rowCount = std::min(HDR_CHUNK_ROWS, info.height - firstRow);
+        uint8_t* rgbe = chunks[chunk % 2].data();
+        for (uint32_t r = 0; r < rowCount; ++r) {
+            if (!decodeScanline(cursor, end, info.width, rgbe + static_cast<size_t>(r) * info.width * 4)) {
+                return false;
+            }
+        }
+        return true;
+    };
+    auto convertChunk = [&](uint32_t chunk) {
+        const uint32_t firstRow = chunk * HDR_CHUNK_ROWS;
+        const uint32_t rowCount = std::min(HDR_CHUNK_ROWS, info.height - firstRow);
+        const uint8_t* rgbe = chunks[chunk % 2].data();
+        for (uint32_t r = 0; r < rowCount; ++r) {
+            const uint32_t row = firstRow + r;
+            const uint32_t target = flipVertically ? info.height - 1 - row : row;
+            convertRgbeRow(rgbe + static_cast<size_t>(r) * info.width * 4, info.width, format,
+                           outputBytes + target * rowSize);
+        }
+    };
+
+    // Step k decodes chunk k while chunk k - 1 is converted. parallelFor
+    // lets the caller run both halves itself when no worker is free, so
+    // this is safe from inside a pool task.
+    const uint32_t chunkCount = (info.height + HDR_CHUNK_ROWS - 1) / HDR_CHUNK_ROWS;
+    for (uint32_t step = 0; step <= chunkCount; ++step) {
+        bool decoded = true;
+        auto body = [&](size_t half) {
+            if (half == 0 && step < chunkCount) {
+                decoded = decodeChunk(step);
+            } else if (half == 1 && step > 0) {
+                convertChunk(step - 1);
+            }
+        };
+        if (pool) {
+            pool->parallelFor(2, body);
+        } else {
+            body(0);
+            body(1);
+        }
+        if (!decoded) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void convertFloatRgba(const float* rgba, uint32_t width, uint32_t height, VkFormat format, bool flipVertically,
+                      void* output, ThreadPool* pool) {
+    checkFormat(format);
+    const size_t texelSize = getHdrTexelSize(format);
+    auto* outputBytes = static_cast<uint8_t*>(output);
+
+    auto convertChunk = [&](size_t chunk) {
+        const uint32_t firstRow = static_cast<uint32_t>(chunk) * HDR_CHUNK_ROWS;
+        const uint32_t lastRow = std::min(firstRow + HDR_CHUNK_ROWS, height);
+        for (uint32_t row = firstRow; row < lastRow; ++row) {
+            const float* source = rgba + static_cast<size_t>(row) * width * 4;
+            const uint32_t target = flipVertically ? height - 1 - row : row;
+            uint8_t* destination = outputBytes + static_cast<size_t>(target) * width * texelSize;
+            for (uint32_t x = 0; x < width; ++x) {
+                const float* p = source + x * 4;
+                if (format == VK_FORMAT_E5B9G9R9_UFLOAT_PACK32) {
+                    const uint32_t texel = packE5B9G9R9(p[0], p[1], p[2]);
+                    std::memcpy(destination + x * texelSize, &texel, 4);
+                } else {
+                    const uint64_t texel = glm::packHalf4x16(glm::vec4(p[0], p[1], p[2], p[3]));
+                    std::memcpy(destination + x * texelSize, &texel, 8);
+                }
+            }
+        }
+    };
+
+    const size_t chunkCount = (height + HDR_CHUNK_ROWS - 1) / HDR_CHUNK_ROWS;
+    if (pool) {
+        pool->parallelFor(chunkCount, convertChunk);
+    } else {
+        for (size_t i = 0; i < chunkCount; ++i) {
+            convertChunk(i);
+        }
+    }
+}
+
+} // namespace astral
@@ -119,15 +119,21 @@ void Image::upload(const void* data, VkDeviceSize size) {
     vkQueueWaitIdle(m_context->getGraphicsQueue());
 }
 
-void Image::createView() {
+VkImageView Image::replaceView(uint32_t baseMipLevel) {
+    VkImageView previous = m_view;
+    createView(baseMipLevel);
+    return previous;
+}
+
+void Image::createView(uint32_t baseMipLevel) {
     VkImageViewCreateInfo viewInfo = {};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image = m_image;
     viewInfo.viewType = m_specs.viewType;
     viewInfo.format = m_specs.format;
     viewInfo.subresourceRange.aspectMask = m_specs.aspectFlags;
-    viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = m_specs.mipLevels;
+    viewInfo.subresourceRange.baseMipLevel = baseMipLevel;
+    viewInfo.subresourceRange.levelCount = m_specs.mipLevels - baseMipLevel;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = m_specs.arrayLayers;
 
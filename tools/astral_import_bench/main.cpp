@@ -0,0 +1,192 @@
+// astral_import_bench: headless glTF import throughput benchmark.
+//
+//   astral_import_bench <model file or directory> [options]
+//     --iterations N   Import every model N times (default 3)
+//     --threads N      Worker threads for primitive processing (default: hardware - 1)
+//     --cache DIR      Use a mesh cache; the first iteration writes it, later ones read it
+//     --packed         Import with VertexFormat::Packed
+//     --no-optimize    Skip vertex cache / overdraw / fetch optimization
+//     --no-lods        Only keep LOD 0
+//     --no-meshlets    Skip meshlet generation
+//
+// Runs the full CPU side of GltfLoader (no Vulkan device is created) and
+// reports per-stage timings, throughput and peak memory. Exits with a
+// failure code if any model fails to import.
+
+#include "astral/core/thread_pool.hpp"
+#include "astral/renderer/gltf_loader.hpp"
+#include <spdlog/spdlog.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+// Peak resident set size of the process in bytes
+uint64_t peakMemoryBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters = {};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage = {};
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss); // Bytes on macOS
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // Kilobytes on Linux
+#endif
+#endif
+}
+
+bool isModelFile(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".gltf" || extension == ".glb";
+}
+
+void accumulate(astral::GltfImportStats& total, const astral::GltfImportStats& stats) {
+    total.parseMs += stats.parseMs;
+    total.imageDecodeMs += stats.imageDecodeMs;
+    total.geometryMs += stats.geometryMs;
+    total.attributesMs += stats.attributesMs;
+    total.optimizeMs += stats.optimizeMs;
+    total.meshletMs += stats.meshletMs;
+    total.lodMs += stats.lodMs;
+    total.cacheMs += stats.cacheMs;
+    total.packMs += stats.packMs;
+    total.totalMs += stats.totalMs;
+    total.sourceBytes += stats.sourceBytes;
+    total.imageCount += stats.imageCount;
+    total.primitiveCount += stats.primitiveCount;
+    total.vertexCount += stats.vertexCount;
+    total.indexCount += stats.indexCount;
+    total.meshletCount += stats.meshletCount;
+}
+
+double megabytesPerSecond(uint64_t bytes, double ms) {
+    return ms > 0.0 ? (static_cast<double>(bytes) / (1024.0 * 1024.0)) / (ms / 1000.0) : 0.0;
+}
+
+void printStats(const char* label, const astral::GltfImportStats& stats) {
+    std::printf("%-32s %9.2f %8.2f %8.2f %9.2f %8.2f %8.2f %8.2f %8.2f %7.2f %9.2f %9.1f\n", label, stats.totalMs,
+                stats.parseMs, stats.imageDecodeMs, stats.geometryMs, stats.attributesMs, stats.optimizeMs,
+                stats.lodMs, stats.meshletMs, stats.cacheMs, stats.packMs,
+                megabytesPerSecond(stats.sourceBytes, stats.totalMs));
+}
+
+int usage() {
+    std::fprintf(stderr, "Usage: astral_import_bench <model file or directory> [--iterations N] [--threads N] "
+                         "[--cache DIR] [--packed] [--no-optimize] [--no-lods] [--no-meshlets]\n");
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        return usage();
+    }
+
+    std::filesystem::path input = argv[1];
+    uint32_t iterations = 3;
+    uint32_t threadCount = 0;
+    astral::GltfLoadOptions options;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threadCount = static_cast<uint32_t>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--cache" && i + 1 < argc) {
+            options.meshCacheDirectory = argv[++i];
+        } else if (arg == "--packed") {
+            options.vertexFormat = astral::VertexFormat::Packed;
+        } else if (arg == "--no-optimize") {
+            options.optimizeMeshes = false;
+        } else if (arg == "--no-lods") {
+            options.lodCount = 1;
+        } else if (arg == "--no-meshlets") {
+            options.buildMeshlets = false;
+        } else {
+            return usage();
+        }
+    }
+
+    std::vector<std::filesystem::path> models;
+    if (std::filesystem::is_directory(input)) {
+        for (const auto& item : std::filesystem::recursive_directory_iterator(input)) {
+            if (item.is_regular_file() && isModelFile(item.path())) {
+                models.push_back(item.path());
+            }
+        }
+        std::sort(models.begin(), models.end());
+    } else {
+        models.push_back(input);
+    }
+    if (models.empty()) {
+        std::fprintf(stderr, "No .gltf/.glb files found in %s\n", input.string().c_str());
+        return EXIT_FAILURE;
+    }
+
+    // Per-model log lines would dominate the measurement
+    spdlog::set_level(spdlog::level::warn);
+    astral::ThreadPool pool(threadCount);
+
+    std::printf("%zu models, %u iterations, %u worker threads%s\n\n", models.size(), iterations,
+                pool.getThreadCount(), options.meshCacheDirectory.empty() ? "" : ", mesh cache enabled");
+    std::printf("%-32s %9s %8s %8s %9s %8s %8s %8s %8s %7s %9s %9s\n", "model / iteration (ms)", "total", "parse",
+                "images", "geometry", "attribs", "optimize", "lods", "meshlet", "cache", "pack", "MB/s");
+
+    bool failed = false;
+    astral::GltfImportStats overall;
+    for (const auto& model : models) {
+        astral::GltfImportStats best;
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            astral::GltfImportStats stats;
+            if (!astral::importGltfHeadless(model, options, &pool, &stats)) {
+                std::fprintf(stderr, "FAILED: %s\n", model.string().c_str());
+                failed = true;
+                break;
+            }
+
+            std::string label = model.filename().string() + " #" + std::to_string(iteration) +
+                                (stats.cacheHit ? " (cached)" : "");
+            printStats(label.c_str(), stats);
+            accumulate(overall, stats);
+            if (iteration == 0 || stats.totalMs < best.totalMs) {
+                best = stats;
+            }
+        }
+        if (best.totalMs > 0.0) {
+            std::printf("    %u primitives, %u vertices, %u indices, %u meshlets, %u images, %.2f MB source, "
+                        "best %.2f ms\n",
+                        best.primitiveCount, best.vertexCount, best.indexCount, best.meshletCount, best.imageCount,
+                        static_cast<double>(best.sourceBytes) / (1024.0 * 1024.0), best.totalMs);
+        }
+    }
+
+    std::printf("\n");
+    printStats("all imports", overall);
+    std::printf("Peak memory: %.1f MB\n", static_cast<double>(peakMemoryBytes()) / (1024.0 * 1024.0));
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
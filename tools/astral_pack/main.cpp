@@ -0,0 +1,144 @@
+// astral_pack: packs a directory tree into an asset archive.
+//
+//   astral_pack <input directory> <output archive> [--align N] [--store]
+//
+// GLSL shaders (.vert, .frag, .comp) are compiled to SPIR-V and stored
+// under their source path; Shader takes SPIR-V as-is, so the runtime skips
+// compiling them. Shaders, glTF JSON and buffers and uncompressed images are
+// LZ4 compressed. Images that are already compressed (PNG, JPEG, KTX2, ...)
+// are stored as-is. Paths in the archive are relative to the input
+// directory.
+
+#include "astral/core/asset_archive.hpp"
+#include "astral/core/thread_pool.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <shaderc/shaderc.hpp>
+
+namespace {
+
+// Recompressing these gains nothing
+const std::unordered_set<std::string> PRECOMPRESSED_EXTENSIONS = {
+    ".png", ".jpg", ".jpeg", ".ktx2", ".basis", ".webp", ".dds", ".zip", ".pak"
+};
+
+const std::unordered_map<std::string, shaderc_shader_kind> SHADER_KINDS = {
+    {".vert", shaderc_glsl_vertex_shader},
+    {".frag", shaderc_glsl_fragment_shader},
+    {".comp", shaderc_glsl_compute_shader}
+};
+
+std::string lowerExtension(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension;
+}
+
+std::vector<std::byte> readFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Failed to open " + path.string());
+    }
+    std::vector<std::byte> data(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to read " + path.string());
+    }
+    return data;
+}
+
+// Same target and options as Shader::compile, so packed and loose shaders
+// produce the same modules
+std::vector<std::byte> compileShader(const std::filesystem::path& path, const std::vector<std::byte>& source,
+                                     shaderc_shader_kind kind) {
+    shaderc::Compiler compiler;
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+    options.SetOptimizationLevel(shaderc_optimization_level_zero);
+
+    std::string text(reinterpret_cast<const char*>(source.data()), source.size());
+    shaderc::SpvCompilationResult result =
+        compiler.CompileGlslToSpv(text, kind, path.generic_string().c_str(), options);
+    if (result.GetCompilationStatus() != shaderc_compilation_status_success) {
+        throw std::runtime_error("Failed to compile " + path.string() + ":\n" + result.GetErrorMessage());
+    }
+
+    std::vector<std::byte> spirv(static_cast<size_t>(result.cend() - result.cbegin()) * sizeof(uint32_t));
+    std::memcpy(spirv.data(), result.cbegin(), spirv.size());
+    return spirv;
+}
+
+int usage() {
+    std::cerr << "Usage: astral_pack <input directory> <output archive> [--align N] [--store]\n";
+    return EXIT_FAILURE;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        return usage();
+    }
+
+    std::filesystem::path input = argv[1];
+    std::filesystem::path output = argv[2];
+    uint32_t alignment = 16;
+    bool store = false;
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--align" && i + 1 < argc) {
+            alignment = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--store") {
+            store = true;
+        } else {
+            return usage();
+        }
+    }
+
+    try {
+        auto start = std::chrono::steady_clock::now();
+        astral::AssetArchiveWriter writer(alignment);
+        uint64_t inputBytes = 0;
+
+        const auto absoluteOutput = std::filesystem::absolute(output).lexically_normal();
+        for (const auto& item : std::filesystem::recursive_directory_iterator(input)) {
+            if (!item.is_regular_file() ||
+                std::filesystem::absolute(item.path()).lexically_normal() == absoluteOutput) {
+                continue;
+            }
+
+            const std::string extension = lowerExtension(item.path());
+            bool compress = !store && !PRECOMPRESSED_EXTENSIONS.count(extension);
+            auto data = readFile(item.path());
+            inputBytes += data.size();
+            if (auto kind = SHADER_KINDS.find(extension); kind != SHADER_KINDS.end()) {
+                data = compileShader(item.path(), data, kind->second);
+            }
+            writer.add(std::filesystem::relative(item.path(), input).generic_string(), std::move(data),
+                       compress ? astral::ArchiveCompression::LZ4 : astral::ArchiveCompression::None);
+        }
+
+        const size_t entryCount = writer.size();
+        astral::ThreadPool pool;
+        writer.write(output, &pool);
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Packed " << entryCount << " files, " << inputBytes << " -> "
+                  << std::filesystem::file_size(output) << " bytes in " << elapsed << " s: " << output.string()
+                  << "\n";
+    } catch (const std::exception& e) {
+        std::cerr << "astral_pack: " << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}